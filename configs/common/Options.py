@@ -791,18 +791,156 @@ def addSEOptions(parser):
         default=20,
         help = "outstanding ability of chimera framework"
     )
+    parser.add_argument(
+        "--chimera-batch-size",
+        type = int,
+        default=1,
+        help = "max tasks chimera coalesces into one PCIe transfer "
+        "(1 disables batching)"
+    )
+    parser.add_argument(
+        "--chimera-channels",
+        type = int,
+        default=1,
+        help = "DMA channels chimera stripes the devices across (1-4); the "
+        "tasks of one device keep to one channel"
+    )
+    parser.add_argument(
+        "--chimera-dma-depth",
+        type = int,
+        default=1,
+        help = "PCIe writes chimera keeps in flight per channel, queued "
+        "through io_uring when more than 1 (xdma transport)"
+    )
+    parser.add_argument(
+        "--chimera-completion",
+        default="poll",
+        choices=["poll", "adaptive", "interrupt"],
+        help="how chimera waits for results: poll the response window "
+        "flat out, back off while the card is idle, or block on the card's "
+        "completion interrupt"
+    )
+    parser.add_argument(
+        "--chimera-cpus",
+        default="auto",
+        help="CPUs the chimera worker threads and the gem5 main thread run "
+        "on: a CPU list such as 4-7, with a CPU for each of the main, aux, "
+        "submit and collect threads, auto for the CPUs on the card's NUMA "
+        "node, or an empty string to leave them to the scheduler"
+    )
+    parser.add_argument(
+        "--chimera-rt-priority",
+        type = int,
+        default=0,
+        help = "SCHED_FIFO priority of the chimera worker threads (0: off)"
+    )
+    parser.add_argument(
+        "--chimera-bulk",
+        type = int,
+        default=0,
+        help = "KiB of pinned memory chimera streams the data plane through "
+        "in bulk transfers of up to 1 MiB, past its task table (0: off, "
+        "64-byte data tasks)"
+    )
+    parser.add_argument(
+        "--chimera-transport",
+        default="xdma",
+        choices=["xdma", "emulated", "verilator"],
+        help="backend of chimera: a real board through XDMA, an emulated "
+        "card, or the Verilated MPEG2 model"
+    )
+    parser.add_argument(
+        "--chimera-replay",
+        default="off",
+        choices=["off", "record", "replay"],
+        help="record the inputs and results of the chimera card to a "
+        "response log, or serve the results from one"
+    )
+    parser.add_argument(
+        "--chimera-replay-dir",
+        default=".",
+        help="directory of the chimera response logs"
+    )
+    parser.add_argument(
+        "--chimera-replay-session",
+        default="",
+        help="names what a response log is valid for, e.g. the bitstream "
+        "and the workload; logs are keyed by its hash"
+    )
+    parser.add_argument(
+        "--chimera-trace",
+        default="",
+        help="write the life of every chimera task to this file as a "
+        "Chrome trace, to open in Perfetto"
+    )
+    parser.add_argument(
+        "--rtl-clock-ratio",
+        type = int,
+        default=1,
+        help = "device clock cycles per clock cycle of the Verilator model"
+    )
+    parser.add_argument(
+        "--rtl-cycles-per-event",
+        type = int,
+        default=1,
+        help = "RTL cycles the Verilator model evaluates per simulator event"
+    )
+    parser.add_argument(
+        "--rtl-thread",
+        default=False,
+        action="store_true",
+        help="run the Verilator model on its own thread, a quantum ahead "
+        "of the simulation"
+    )
+    parser.add_argument(
+        "--rtl-quantum",
+        type = int,
+        default=1000,
+        help = "RTL cycles between synchronisations with the RTL thread"
+    )
     parser.add_argument(
         "--enable-dump-wave",
         default=False,
         action="store_true",
         help="enable verilator to dump wave"
     )
+    parser.add_argument(
+        "--wave-window",
+        action="append",
+        default=[],
+        help="RTL cycle window start:end of the wave to capture; may be "
+        "given more than once"
+    )
+    parser.add_argument(
+        "--wave-trigger",
+        default="",
+        help="port signal condition (signal or signal=value) that starts "
+        "a wave capture"
+    )
+    parser.add_argument(
+        "--wave-pre-trigger",
+        type=int,
+        default=0,
+        help="RTL cycles of wave kept from before each capture"
+    )
+    parser.add_argument(
+        "--wave-work-item",
+        type=int,
+        default=-1,
+        help="capture the wave while the m5 work item with this ID runs"
+    )
     parser.add_argument(
         "--disable-chimera-dataPlane-opt",
         default=True,
         action="store_false",
         help="enable verilator to dump wave"
     )
+    parser.add_argument(
+        "--disable-write-combine",
+        action="store_true",
+        help="send every store to the mpeg2 data plane on its own instead "
+        "of merging them into line-sized writes in the CPUs"
+    )
 
 
 def addFSOptions(parser):
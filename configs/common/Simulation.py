@@ -472,6 +472,8 @@ def run(options, root, testsys, cpu_class):
             switch_cpus[i].progress_interval = \
                 testsys.cpu[i].progress_interval
             switch_cpus[i].isa = testsys.cpu[i].isa
+            switch_cpus[i].write_combine_ranges = \
+                testsys.cpu[i].write_combine_ranges
 
             # simulation period
             if options.maxinsts:
@@ -515,6 +517,8 @@ def run(options, root, testsys, cpu_class):
             repeat_switch_cpus[i].workload = testsys.cpu[i].workload
             repeat_switch_cpus[i].clk_domain = testsys.cpu[i].clk_domain
             repeat_switch_cpus[i].isa = testsys.cpu[i].isa
+            repeat_switch_cpus[i].write_combine_ranges = \
+                testsys.cpu[i].write_combine_ranges
 
             if options.maxinsts:
                 repeat_switch_cpus[i].max_insts_any_thread = options.maxinsts
@@ -545,6 +549,8 @@ def run(options, root, testsys, cpu_class):
             switch_cpus[i].clk_domain = testsys.cpu[i].clk_domain
             switch_cpus_1[i].clk_domain = testsys.cpu[i].clk_domain
             switch_cpus[i].isa = testsys.cpu[i].isa
+            switch_cpus[i].write_combine_ranges = \
+                testsys.cpu[i].write_combine_ranges
             switch_cpus_1[i].isa = testsys.cpu[i].isa
 
             # if restoring, make atomic cpu simulate only a few instructions
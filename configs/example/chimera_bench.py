@@ -0,0 +1,126 @@
+# Drives a Chimera engine with a ChimeraTrafficGen, with no CPU, memory or
+# device model in the way, to measure what the engine and the card behind
+# it sustain. One run is one point; util/chimera/chimera_sweep.py runs a
+# sweep of them and reports throughput and latency percentiles.
+#
+# Example:
+#   build/ARM/gem5.opt -d m5out/bench configs/example/chimera_bench.py \
+#       --chimera-transport=emulated --chimera-table-num=64 \
+#       --chimera-batch-size=8 --payload-size=64 --num-tasks=100000
+
+import argparse
+
+import m5
+from m5.objects import *
+
+parser = argparse.ArgumentParser(
+    formatter_class=argparse.ArgumentDefaultsHelpFormatter
+)
+
+parser.add_argument(
+    "--chimera-transport",
+    default="emulated",
+    choices=["xdma", "emulated", "verilator"],
+    help="backend of chimera",
+)
+parser.add_argument(
+    "--chimera-table-num", type=int, default=64,
+    help="task table entries of chimera",
+)
+parser.add_argument(
+    "--chimera-batch-size", type=int, default=1,
+    help="max tasks chimera coalesces into one PCIe transfer (1: off)",
+)
+parser.add_argument(
+    "--chimera-channels", type=int, default=1,
+    help="DMA channels chimera stripes the devices across (1-4); the one "
+    "generator keeps to one of them",
+)
+parser.add_argument(
+    "--chimera-completion",
+    default="poll",
+    choices=["poll", "adaptive", "interrupt"],
+    help="how chimera waits for results",
+)
+parser.add_argument(
+    "--chimera-cpus", default="auto",
+    help="CPUs the chimera worker threads and the main thread run on",
+)
+parser.add_argument(
+    "--chimera-trace", default="",
+    help="write the life of every task to this file as a Chrome trace",
+)
+
+parser.add_argument(
+    "--num-tasks", type=int, default=100000, help="tasks to send"
+)
+parser.add_argument(
+    "--payload-size", type=int, default=64,
+    help="bytes of a data chunk, a multiple of 8 up to 64",
+)
+parser.add_argument(
+    "--write-percent", type=int, default=0, help="share of control writes"
+)
+parser.add_argument(
+    "--data-percent", type=int, default=100, help="share of data chunks"
+)
+parser.add_argument(
+    "--resp-percent", type=int, default=0,
+    help="share of tasks that ask for a response",
+)
+parser.add_argument(
+    "--stop-percent", type=int, default=0, help="share of stream stops"
+)
+parser.add_argument(
+    "--period", default="0ns",
+    help="time between two tasks (0ns: as soon as a table entry is free)",
+)
+parser.add_argument(
+    "--max-outstanding", type=int, default=0,
+    help="response tasks waiting for their result at once (0: no limit)",
+)
+
+args = parser.parse_args()
+
+system = System()
+system.clk_domain = SrcClockDomain(
+    clock="1GHz", voltage_domain=VoltageDomain()
+)
+system.mem_mode = "timing"
+
+# the emulated IP stays quiet, so results of response tasks are the only
+# thing in the result window
+system.chimera = Chimera(
+    taskTableNum=args.chimera_table_num,
+    batchEnable=args.chimera_batch_size > 1,
+    batchSize=max(args.chimera_batch_size, 1),
+    numChannels=args.chimera_channels,
+    completionMode=args.chimera_completion,
+    submitCpus=args.chimera_cpus,
+    collectCpus=args.chimera_cpus,
+    auxCpus=args.chimera_cpus,
+    mainCpus=args.chimera_cpus,
+    enableCDMA=False,
+    transport=args.chimera_transport,
+    emulatedOutput=False,
+    traceFile=args.chimera_trace,
+)
+
+system.tgen = ChimeraTrafficGen(
+    chimera=system.chimera,
+    num_tasks=args.num_tasks,
+    write_percent=args.write_percent,
+    data_percent=args.data_percent,
+    resp_percent=args.resp_percent,
+    stop_percent=args.stop_percent,
+    payload_size=args.payload_size,
+    min_period=args.period,
+    max_period=args.period,
+    max_outstanding=args.max_outstanding,
+)
+
+root = Root(full_system=False, system=system)
+m5.instantiate()
+
+exit_event = m5.simulate()
+print("Exiting @ tick %i because %s" % (m5.curTick(), exit_event.getCause()))
@@ -282,7 +282,25 @@ else:
         if args.enable_chimera:
             chimera_instance = Chimera(
                 taskTableNum=args.chimera_table_num,
-                enableCDMA=True
+                batchEnable=args.chimera_batch_size > 1,
+                batchSize=max(args.chimera_batch_size, 1),
+                numChannels=args.chimera_channels,
+                dmaQueueDepth=max(args.chimera_dma_depth, 1),
+                xdmaIoUring=args.chimera_dma_depth > 1,
+                completionMode=args.chimera_completion,
+                submitCpus=args.chimera_cpus,
+                collectCpus=args.chimera_cpus,
+                auxCpus=args.chimera_cpus,
+                mainCpus=args.chimera_cpus,
+                workerPriority=args.chimera_rt_priority,
+                enableCDMA=True,
+                transport=args.chimera_transport,
+                traceFile=args.chimera_trace,
+                replayMode=args.chimera_replay,
+                replayDir=args.chimera_replay_dir,
+                replaySession=args.chimera_replay_session,
+                bulkSegments=args.chimera_bulk // 4,
+                dump_wave=args.enable_dump_wave
             )
         else:
             chimera_instance = NULL
@@ -291,10 +309,59 @@ else:
             chimera=chimera_instance,
             enable_verilator=args.enable_verilator,
             dump_wave=args.enable_dump_wave,
-            enable_dataPlane_opt=args.disable_chimera_dataPlane_opt
+            wave_windows=args.wave_window,
+            wave_trigger=args.wave_trigger,
+            wave_pre_trigger=args.wave_pre_trigger,
+            wave_work_item=args.wave_work_item,
+            rtl_clock_ratio=args.rtl_clock_ratio,
+            rtl_cycles_per_event=args.rtl_cycles_per_event,
+            rtl_thread=args.rtl_thread,
+            rtl_quantum=args.rtl_quantum,
+            enable_dataPlane_opt=args.disable_chimera_dataPlane_opt,
+            bulk_data=args.enable_chimera and args.chimera_bulk > 0
         )
         
         system.membus.mem_side_ports = system.mpeg2Encoder.cpu_side_port
+        system.membus.cpu_side_ports = system.mpeg2Encoder.dma
+
+        # the encoder's window is mapped at the same virtual address into
+        # every process: the registers and the output buffer uncacheable and
+        # strictly ordered, the data plane uncacheable and write-combined
+        encoder = system.mpeg2Encoder
+        pio_addr = int(encoder.pio_addr)
+        data_addr = pio_addr + int(encoder.data_offset)
+        out_addr = pio_addr + int(encoder.out_offset)
+        end_addr = pio_addr + int(encoder.pio_size)
+
+        def window(start, end, **kwargs):
+            return DeviceWindow(
+                vaddr=start, paddr=start, size=end - start, **kwargs
+            )
+
+        def encoder_windows():
+            return [
+                window(pio_addr, data_addr),
+                window(
+                    data_addr,
+                    out_addr,
+                    strictly_ordered=False,
+                    write_combine=not args.disable_write_combine,
+                ),
+                window(out_addr, end_addr),
+            ]
+
+        for process in multiprocesses:
+            process.device_windows = encoder_windows()
+
+        # the CPUs merge the stores to write-combined windows into
+        # line-sized writes
+        write_combine_ranges = [
+            AddrRange(int(w.paddr), size=int(w.size))
+            for w in multiprocesses[0].device_windows
+            if w.write_combine
+        ]
+        for cpu in system.cpu:
+            cpu.write_combine_ranges = write_combine_ranges
 
 system.workload = SEWorkload.init_compatible(mp0_path)
 
@@ -28,3 +28,4 @@ from .add_local_rpath import AddLocalRPATH
 from .blob import Blob
 from .config_file import ConfigFile
 from .switching_headers import SwitchingHeaders
+from .verilator import Verilator
@@ -0,0 +1,129 @@
+# Copyright (c) 2026 Fudan University
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are
+# met: redistributions of source code must retain the above copyright
+# notice, this list of conditions and the following disclaimer;
+# redistributions in binary form must reproduce the above copyright
+# notice, this list of conditions and the following disclaimer in the
+# documentation and/or other materials provided with the distribution;
+# neither the name of the copyright holders nor the names of its
+# contributors may be used to endorse or promote products derived from
+# this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+# "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+# LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+# A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+# OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+# SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+# LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+# DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+# THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+import os
+
+from gem5_scons import Transform, MakeAction, error
+from gem5_scons.util import readCommand
+
+# Verilator flags of each build variant. "trace" keeps waveform dumping
+# available, as FST written by a thread of its own; the others drop it and
+# let Verilator optimize freely. A "pgo-gen" model records a
+# thread-scheduling profile when it runs, which a "pgo-use" build feeds
+# back to Verilator.
+fast_flags = ["-O3", "--x-assign", "fast", "--x-initial", "fast"]
+variant_flags = {
+    "trace": ["--trace-fst", "--trace-threads", "1"],
+    "fast": fast_flags,
+    "pgo-gen": fast_flags + ["--prof-pgo"],
+    "pgo-use": fast_flags,
+}
+
+variants = tuple(variant_flags.keys())
+
+
+def verilate(env, mdir, top, sources, flags=[]):
+    """Verilate the RTL in sources, with top as the top module, into the
+    directory mdir and build it with Verilator's own makefiles. The variant,
+    thread count and profile come from the VERILATOR_* build variables.
+
+    Returns the archive of the model, the archive of the Verilator runtime
+    it was built against and the model's header, V<top>.h."""
+
+    conf = env["CONF"]
+    variant = conf["VERILATOR_VARIANT"]
+    threads = int(conf["VERILATOR_THREADS"])
+
+    flags = list(flags) + variant_flags[variant]
+    # the model state goes into gem5 checkpoints, which Verilator only
+    # supports for single-threaded models
+    savable = threads <= 1
+    if savable:
+        flags.append("--savable")
+    else:
+        flags += ["--threads", str(threads)]
+
+    sources = list(sources)
+    if variant == "pgo-use":
+        if not conf["VERILATOR_PROFILE"]:
+            error(
+                "VERILATOR_VARIANT=pgo-use needs the profile.vlt a pgo-gen "
+                "model recorded in VERILATOR_PROFILE."
+            )
+        sources.append(env.File(conf["VERILATOR_PROFILE"]))
+
+    verilator = conf["VERILATOR"]
+    root = conf["VERILATOR_ROOT"]
+    if not root:
+        root = readCommand([verilator, "--getenv", "VERILATOR_ROOT"]).strip()
+
+    mdir = env.Dir(mdir)
+    model = mdir.File(f"V{top}__ALL.a")
+    runtime = mdir.File("libverilated.a")
+    header = mdir.File(f"V{top}.h")
+
+    cmd = " ".join(
+        [
+            verilator,
+            "--cc",
+            "--build",
+            "-j",
+            str(env.GetOption("num_jobs")),
+            "--top-module",
+            top,
+            "--Mdir",
+            "${TARGET.dir.abspath}",
+        ]
+        + flags
+        + ["${SOURCES.abspath}"]
+    )
+    targets = env.Command(
+        [model, runtime, header], sources, MakeAction(cmd, Transform("VERILATE"))
+    )
+    # the generated sources, makefiles and objects live next to the targets
+    env.Clean(targets, mdir)
+
+    env.Append(
+        CPPDEFINES=[
+            ("VM_SC", 0),
+            ("VM_TRACE", int(variant == "trace")),
+            ("VL_THREADED", int(threads > 1)),
+            ("VM_SAVABLE", int(savable)),
+        ]
+    )
+    env.Append(
+        CPPPATH=[
+            mdir,
+            env.Dir(os.path.join(root, "include")),
+            env.Dir(os.path.join(root, "include", "vltstd")),
+        ]
+    )
+
+    return targets
+
+
+def Verilator(env):
+    env.AddMethod(verilate, "Verilate")
@@ -48,6 +48,7 @@
 #include "debug/TLB.hh"
 #include "debug/TLBVerbose.hh"
 #include "mem/packet_access.hh"
+#include "mem/page_table.hh"
 #include "sim/pseudo_inst.hh"
 #include "sim/process.hh"
 
@@ -263,12 +264,14 @@ MMU::translateSe(const RequestPtr &req, ThreadContext *tc, Mode mode,
         }
     }
 
-    Addr paddr;
     Process *p = tc->getProcessPtr();
 
-    if (!p->pTable->translate(vaddr, paddr))
+    const EmulationPageTable::Entry *pte = p->pTable->lookup(vaddr);
+    if (!pte)
         return std::make_shared<GenericPageTableFault>(vaddr_tainted);
-    req->setPaddr(paddr);
+    req->setPaddr(pte->paddr + p->pTable->pageOffset(vaddr));
+    // device windows are uncacheable and may be strictly ordered
+    req->setFlags(EmulationPageTable::requestFlags(pte->flags));
 
     return finalizePhysical(req, tc, mode);
 }
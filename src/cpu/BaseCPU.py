@@ -121,6 +121,12 @@ class BaseCPU(ClockedObject):
 
     syscallRetryLatency = Param.Cycles(10000, "Cycles to wait until retry")
 
+    write_combine_ranges = VectorParam.AddrRange(
+        [],
+        "Physical ranges whose stores are merged into line-sized writes, "
+        "such as the data plane of an accelerator",
+    )
+
     do_checkpoint_insts = Param.Bool(
         True, "enable checkpoint pseudo instructions"
     )
@@ -140,6 +140,7 @@ BaseCPU::BaseCPU(const Params &p, bool is_checker)
       baseStats(this),
       addressMonitor(p.numThreads),
       syscallRetryLatency(p.syscallRetryLatency),
+      writeCombineRanges(p.write_combine_ranges),
       pwrGatingLatency(p.pwr_gating_latency),
       powerGatingOnIdle(p.power_gating_on_idle),
       enterPwrGatingEvent([this]{ enterPwrGating(); }, name())
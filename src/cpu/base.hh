@@ -661,6 +661,25 @@ class BaseCPU : public ClockedObject
 
     Cycles syscallRetryLatency;
 
+  private:
+    std::vector<AddrRange> writeCombineRanges;
+
+  public:
+    /**
+     * Is a store to [paddr, paddr + size) write-combined? Such stores,
+     * meant for uncacheable device windows, may be merged with the stores
+     * next to them into one line-sized write.
+     */
+    bool
+    isWriteCombined(Addr paddr, unsigned size) const
+    {
+        for (const auto &range : writeCombineRanges) {
+            if (range.contains(paddr) && range.contains(paddr + size - 1))
+                return true;
+        }
+        return false;
+    }
+
     /** This function is used to instruct the memory subsystem that a
      * transaction should be aborted and the speculative state should be
      * thrown away.  This is called in the transaction's very last breath in
@@ -41,12 +41,15 @@
 
 #include "cpu/o3/lsq_unit.hh"
 
+#include <algorithm>
+
 #include "arch/generic/debugfaults.hh"
 #include "base/str.hh"
 #include "cpu/checker/cpu.hh"
 #include "cpu/o3/dyn_inst.hh"
 #include "cpu/o3/limits.hh"
 #include "cpu/o3/lsq.hh"
+#include "cpu/utils.hh"
 #include "debug/Activity.hh"
 #include "debug/HtmCpu.hh"
 #include "debug/IEW.hh"
@@ -269,6 +272,9 @@ LSQUnit::LSQUnitStats::LSQUnitStats(statistics::Group *parent)
       ADD_STAT(blockedByCache, statistics::units::Count::get(),
                "Number of times an access to memory failed due to the cache "
                "being blocked"),
+      ADD_STAT(writeCombinedStores, statistics::units::Count::get(),
+               "Number of stores merged into the write of an older store to "
+               "a write-combined range"),
       ADD_STAT(loadToUse, "Distribution of cycle latency between the "
                 "first time a load is issued and its completion")
 {
@@ -844,12 +850,14 @@ LSQUnit::writebackStores()
         storeWBIt->committed() = true;
 
         assert(!inst->memData);
-        inst->memData = new uint8_t[request->_size];
+        if (!writeCombineStores()) {
+            inst->memData = new uint8_t[request->_size];
 
-        if (storeWBIt->isAllZeros())
-            memset(inst->memData, 0, request->_size);
-        else
-            memcpy(inst->memData, storeWBIt->data(), request->_size);
+            if (storeWBIt->isAllZeros())
+                memset(inst->memData, 0, request->_size);
+            else
+                memcpy(inst->memData, storeWBIt->data(), request->_size);
+        }
 
         request->buildPackets();
 
@@ -1067,7 +1075,113 @@ LSQUnit::storePostSend()
         storeInFlight = true;
     }
 
-    storeWBIt++;
+    // Stores merged into this one are complete already.
+    do {
+        storeWBIt++;
+    } while (storeWBIt.dereferenceable() && storeWBIt->valid() &&
+             storeWBIt->completed());
+}
+
+bool
+LSQUnit::canWriteCombine(typename StoreQueue::iterator store_it)
+{
+    if (!store_it->hasRequest() || store_it->size() == 0 ||
+        store_it->isAllZeros()) {
+        return false;
+    }
+
+    const DynInstPtr &inst = store_it->instruction();
+    LSQRequest *request = store_it->request();
+    if (request->isSplit() || inst->isStoreConditional() ||
+        inst->isAtomic() || inst->isDataPrefetch() ||
+        inst->inHtmTransactionalState()) {
+        return false;
+    }
+
+    const RequestPtr &req = request->mainReq();
+    if (!req->hasPaddr() ||
+        !cpu->isWriteCombined(req->getPaddr(), req->getSize())) {
+        return false;
+    }
+    if (req->isLLSC() || req->isSwap() || req->isRelease() ||
+        req->isLocalAccess() || req->isCacheMaintenance()) {
+        return false;
+    }
+
+    const std::vector<bool> &byte_enable = request->_byteEnable;
+    if (std::find(byte_enable.begin(), byte_enable.end(), false) !=
+            byte_enable.end()) {
+        return false;
+    }
+
+    Addr line = addrBlockAlign(req->getPaddr(), cacheLineSize());
+    return req->getPaddr() + req->getSize() <= line + cacheLineSize();
+}
+
+bool
+LSQUnit::writeCombineStores()
+{
+    if (!canWriteCombine(storeWBIt))
+        return false;
+
+    LSQRequest *request = storeWBIt->request();
+    const RequestPtr &head_req = request->mainReq();
+    const unsigned line_size = cacheLineSize();
+    const Addr line = addrBlockAlign(head_req->getPaddr(), line_size);
+
+    unsigned low = head_req->getPaddr() - line;
+    unsigned high = low + head_req->getSize();
+    std::vector<uint8_t> data(line_size);
+    memcpy(&data[low], storeWBIt->data(), head_req->getSize());
+
+    // Committed stores right behind this one, to the same line and next
+    // to or over the bytes gathered so far, join it in program order.
+    std::vector<typename StoreQueue::iterator> merged;
+    auto store_it = storeWBIt;
+    for (int left = storesToWB - 1; left > 0; left--) {
+        store_it++;
+        if (!store_it.dereferenceable() || !store_it->valid() ||
+            !store_it->canWB() || store_it->completed() ||
+            !canWriteCombine(store_it)) {
+            break;
+        }
+
+        const RequestPtr &req = store_it->request()->mainReq();
+        unsigned offset = req->getPaddr() - line;
+        if (addrBlockAlign(req->getPaddr(), line_size) != line ||
+            offset > high || offset + req->getSize() < low) {
+            break;
+        }
+
+        memcpy(&data[offset], store_it->data(), req->getSize());
+        low = std::min(low, offset);
+        high = std::max(high, offset + unsigned(req->getSize()));
+        merged.push_back(store_it);
+    }
+
+    if (merged.empty())
+        return false;
+
+    DynInstPtr inst = storeWBIt->instruction();
+    RequestPtr req = std::make_shared<Request>(line + low, high - low,
+            head_req->getFlags(), head_req->requestorId());
+    req->setContext(head_req->contextId());
+    req->taskId(head_req->taskId());
+    request->_reqs[0] = req;
+
+    inst->memData = new uint8_t[high - low];
+    memcpy(inst->memData, &data[low], high - low);
+
+    DPRINTF(LSQUnit, "Write-combining %d stores after [sn:%lli] into "
+            "Addr:%#x, %d bytes\n", merged.size(), inst->seqNum,
+            line + low, high - low);
+
+    for (auto &it : merged) {
+        it->committed() = true;
+        completeStore(it);
+        stats.writeCombinedStores++;
+    }
+    return true;
 }
 
 void
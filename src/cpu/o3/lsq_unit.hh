@@ -378,6 +378,16 @@ class LSQUnit
     /** Handles completing the send of a store to memory. */
     void storePostSend();
 
+    /** Can the store at store_it be merged with its neighbours into one
+     * write to a write-combined range? */
+    bool canWriteCombine(typename StoreQueue::iterator store_it);
+
+    /** Merges the younger stores to the line of the store at storeWBIt
+     * into its request, filling in its memData, and completes them.
+     * @return Whether any store was merged.
+     */
+    bool writeCombineStores();
+
   public:
     /** Attempts to send a packet to the cache.
      * Check if there are ports available. Return true if
@@ -535,6 +545,9 @@ class LSQUnit
         /** Number of times the LSQ is blocked due to the cache. */
         statistics::Scalar blockedByCache;
 
+        /** Number of stores merged into the write of an older store. */
+        statistics::Scalar writeCombinedStores;
+
         /** Distribution of cycle latency between the first time a load
          * is issued and its completion */
         statistics::Distribution loadToUse;
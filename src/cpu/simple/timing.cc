@@ -41,6 +41,9 @@
 
 #include "cpu/simple/timing.hh"
 
+#include <algorithm>
+#include <cstring>
+
 #include "arch/generic/decoder.hh"
 #include "base/compiler.hh"
 #include "cpu/exetrace.hh"
@@ -79,6 +82,9 @@ TimingSimpleCPU::TimingSimpleCPU(const BaseTimingSimpleCPUParams& p) :
     ifetch_pkt(NULL),
     dcache_pkt(NULL),
     previousCycle(0),
+    wcFlushPkt(NULL),
+    wcPendingAccess(NULL),
+    wcPendingExecute(false),
     fetchEvent([this] { fetch(); }, name())
 {
     _status = Idle;
@@ -288,6 +294,8 @@ void TimingSimpleCPU::sendData(const RequestPtr& req, uint8_t* data, uint64_t* r
         completeDataAccess(pkt);
     } else if (read) {
         handleReadPacket(pkt);
+    } else if (canWriteCombine(req)) {
+        writeCombine(pkt);
     } else {
         bool do_access = true; // flag to suppress cache access
 
@@ -415,12 +423,6 @@ Fault TimingSimpleCPU::initiateMemRead(Addr addr, unsigned size, Request::Flags
 
     req->taskId(taskId());
 
-    // modified for mpeg2 encoder
-    if (addr >= 0x100000000 && addr < 0x100000000 + 512 * 1024 * 1024) {
-        // nop
-        req->setFlags(Request::UNCACHEABLE);
-    }
-
     Addr split_addr = roundDown(addr + size - 1, block_size);
     assert(split_addr <= addr || split_addr - addr < block_size);
 
@@ -492,12 +494,6 @@ Fault TimingSimpleCPU::writeMem(
 
     req->taskId(taskId());
 
-    // modified for mpeg2 encoder
-    if (addr >= 0x100000000 && addr < 0x100000000 + 512 * 1024 * 1024) {
-        // nop
-        req->setFlags(Request::UNCACHEABLE);
-    }
-
     Addr split_addr = roundDown(addr + size - 1, block_size);
     assert(split_addr <= addr || split_addr - addr < block_size);
 
@@ -584,6 +580,16 @@ void TimingSimpleCPU::finishTranslation(WholeTranslationState* state)
         delete[] state->data;
         state->deleteReqs();
         translationFault(state->getFault());
+    } else if (!wcBuffer.empty() &&
+               (state->isSplit ? waitsForWriteCombine(state->sreqLow) || waitsForWriteCombine(state->sreqHigh)
+                               : (state->mode != BaseMMU::Write || !canWriteCombine(state->mainReq)) &&
+                                     waitsForWriteCombine(state->mainReq))) {
+        // the buffered stores go out first; the access is sent once
+        // they are written
+        assert(!wcPendingAccess);
+        wcPendingAccess = state;
+        flushWriteCombine();
+        return;
     } else {
         if (!state->isSplit) {
             sendData(state->mainReq, state->data, state->res, state->mode == BaseMMU::Read);
@@ -757,6 +763,25 @@ void TimingSimpleCPU::completeIfetch(PacketPtr pkt)
         DPRINTF(HtmCpu, "htmTransactionStarts++=%u\n", thread->htmTransactionStarts);
     }
 
+    // fences, serializing instructions and system calls wait for the
+    // buffered stores to be written; so does the first instruction after
+    // a drain request, which stops combining
+    if (curStaticInst && !wcBuffer.empty() &&
+        (curStaticInst->isReadBarrier() || curStaticInst->isWriteBarrier() || curStaticInst->isSerializing() ||
+         curStaticInst->isSyscall() || curStaticInst->isQuiesce() || drainState() == DrainState::Draining)) {
+        wcPendingExecute = true;
+        flushWriteCombine();
+    } else {
+        executeInst();
+    }
+
+    if (pkt) { delete pkt; }
+}
+
+void TimingSimpleCPU::executeInst()
+{
+    SimpleExecContext& t_info = *threadInfo[curThread];
+
     if (curStaticInst && curStaticInst->isMemRef()) {
         // load or store: just send to dcache
         Fault fault = curStaticInst->initiateAcc(&t_info, traceData);
@@ -791,8 +816,6 @@ void TimingSimpleCPU::completeIfetch(PacketPtr pkt)
     } else {
         advanceInst(NoFault);
     }
-
-    if (pkt) { delete pkt; }
 }
 
 void TimingSimpleCPU::IcachePort::ITickEvent::process()
@@ -836,6 +859,11 @@ void TimingSimpleCPU::IcachePort::recvReqRetry()
 
 void TimingSimpleCPU::completeDataAccess(PacketPtr pkt)
 {
+    if (pkt == wcFlushPkt) {
+        completeWriteCombineFlush(pkt);
+        return;
+    }
+
     // hardware transactional memory
 
     SimpleExecContext*          t_info             = threadInfo[curThread];
@@ -1057,6 +1085,127 @@ void TimingSimpleCPU::DcachePort::recvReqRetry()
     }
 }
 
+bool TimingSimpleCPU::canWriteCombine(const RequestPtr& req) const
+{
+    if (!req->hasPaddr() || !isWriteCombined(req->getPaddr(), req->getSize())) return false;
+    if (req->isLLSC() || req->isSwap() || req->isAtomic() || req->isLocalAccess() || req->isHTMCmd() || req->isCacheMaintenance() ||
+        req->getFlags().isSet(Request::NO_ACCESS | Request::STORE_NO_DATA)) {
+        return false;
+    }
+    if (threadInfo[curThread]->inHtmTransactionalState() || drainState() == DrainState::Draining) return false;
+
+    const std::vector<bool>& byte_enable = req->getByteEnable();
+    if (std::find(byte_enable.begin(), byte_enable.end(), false) != byte_enable.end()) return false;
+
+    Addr line = roundDown(req->getPaddr(), cacheLineSize());
+    if (req->getPaddr() + req->getSize() > line + cacheLineSize()) return false;
+    if (wcBuffer.empty()) return true;
+
+    // the bytes buffered stay one run
+    Addr offset = req->getPaddr() - line;
+    return line == wcBuffer.line && offset <= wcBuffer.high && offset + req->getSize() >= wcBuffer.low;
+}
+
+bool TimingSimpleCPU::waitsForWriteCombine(const RequestPtr& req) const
+{
+    // device, strictly ordered and atomic accesses see the stores before
+    // them; a cacheable access to another line may pass them
+    if (!req->hasPaddr() || req->isUncacheable() || req->isStrictlyOrdered() || req->isLLSC() || req->isSwap() ||
+        req->isAtomic() || req->isLockedRMW() || req->isLocalAccess() || req->isHTMCmd() || req->isCacheMaintenance() ||
+        isWriteCombined(req->getPaddr(), std::max(req->getSize(), 1u))) {
+        return true;
+    }
+
+    Addr first = roundDown(req->getPaddr(), cacheLineSize());
+    Addr last  = roundDown(req->getPaddr() + std::max(req->getSize(), 1u) - 1, cacheLineSize());
+    return wcBuffer.line >= first && wcBuffer.line <= last;
+}
+
+void TimingSimpleCPU::writeCombine(PacketPtr pkt)
+{
+    const RequestPtr& req    = pkt->req;
+    Addr              line   = roundDown(req->getPaddr(), cacheLineSize());
+    unsigned          offset = req->getPaddr() - line;
+
+    if (wcBuffer.empty()) {
+        wcBuffer.line  = line;
+        wcBuffer.low   = offset;
+        wcBuffer.high  = offset;
+        wcBuffer.flags = req->getFlags();
+        wcBuffer.data.resize(cacheLineSize());
+    }
+    std::memcpy(&wcBuffer.data[offset], pkt->getConstPtr<uint8_t>(), req->getSize());
+    wcBuffer.low  = std::min(wcBuffer.low, offset);
+    wcBuffer.high = std::max(wcBuffer.high, offset + req->getSize());
+
+    DPRINTF(SimpleCPU, "Write-combining %#x, %d bytes into line %#x\n", req->getPaddr(), req->getSize(), line);
+
+    if (wcBuffer.high - wcBuffer.low < cacheLineSize()) {
+        // the store is done once it is buffered
+        pkt->makeResponse();
+        new IprEvent(pkt, this, clockEdge());
+        _status = DcacheWaitResponse;
+        return;
+    }
+
+    // the line is full: it is written as the access of this store
+    delete pkt;
+    dcache_pkt = buildWriteCombinePacket();
+    threadSnoop(dcache_pkt, curThread);
+    handleWritePacket();
+}
+
+PacketPtr TimingSimpleCPU::buildWriteCombinePacket()
+{
+    unsigned   size = wcBuffer.high - wcBuffer.low;
+    RequestPtr req  = std::make_shared<Request>(wcBuffer.line + wcBuffer.low, size, wcBuffer.flags, dataRequestorId());
+    req->setContext(threadInfo[curThread]->thread->contextId());
+    req->taskId(taskId());
+
+    PacketPtr pkt  = Packet::createWrite(req);
+    uint8_t*  data = new uint8_t[size];
+    std::memcpy(data, &wcBuffer.data[wcBuffer.low], size);
+    pkt->dataDynamic<uint8_t>(data);
+
+    DPRINTF(SimpleCPU, "Writing combined line %#x, %d bytes\n", req->getPaddr(), size);
+
+    wcBuffer.low  = 0;
+    wcBuffer.high = 0;
+    return pkt;
+}
+
+void TimingSimpleCPU::flushWriteCombine()
+{
+    assert(!wcFlushPkt && !dcache_pkt);
+    wcFlushPkt = buildWriteCombinePacket();
+    dcache_pkt = wcFlushPkt;
+    threadSnoop(wcFlushPkt, curThread);
+    handleWritePacket();
+}
+
+void TimingSimpleCPU::completeWriteCombineFlush(PacketPtr pkt)
+{
+    panic_if(pkt->isError(), "Data access (%s) failed: %s", pkt->getAddrRange().to_string(), pkt->print());
+    assert(_status == DcacheWaitResponse);
+
+    delete pkt;
+    wcFlushPkt = NULL;
+
+    updateCycleCounts();
+    updateCycleCounters(BaseCPU::CPU_STATE_ON);
+
+    if (wcPendingAccess) {
+        WholeTranslationState* state = wcPendingAccess;
+        wcPendingAccess              = NULL;
+        finishTranslation(state);
+    } else {
+        assert(wcPendingExecute);
+        wcPendingExecute = false;
+        _status          = BaseSimpleCPU::Running;
+        executeInst();
+    }
+}
+
 TimingSimpleCPU::IprEvent::IprEvent(Packet* _pkt, TimingSimpleCPU* _cpu, Tick t) : pkt(_pkt), cpu(_cpu)
 {
     cpu->schedule(this, t);
@@ -263,6 +263,34 @@ class TimingSimpleCPU : public BaseSimpleCPU
 
     Cycles previousCycle;
 
+    /**
+     * Stores to write-combined ranges complete as soon as they are in
+     * this buffer, which holds bytes [low, high) of one line. It is
+     * written out as a single packet when the line is full (as the access
+     * of the store that filled it), before any barrier, serializing
+     * instruction or system call, and before an access that cannot join
+     * it but is ordered after it (see waitsForWriteCombine). Cacheable
+     * accesses to other lines pass the buffer, as on a real CPU.
+     */
+    struct WriteCombineBuffer
+    {
+        Addr line = 0;
+        unsigned low = 0;
+        unsigned high = 0;
+        Request::Flags flags;
+        std::vector<uint8_t> data;
+
+        bool empty() const { return low == high; }
+    };
+
+    WriteCombineBuffer wcBuffer;
+
+    /** A flush of the buffer that something waits for: either the access
+     * in wcPendingAccess, or the execution of the current instruction. */
+    PacketPtr wcFlushPkt;
+    WholeTranslationState *wcPendingAccess;
+    bool wcPendingExecute;
+
   protected:
 
      /** Return a reference to the data port. */
@@ -301,6 +329,7 @@ class TimingSimpleCPU : public BaseSimpleCPU
     void sendFetch(const Fault &fault,
                    const RequestPtr &req, ThreadContext *tc);
     void completeIfetch(PacketPtr );
+    void executeInst();
     void completeDataAccess(PacketPtr pkt);
     void advanceInst(const Fault &fault);
 
@@ -332,6 +361,15 @@ class TimingSimpleCPU : public BaseSimpleCPU
 
   private:
 
+    /** Can the store of req join the write-combining buffer? */
+    bool canWriteCombine(const RequestPtr &req) const;
+    /** Must the access of req wait for the buffered stores? */
+    bool waitsForWriteCombine(const RequestPtr &req) const;
+    void writeCombine(PacketPtr pkt);
+    PacketPtr buildWriteCombinePacket();
+    void flushWriteCombine();
+    void completeWriteCombineFlush(PacketPtr pkt);
+
     EventFunctionWrapper fetchEvent;
 
     struct IprEvent : Event
@@ -357,6 +395,8 @@ class TimingSimpleCPU : public BaseSimpleCPU
      * <li>A fetch event is scheduled. Normally this would never be the
      *     case with microPC() == 0, but right after a context is
      *     activated it can happen.
+     *
+     * <li>Stores are waiting in the write-combining buffer.
      * </ul>
      */
     bool isCpuDrained() const {
@@ -364,7 +404,7 @@ class TimingSimpleCPU : public BaseSimpleCPU
         SimpleThread* thread = t_info.thread;
 
         return thread->pcState().microPC() == 0 && !t_info.stayAtPC &&
-               !fetchEvent.scheduled();
+               !fetchEvent.scheduled() && wcBuffer.empty();
     }
 
     /**
@@ -5,17 +5,104 @@ from m5.objects.ClockedObject import ClockedObject
 
 # FPGAEngine need to be assgined address ranges.
 
+class ChimeraTransport(ScopedEnum):
+    vals = ['xdma', 'emulated', 'verilator']
+
+class ChimeraCompletion(ScopedEnum):
+    vals = ['poll', 'adaptive', 'interrupt']
+
+class ChimeraReplay(ScopedEnum):
+    vals = ['off', 'record', 'replay']
+
 class Chimera(ClockedObject):
     type = 'Chimera'
     cxx_header = "fpga/chimera/chimera.hh"
     cxx_class = 'gem5::fpga::Chimera'
 
-    # When changing this parameter, you need to change two places, and a macro definition needs to be changed, while paying attention to the corresponding parameters in the hardware
-    taskTableNum = Param.Int(20, "the outstanding ability of proposed framework")
+    # table IDs are 8 bits wide on the card, hence at most 128 entries.
+    # The card's buffers are credited from the capability block it reports,
+    # so the table may outgrow them; the batch size is cut to what it takes
+    taskTableNum = Param.Int(20, "the outstanding ability of proposed framework "
+        "(at most 128)")
 
     batchEnable  = Param.Bool(False, "whether to enable batch optimization")
-    batchSize    = Param.Int(3, "supported batch size")
+    batchSize    = Param.Int(8, "max tasks coalesced into one PCIe transfer "
+        "(at most 15, the width of the batch field)")
+    batchTimeout = Param.Unsigned(2000, "ns the write thread holds a partial "
+        "batch of posted writes waiting for more tasks")
 
     enableCDMA  = Param.Bool(False, "whether to enable CDMA to poll results from fpga")
 
-    enable_log = Param.Bool(True, "")
\ No newline at end of file
+    hugePagePool = Param.Bool(False, "back the pinned task and packet "
+        "buffers with huge pages (needs pages reserved in vm.nr_hugepages)")
+
+    numChannels = Param.Int(1, "DMA channels (H2C/C2H pairs) striped across "
+        "the devices, each with its own submit and collect thread; the tasks "
+        "of one device keep to one channel")
+
+    dmaQueueDepth = Param.Int(1, "PCIe writes each channel keeps in flight; "
+        "more than one needs an asynchronous transport path (xdmaIoUring)")
+
+    completionMode = Param.ChimeraCompletion('poll',
+        "how the collect threads wait for results: re-read the response "
+        "window at once, back off exponentially while the card is idle, or "
+        "block on the transport's completion event (XDMA user interrupt or "
+        "eventfd), backing off if the transport has none")
+    pollBackoffMax = Param.Unsigned(100000, "ns cap on the pause between "
+        "two empty polls, also bounds a wait for a completion event")
+
+    # placement: a CPU list such as "7" or "4-7,12", "auto" for the CPUs of
+    # the NUMA node the card sits on, or "" to leave it to the scheduler;
+    # a list needs a CPU per thread, and kinds given the same list take
+    # consecutive CPUs of it: main, aux, submit per channel, collect per channel
+    submitCpus = Param.String("auto", "CPUs of the submit threads")
+    collectCpus = Param.String("auto", "CPUs of the collect threads")
+    auxCpus = Param.String("auto", "CPUs of the aux thread")
+    mainCpus = Param.String("auto", "CPUs of the gem5 main thread")
+    numaLocal = Param.Bool(True, "allocate the pinned task and packet "
+        "buffers on the card's NUMA node (xdma transport)")
+    workerPriority = Param.Unsigned(0, "SCHED_FIFO priority of the worker "
+        "threads (needs CAP_SYS_NICE); 0 keeps the normal policy")
+
+    waitSpinCount = Param.Unsigned(4096,
+        "iterations a worker thread spins on its input queues before it "
+        "yields and finally parks")
+
+    transport = Param.ChimeraTransport('xdma',
+        "backend behind the FPGA engine: the XDMA char devices of a real "
+        "board, an in-process emulated card, or the Verilated MPEG2 model")
+    xdmaDevice = Param.String("/dev/xdma0",
+        "prefix of the XDMA character devices (xdma transport)")
+    xdmaIoUring = Param.Bool(False, "queue writes through io_uring, falling "
+        "back to blocking transfers if unavailable (xdma transport)")
+    emulatedShmName = Param.String("",
+        "shared-memory object holding the emulated card state; anonymous "
+        "if empty (emulated transport)")
+    emulatedOutput = Param.Bool(True, "the emulated IP turns data-plane "
+        "input and stream stops into output; off, it only answers tasks "
+        "that need a response (emulated transport)")
+    traceFile = Param.String("", "write the life of every task to this "
+        "file as a Chrome trace (opens in Perfetto); off if empty")
+    traceBufferSize = Param.Unsigned(65536, "task records buffered for the "
+        "trace writer; records are dropped while it is full")
+
+    replayMode = Param.ChimeraReplay('off', "log the inputs and results "
+        "of the card behind the transport to a response log, or serve the "
+        "results from one, going live once the inputs differ from it")
+    replayDir = Param.String(".", "directory of the response logs")
+    replaySession = Param.String("", "names what a response log is valid "
+        "for (bitstream, workload, options); logs are keyed by its hash")
+
+    # bulk streaming of the data plane, for devices with bulk_data: large
+    # transfers past the task table, gathered from pinned 4 KiB segments
+    # into scatter-gather DMAs, in chunks credited like the tasks
+    bulkSegments = Param.Unsigned(0, "4 KiB segments of the pinned bulk "
+        "pool; 0 leaves bulk streaming off")
+    bulkMaxTransfer = Param.MemorySize("1MiB", "largest bulk transfer, "
+        "cut to the pool; it is sent in chunks of half the input buffer "
+        "of the card")
+    bulkTransfers = Param.Unsigned(8, "bulk transfers queued or in flight "
+        "at once")
+
+    dump_wave = Param.Bool(False,
+        "whether to dump wave from the Verilated model (verilator transport)")
\ No newline at end of file
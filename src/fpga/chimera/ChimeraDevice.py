@@ -0,0 +1,47 @@
+from m5.params import *
+from m5.proxy import *
+from m5.objects.ClockedObject import ClockedObject
+from m5.objects.Chimera import Chimera
+
+# An accelerator whose RTL runs behind Chimera. Subclasses declare the
+# registers of their IP; the windows below are offsets into pio_addr.
+
+class ChimeraDevice(ClockedObject):
+    type = 'ChimeraDevice'
+    abstract = True
+    cxx_header = "fpga/chimera/chimera_device.hh"
+    cxx_class = 'gem5::fpga::ChimeraDevice'
+
+    chimera = Param.Chimera(NULL, "pcie engine the device's tasks go through")
+
+    cpu_side_port = ResponsePort(
+        "This port receives requests and sends responses"
+    )
+    dma = RequestPort("port the output DMA writes guest memory through")
+    system = Param.System(Parent.any, "system the device is part of")
+
+    pio_addr = Param.Addr(0x100000000, "start of the device's window")
+    pio_size = Param.Addr(0x20000000, "size of the device's window")
+    status_reg = Param.Addr(0x10, "offset of the status register")
+    data_offset = Param.Addr(0x1000000, "offset of the data-plane window")
+    out_offset = Param.Addr(0x10000000, "offset of the output-buffer window, "
+        "read back from the card by CDMA")
+    pio_latency = Param.Latency("100ns", "latency of an atomic access to "
+        "the device")
+    card_base = Param.Addr(0, "where the IP's register map starts on the "
+        "card, for devices sharing one engine")
+    dma_reg = Param.Addr(0x20, "offset of the output DMA descriptor "
+        "registers: buffer address, buffer size, status word address and "
+        "control, 8 bytes each")
+    dma_virtual = Param.Bool(True, "DMA addresses are virtual addresses "
+        "of the process running on the system (SE mode)")
+    task_quota = Param.Int(0, "task table entries the device may hold at "
+        "once (0: no limit)")
+
+    enable_dataPlane_opt = Param.Bool(True, "coalesce data-plane writes "
+        "into 64-byte data tasks")
+    bulk_data = Param.Bool(False, "stream the data plane in bulk transfers "
+        "through the bulk pool of the chimera engine (bulkSegments), past "
+        "its task table; overrides enable_dataPlane_opt")
+    bulk_flush_delay = Param.Latency("1us", "how long a partly filled bulk "
+        "transfer waits for more data-plane writes before it is sent")
@@ -0,0 +1,43 @@
+from m5.params import *
+from m5.proxy import *
+from m5.objects.ClockedObject import ClockedObject
+from m5.objects.Chimera import Chimera
+
+# Synthetic tasks for a Chimera engine, to characterise it without a
+# device model or guest code. The mix of task kinds is given in percent,
+# like read_percent of the memory traffic generators.
+
+class ChimeraTrafficGen(ClockedObject):
+    type = 'ChimeraTrafficGen'
+    cxx_header = "fpga/chimera/chimera_traffic_gen.hh"
+    cxx_class = 'gem5::fpga::ChimeraTrafficGen'
+
+    chimera = Param.Chimera("pcie engine the tasks go through")
+    task_quota = Param.Int(0, "task table entries the generator may hold "
+        "at once (0: no limit)")
+
+    num_tasks = Param.UInt64(100000, "tasks to send; the simulation exits "
+        "once they are sent and every response is back")
+
+    write_percent = Param.Percent(0, "share of control writes")
+    data_percent = Param.Percent(100, "share of data-plane chunks")
+    resp_percent = Param.Percent(0, "share of control tasks that ask for a "
+        "response, as register reads do")
+    stop_percent = Param.Percent(0, "share of stream stops")
+
+    payload_size = Param.Unsigned(64, "bytes of a data chunk, a multiple "
+        "of 8 up to 64")
+
+    min_period = Param.Latency("0ns", "least time between two tasks")
+    max_period = Param.Latency("0ns", "most time between two tasks; with "
+        "both 0, tasks go as soon as a table entry is free")
+    max_outstanding = Param.Unsigned(0, "response tasks waiting for their "
+        "result at once (0: no limit)")
+
+    card_base = Param.Addr(0, "where the IP's register map starts on the "
+        "card")
+    ctrl_reg = Param.Addr(0x8, "register control writes and response "
+        "tasks go to")
+    stop_reg = Param.Addr(0x0, "register a stream stop is written to")
+    stop_value = Param.UInt64(0x2, "value of a stream stop (the end bit of "
+        "the MPEG2 encoder's control register)")
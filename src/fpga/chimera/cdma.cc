@@ -14,8 +14,17 @@ CDMA::CDMA(Chimera* parent, uint64_t limit_batch_size)
     m_wptr       = 0;
     m_rptr       = 0;
     m_status     = false;
+    m_stop       = false;
     m_parent     = parent;
-    m_osdRespPkt = new PCIeRespPkt(limit_batch_size);
+    m_pool       = new DMABufferPool(1, sizeof(PCIeRespPkt));
+    m_osdRespPkt = new (m_pool->slot(0)) PCIeRespPkt(limit_batch_size);
+}
+
+CDMA::~CDMA()
+{
+    // the response packet lives in the pool
+    delete m_pool;
+    delete[] m_buffer;
 }
 
 void CDMA::enable(uint64_t addr, uint64_t size)
@@ -25,6 +34,7 @@ void CDMA::enable(uint64_t addr, uint64_t size)
     m_size   = size;
     m_wptr   = 0;
     m_rptr   = 0;
+    m_stop   = false;
     m_status = true;
 }
 
@@ -40,10 +50,14 @@ void CDMA::disable()
 
 void CDMA::execute()
 {
-    uint64_t count = 0;
+    uint64_t    count = 0;
+    PollBackoff backoff(m_parent->pollBackoffMax());
+    uint64_t    cpuTime = get_thread_cpu_time_nanosecond();
     if (m_status) {
-        while (true) {
-            m_parent->getFPGAEngine()->dev_read(m_addr + m_wptr, m_osdRespPkt->m_size, m_osdRespPkt);
+        while (!m_stop.load(std::memory_order_acquire)) {
+            serviceCredits();
+            uint64_t wptr = m_wptr.load(std::memory_order_relaxed);
+            m_parent->getFPGAEngine()->dev_read(m_addr + wptr, m_osdRespPkt->m_size, m_osdRespPkt);
             if (m_osdRespPkt->m_valid & 0x1) {
                 uint64_t batch = m_osdRespPkt->m_batch;
                 count++;
@@ -51,14 +65,38 @@ void CDMA::execute()
                     if (m_osdRespPkt->m_results[i].m_valid & 0x2) {
                         std::cout << "count: " << count << std::endl;
                     }
-                    std::memcpy(m_buffer + m_wptr, &(m_osdRespPkt->m_results[i].m_content), RESULT_DATA_SIZE);
-                    m_wptr += RESULT_DATA_SIZE;
+                    std::memcpy(m_buffer + wptr, &(m_osdRespPkt->m_results[i].m_content), RESULT_DATA_SIZE);
+                    wptr += RESULT_DATA_SIZE;
                 }
+                // publish the results to fetchData() only once they are copied
+                m_wptr.store(wptr, std::memory_order_release);
+                backoff.reset();
+                m_parent->accountCpuTime(cpuTime);
             } else {
                 // hardware is not ready for response
+                m_parent->waitCompletion(0, backoff);
             }
         }
     }
+    m_parent->accountCpuTime(cpuTime);
+}
+
+void CDMA::serviceCredits()
+{
+    m_parent->serviceCreditRefresh(0);
+}
+
+void CDMA::stop()
+{
+    m_stop.store(true, std::memory_order_release);
+}
+
+void CDMA::restore(const uint8_t* data, uint64_t size)
+{
+    assert(m_status && m_wptr == 0);
+    std::memcpy(m_buffer, data, size);
+    m_rptr = 0;
+    m_wptr.store(size, std::memory_order_release);
 }
 
 void CDMA::fetchData(void* buf, uint64_t size)
@@ -71,5 +109,14 @@ void CDMA::fetchData(void* buf, uint64_t size)
     }
 }
 
+void CDMA::peekData(void* buf, uint64_t size)
+{
+    if (size <= getRemain()) {
+        std::memcpy(buf, m_buffer + m_rptr, size);
+    } else {
+        std::memset(buf, 0, size);
+    }
+}
+
 } // namespace fpga
 } // namespace gem5
\ No newline at end of file
@@ -1,7 +1,10 @@
 #ifndef __FPGA_CHIMERA_CDMA_HH__
 #define __FPGA_CHIMERA_CDMA_HH__
 
+#include <atomic>
+
 #include "common.hh"
+#include "dma_pool.hh"
 
 namespace gem5
 {
@@ -9,29 +12,53 @@ namespace fpga
 {
 
 class Chimera;
+
+/**
+ * Streams results from the card's CDMA window into a local buffer the
+ * gem5 thread drains with fetchData(). execute() runs on the first collect
+ * thread and reads until stop() is called; between empty reads it waits
+ * like the collect threads do (see Chimera::waitCompletion()).
+ *
+ * With CDMA enabled, the reads of channel 0 are the CDMA's, so the credit
+ * refresh of the engine, which reads through that channel, is serviced
+ * here too: by serviceCredits() while the readback is off, and by
+ * execute() before its first read and between reads.
+ */
 class CDMA
 {
   private:
-    uint64_t     m_addr;
-    uint64_t     m_size;
-    uint8_t*     m_buffer;
-    uint64_t     m_wptr;
-    uint64_t     m_rptr;
-    bool         m_status;
-    Chimera*     m_parent;
-    PCIeRespPkt* m_osdRespPkt;
+    uint64_t              m_addr;
+    uint64_t              m_size;
+    uint8_t*              m_buffer;
+    std::atomic<uint64_t> m_wptr;
+    uint64_t              m_rptr;
+    std::atomic<bool>     m_status;
+    std::atomic<bool>     m_stop;
+    Chimera*       m_parent;
+    DMABufferPool* m_pool;
+    PCIeRespPkt*   m_osdRespPkt;
 
   public:
     CDMA(Chimera* parent, uint64_t limit_batch_size);
-    ~CDMA()
-    {
-    }
+    ~CDMA();
 
     void enable(uint64_t addr, uint64_t size = 0);
     void disable();
     void execute();
+    void stop();
+    void serviceCredits();
 
     void fetchData(void* buf, uint64_t size);
+    // the same without consuming the results
+    void peekData(void* buf, uint64_t size);
+
+    // results read back and not fetched yet, for checkpoints; restore()
+    // hands them back to an enabled CDMA before it reads anything new
+    const uint8_t* pendingData()
+    {
+        return m_buffer + m_rptr;
+    }
+    void restore(const uint8_t* data, uint64_t size);
 
     uint64_t getWPtr()
     {
@@ -46,7 +73,7 @@ class CDMA
 
     int64_t getRemain()
     {
-        return m_wptr - m_rptr;
+        return m_wptr.load(std::memory_order_acquire) - m_rptr;
     }
 
     uint64_t getSize()
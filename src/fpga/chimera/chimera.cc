@@ -3,350 +3,803 @@
 #include <chrono>
 #include <assert.h>
 #include <unistd.h>
-#include <condition_variable>
 #include <atomic>
+#include <algorithm>
 
 #include "fpga/chimera/chimera.hh"
-#include "fpga/mpeg2/mpeg2_encoder.hh"
+#include "fpga/chimera/emulated_transport.hh"
+#include "fpga/chimera/replay_transport.hh"
+#include "fpga/chimera/verilator_transport.hh"
+#include "fpga/chimera/xdma_transport.hh"
+
+#include "base/bitfield.hh"
+#include "debug/Drain.hh"
 
 namespace gem5
 {
 namespace fpga
 {
 
-std::mutex auxMTX;
-std::mutex readMTX;
-std::mutex fetchMTX;
-std::mutex writeMTX;
+static Transport* createLiveTransport(const ChimeraParams& p)
+{
+    switch (p.transport) {
+        case ChimeraTransport::xdma:
+            return new XDMATransport(p.xdmaDevice, p.numChannels, p.xdmaIoUring, p.dmaQueueDepth,
+                                     p.completionMode == ChimeraCompletion::interrupt);
+        case ChimeraTransport::emulated:
+            return new EmulatedTransport(p.emulatedShmName, p.numChannels, p.emulatedOutput);
+        case ChimeraTransport::verilator:
+            return new VerilatorTransport(p.dump_wave, p.numChannels);
+        default:
+            panic("unknown chimera transport\n");
+    }
+}
+
+static Transport* createTransport(const ChimeraParams& p)
+{
+    Transport* live = createLiveTransport(p);
+    if (p.replayMode == ChimeraReplay::off) { return live; }
 
-std::condition_variable auxCV;
-std::condition_variable writeCV;
-std::condition_variable readCV;
-std::condition_variable fetchCV;
+    std::string path    = replayLogPath(p.replayDir, p.replaySession, live->name());
+    uint64_t    session = replaySessionHash(p.replaySession, live->name());
+    if (p.replayMode == ChimeraReplay::record) { return new RecordingTransport(live, path, session); }
+    return new ReplayTransport(live, path, session, p.numChannels);
+}
 
+enum PlacementRole { MainRole, AuxRole, SubmitRole, CollectRole, NumPlacementRoles };
+
+// thread kinds given the same CPU list take consecutive CPUs of it, in the
+// order main, aux, the submit threads, the collect threads
+static int placementFirst(const ChimeraParams& p, int role)
+{
+    const std::string* specs[NumPlacementRoles]  = {&p.mainCpus, &p.auxCpus, &p.submitCpus, &p.collectCpus};
+    const int          counts[NumPlacementRoles] = {1, 1, p.numChannels, p.numChannels};
+
+    int first = 0;
+    for (int r = 0; r < role; ++r) {
+        if (*specs[r] == *specs[role]) { first += counts[r]; }
+    }
+    return first;
+}
 
 Chimera::Chimera(const ChimeraParams& p) :
     ClockedObject(p),
     m_taskTableNum(p.taskTableNum),
     m_idleTaskTableID(p.taskTableNum),
     m_totalTaskID(0),
-    m_cdma_enable(p.enableCDMA)
+    m_cdma_enable(p.enableCDMA),
+    m_bulkPool(nullptr),
+    m_bulk(p.bulkSegments > 0 ? p.bulkTransfers : 0),
+    m_idleBulk(p.bulkTransfers),
+    m_idleSegments(p.bulkSegments),
+    m_bulkMaxTransfer(0),
+    m_completionMode(p.completionMode),
+    m_pollBackoffMax(p.pollBackoffMax),
+    m_numaNode(p.transport == ChimeraTransport::xdma ? deviceNumaNode(p.xdmaDevice) : -1),
+    m_submitPlacement(p.submitCpus, m_numaNode, p.workerPriority, placementFirst(p, SubmitRole), p.numChannels),
+    m_collectPlacement(p.collectCpus, m_numaNode, p.workerPriority, placementFirst(p, CollectRole),
+                       p.numChannels),
+    m_auxPlacement(p.auxCpus, m_numaNode, p.workerPriority, placementFirst(p, AuxRole)),
+    m_completions(p.taskTableNum),
+    m_readyMask((p.taskTableNum + 63) / 64),
+    m_drainEvent([this] { checkDrained(); }, name() + ".drainEvent")
 {
-    completeListUpdated = false;
+    if (p.numChannels < 1 || p.numChannels > XDMA_MAX_CHANNELS) {
+        fatal("chimera numChannels must be within [1, %d]\n", XDMA_MAX_CHANNELS);
+    }
+    // table IDs travel to the card and back in 8 bits
+    if (p.taskTableNum < 1 || p.taskTableNum > INT8_MAX + 1) {
+        fatal("chimera taskTableNum must be within [1, %d]\n", INT8_MAX + 1);
+    }
+
+    m_auxWaiter.setSpinCount(p.waitSpinCount);
+
+    // the constructor runs on the gem5 main thread
+    ThreadPlacement(p.mainCpus, m_numaNode, 0, placementFirst(p, MainRole)).apply("main");
+    DPRINTF(Chimera, "card on NUMA node %d\n", m_numaNode);
+
     auxDone.store(false, std::memory_order_relaxed);
     writeDone.store(false, std::memory_order_relaxed);
     readDone.store(false, std::memory_order_relaxed);
-    osdTaskCounter.store(0, std::memory_order_relaxed);
-    comeInList     = new RingBuffer<PCIeTask>(p.taskTableNum);
-    ready2Transmit = new RingBuffer<PCIeTask>(p.taskTableNum);
-    ready2Response = new RingBuffer<PCIeRespPkt>(p.taskTableNum);
+    // a collect thread may read the result of any outstanding task, so each
+    // channel gets one response slot per table entry, plus the one the aux
+    // thread may still be draining after it released that packet's entries
+    m_respSlotNum  = p.taskTableNum + 1;
+    comeInList     = new RingBuffer<int>(p.taskTableNum + m_bulk.size());
+    ready2Response = new MPSCRingBuffer<int>(p.numChannels * m_respSlotNum);
+
+    m_batchSize    = p.batchEnable ? p.batchSize : 1;
+    m_batchTimeout = p.batchTimeout;
+    if (m_batchSize < 1 || m_batchSize > MAX_BATCH_THRESHOLD) {
+        fatal("chimera batchSize must be within [1, %d]\n", MAX_BATCH_THRESHOLD);
+    }
+
+    m_dmaQueueDepth = p.dmaQueueDepth;
+    if (m_dmaQueueDepth < 1) { fatal("chimera dmaQueueDepth must be at least 1\n"); }
+
+    // the batch size may shrink to what the card takes, so the card comes
+    // up before anything sized after it
+    m_fpga = new FPGAEngine(createTransport(p));
+    m_fpga->dev_init();
+    m_fpga->config_read_mode_poll();
+    discoverCaps();
 
     m_validTaskTableNum.store(p.taskTableNum, std::memory_order_relaxed);
-    m_osdReqPkt  = new PCIeReqPkt(1);
-    m_osdDataPkt = new PCIeDataPkt(1);
-    m_osdRespPkt = new PCIeRespPkt(1);
+    int poolNode = p.numaLocal ? m_numaNode : -1;
+    m_taskPool = new DMABufferPool(p.taskTableNum, sizeof(PCIeTask), p.hugePagePool, poolNode);
+    m_pktPool  = new DMABufferPool(p.numChannels * (2 * m_dmaQueueDepth + m_respSlotNum),
+                                   std::max({sizeof(PCIeReqPkt), sizeof(PCIeDataPkt), sizeof(PCIeRespPkt)}),
+                                   p.hugePagePool, poolNode);
+
+    for (int c = 0; c < p.numChannels; ++c) {
+        ChimeraChannel* ch = new ChimeraChannel();
+        ch->m_id             = c;
+        ch->m_ready2Transmit = new RingBuffer<int>(p.taskTableNum + m_bulk.size());
+        ch->m_freeRespSlot   = new RingBuffer<int>(m_respSlotNum);
+        ch->m_writeWaiter.setSpinCount(p.waitSpinCount);
+        ch->m_readWaiter.setSpinCount(p.waitSpinCount);
+        ch->m_osdTaskCounter.store(0, std::memory_order_relaxed);
+        for (int i = 0; i < m_dmaQueueDepth; ++i) {
+            int slot = 2 * (c * m_dmaQueueDepth + i);
+            ch->m_osdReqPkt.push_back(new (m_pktPool->slot(slot)) PCIeReqPkt(m_batchSize));
+            ch->m_osdDataPkt.push_back(new (m_pktPool->slot(slot + 1)) PCIeDataPkt(m_batchSize));
+        }
+        ch->m_inflight.resize(m_dmaQueueDepth);
+        // with room for every table entry, the ring still takes what the
+        // submit thread retires after the aux thread is gone
+        ch->m_retiredTasks = new RingBuffer<TaskTraceRecord>(2 * p.taskTableNum);
+        ch->m_submitted = 0;
+        ch->m_retired   = 0;
+        m_channels.push_back(ch);
+    }
+    for (auto ch : m_channels) {
+        for (int i = ch->m_id * m_respSlotNum; i < (ch->m_id + 1) * m_respSlotNum; ++i) {
+            new (respSlot(i)) PCIeRespPkt(m_batchSize);
+            ch->m_freeRespSlot->enqueue(i);
+        }
+        ch->m_osdRespSlot = ch->m_freeRespSlot->dequeue();
+        ch->m_osdRespPkt  = respSlot(ch->m_osdRespSlot);
+    }
 
     for (int i = 0; i < p.taskTableNum; ++i) {
-        m_taskTable.push_back(new taskTableEntry(i));
-        assert(m_idleTaskTableID.enqueue(i));
+        m_taskTable.push_back(new taskTableEntry(i, new (m_taskPool->slot(i)) PCIeTask()));
+        [[maybe_unused]] bool queued = m_idleTaskTableID.enqueue(i);
+        assert(queued);
     }
 
-    m_fpga         = new FPGAEngine();
-    m_cdma         = new CDMA(this, 1);
-    m_parent_retry = false;
-    m_fpga->dev_init();
-    m_fpga->config_read_mode_poll();
+    if (p.bulkSegments > 0) {
+        if (p.bulkTransfers < 1) { fatal("chimera bulkTransfers must be at least 1 with a bulk pool\n"); }
+        m_bulkPool = new DMABufferPool(p.bulkSegments, CHIMERA_BULK_SEGMENT_SIZE, p.hugePagePool, poolNode);
+        for (int i = 0; i < p.bulkSegments; ++i) { m_idleSegments.enqueue(i); }
+        for (int i = 0; i < m_bulk.size(); ++i) { m_idleBulk.enqueue(i); }
+        m_bulkFreeSegments.store(p.bulkSegments, std::memory_order_relaxed);
+
+        // a transfer has to fit the pool; it is sent in chunks the input
+        // buffer of the card has room for, see issueBulk()
+        m_bulkMaxTransfer = std::min<uint64_t>(p.bulkMaxTransfer, (uint64_t)p.bulkSegments * CHIMERA_BULK_SEGMENT_SIZE);
+        m_bulkMaxTransfer &= ~(uint64_t)(CHIMERA_DATA_BEAT_SIZE - 1);
+        if (m_bulkMaxTransfer == 0) { fatal("chimera bulkMaxTransfer must be at least %d\n", CHIMERA_DATA_BEAT_SIZE); }
+    }
+
+    m_fpga->getTransport()->registerBuffer(m_taskPool->base(), m_taskPool->mapSize());
+    m_fpga->getTransport()->registerBuffer(m_pktPool->base(), m_pktPool->mapSize());
+    if (m_bulkPool) { m_fpga->getTransport()->registerBuffer(m_bulkPool->base(), m_bulkPool->mapSize()); }
+    m_cdma         = new CDMA(this, m_batchSize);
+    if (m_completionMode == ChimeraCompletion::interrupt && !m_fpga->getTransport()->hasEvents()) {
+        warn("chimera: %s transport has no completion events, backing off between polls instead\n",
+             m_fpga->getTransport()->name());
+    }
 
     // set batch threshold
-    int* msg = static_cast<int*>(std::malloc(32));
-    *msg = 1;
-    m_fpga->dev_write(0x1010, 32, msg);
+    int* msg = static_cast<int*>(std::calloc(1, CHIMERA_REG_MSG_SIZE));
+    *msg = m_batchSize;
+    m_fpga->dev_write(CHIMERA_REG_BATCH, CHIMERA_REG_MSG_SIZE, msg);
     free(msg);
 
-    auxThread   = std::thread(&Chimera::auxThreadFunc, this);
-    readThread  = std::thread(&Chimera::collectThreadFunc, this);
-    writeThread = std::thread(&Chimera::submitThreadFunc, this);
-
+    // the worker threads touch both, so they must exist before the threads
     std::string s1 = "chimera";
     m_stats = new ChimeraStats(*this, s1);
     m_lifeCycleTable.resize(m_taskTableNum);
+    m_traceLog = p.traceFile.empty() ? nullptr : new ChimeraTraceLog(p.traceFile, p.traceBufferSize);
 
-    if (p.enable_log) {
-        registerExitCallback([this]() { printBatchRecord(); });
-        registerExitCallback([this]() { m_fpga->printPCIeTime(); });
+    auxThread = std::thread(&Chimera::auxThreadFunc, this);
+    for (auto ch : m_channels) {
+        ch->m_readThread  = std::thread(&Chimera::collectThreadFunc, this, ch);
+        ch->m_writeThread = std::thread(&Chimera::submitThreadFunc, this, ch);
     }
+
+    if (m_traceLog) { registerExitCallback([this]() { m_traceLog->close(); }); }
 }
 
 Chimera::~Chimera()
 {
 }
 
-void Chimera::submitThreadFunc()
+/**
+ * Read what the card takes and check it against this build. A bitstream
+ * without a capability block answers the read with a response packet, or
+ * part of one, which leaves its read side mid-packet; it is reset again and
+ * the engine runs uncredited at the compile-time limits, as it always did.
+ */
+void Chimera::discoverCaps()
+{
+    std::memset(&m_caps, 0, sizeof(m_caps));
+    m_hasCaps = m_fpga->dev_caps(m_caps);
+    if (!m_hasCaps) {
+        warn("chimera: the card reports no capabilities, its buffers are not credited\n");
+        m_fpga->dev_init();
+        m_fpga->config_read_mode_poll();
+        return;
+    }
+
+    if (m_caps.m_taskBits != sizeof(PCIeCtrlTask) * 8 || m_caps.m_resultBits != sizeof(PCIeResult) * 8) {
+        fatal("chimera: the card takes %d-bit tasks and %d-bit results, this build %d-bit and %d-bit\n",
+              m_caps.m_taskBits, m_caps.m_resultBits, sizeof(PCIeCtrlTask) * 8, sizeof(PCIeResult) * 8);
+    }
+    if (m_caps.m_ibufferDepth < TASK_DATA_SIZE / CHIMERA_DATA_BEAT_SIZE || m_caps.m_obufferDepth < 1) {
+        fatal("chimera: the card buffers (%d in, %d out) cannot take a single task\n", m_caps.m_ibufferDepth,
+              m_caps.m_obufferDepth);
+    }
+
+    int maxBatch = std::max<int>(1, std::min<int>(m_caps.m_maxBatch, m_caps.m_obufferDepth));
+    if (m_batchSize > maxBatch) {
+        warn("chimera: batchSize %d is above what the card takes, using %d\n", m_batchSize, maxBatch);
+        m_batchSize = maxBatch;
+    }
+    DPRINTF(Chimera, "card v%d: batch %d, input buffer %d, output buffer %d\n", m_caps.m_version,
+            m_caps.m_maxBatch, m_caps.m_ibufferDepth, m_caps.m_obufferDepth);
+}
+
+// input buffer slots a task takes: one per control task, one per beat of
+// a data chunk
+uint64_t Chimera::inputSlots(PCIeTask* task)
+{
+    if (!task->isData()) { return 1; }
+    return (task->m_size + CHIMERA_DATA_BEAT_SIZE - 1) / CHIMERA_DATA_BEAT_SIZE;
+}
+
+bool Chimera::tryTakeCredits(uint64_t input, uint64_t output)
+{
+    uint64_t issued = m_inputIssued.load(std::memory_order_relaxed);
+    do {
+        if (issued + input - m_inputConsumed.load(std::memory_order_acquire) > m_caps.m_ibufferDepth) {
+            return false;
+        }
+    } while (!m_inputIssued.compare_exchange_weak(issued, issued + input, std::memory_order_relaxed));
+
+    uint64_t held = m_outputHeld.load(std::memory_order_relaxed);
+    do {
+        if (held + output > m_caps.m_obufferDepth) {
+            m_inputIssued.fetch_sub(input, std::memory_order_relaxed);
+            return false;
+        }
+    } while (!m_outputHeld.compare_exchange_weak(held, held + output, std::memory_order_relaxed));
+    return true;
+}
+
+/**
+ * Wait until the card has room for a write taking input slots of its
+ * input buffer and output slots of its output buffer. The drained count is
+ * only read again once the input buffer looks full, by the collect thread
+ * of channel 0, which owns the reads of that channel, through the CDMA
+ * readback when it is enabled.
+ */
+void Chimera::takeCredits(uint64_t input, uint64_t output, int channel)
+{
+    if (tryTakeCredits(input, output)) { return; }
+
+    // the credits come back once the card has the writes still queued
+    m_fpga->dev_flush(channel);
+    m_stats->creditStalls += 1;
+    PollBackoff backoff(pollBackoffMax());
+    while (!tryTakeCredits(input, output)) {
+        uint64_t pending =
+            m_inputIssued.load(std::memory_order_relaxed) - m_inputConsumed.load(std::memory_order_acquire);
+        if (pending + input > m_caps.m_ibufferDepth) { requestCreditRefresh(); }
+        uint64_t pause = backoff.next();
+        if (pause > 0) {
+            std::this_thread::sleep_for(std::chrono::nanoseconds(pause));
+        } else {
+            sched_yield();
+        }
+    }
+}
+
+void Chimera::requestCreditRefresh()
+{
+    if (!m_creditRefresh.exchange(true, std::memory_order_acq_rel)) { m_channels[0]->m_readWaiter.notify(); }
+}
+
+void Chimera::serviceCreditRefresh(int channel)
+{
+    if (!m_creditRefresh.exchange(false, std::memory_order_acq_rel)) { return; }
+
+    ChimeraCaps caps;
+    if (!m_fpga->dev_caps(caps, channel)) { panic("chimera: the card stopped reporting its capabilities\n"); }
+    m_stats->creditRefreshes += 1;
+
+    // the count only grows; a refresh racing an older one must not undo it
+    uint64_t consumed = m_inputConsumed.load(std::memory_order_relaxed);
+    while (caps.m_consumed > consumed
+           && !m_inputConsumed.compare_exchange_weak(consumed, caps.m_consumed, std::memory_order_release)) {
+    }
+}
+
+void Chimera::submitThreadFunc(ChimeraChannel* ch)
 {
     pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, NULL);
 
-    int threadCore = 7;
+    m_submitPlacement.apply("submit", ch->m_id);
 
-    cpu_set_t cpuset;
-    CPU_ZERO(&cpuset);                               
-    CPU_SET(threadCore, &cpuset);                    
-    sched_setaffinity(0, sizeof(cpu_set_t), &cpuset);
+    RingBuffer<int>*           ready2Transmit = ch->m_ready2Transmit;
+    std::vector<DMACompletion> done;
+    uint64_t                   cpuTime = get_thread_cpu_time_nanosecond();
 
     while (true) {
-        DPRINTF(Chimera, "[writeThread] acquiring for locks\n");
-        std::unique_lock<std::mutex> lock(writeMTX);
-        writeCV.wait(lock, [this] { return !ready2Transmit->isEmpty() || writeDone.load(std::memory_order_relaxed); });
-        DPRINTF(Chimera, "[writeThread] active, ready to work\n");
-        if (ready2Transmit->isEmpty() && writeDone.load(std::memory_order_relaxed)) { break; }
-        if (!ready2Transmit->isEmpty()) {
-            std::vector<int8_t> submitTaskTableID;
-
-            uint8_t lastTaskAttr = ready2Transmit->peek().m_basic;
-            
-            if (lastTaskAttr == ready2Transmit->peek().m_basic) {
-                if (ready2Transmit->peek().isWrite()) {
-                    PCIeTask task = ready2Transmit->peek();
-                    lastTaskAttr  = task.m_basic;
-                    m_osdReqPkt->fillTask(0, task);
-                    ready2Transmit->dequeue();
-                    submitTaskTableID.push_back(task.m_tableID);
-                } else if (ready2Transmit->peek().isData()) {
-                    PCIeTask task = ready2Transmit->peek();
-                    lastTaskAttr  = task.m_basic;
-                    if (m_osdDataPkt->fillTask(0, task) == 0) {
-                        m_osdReqPkt->fillTask(0, task);
-                        ready2Transmit->dequeue();
-                        submitTaskTableID.push_back(task.m_tableID);
-                    } else {
-                        break;
-                    }
-                } else if (ready2Transmit->peek().isRead()) {
-                    assert(false);
-                    break;
-                } else {
-                    assert(false);
-                }
-            } else {
-                break;
-            }
+        DPRINTF(Chimera, "[writeThread %d] waiting for tasks\n", ch->m_id);
+        ch->m_writeWaiter.wait([&] {
+            return !ready2Transmit->isEmpty() || writeDone.load(std::memory_order_acquire)
+                || ch->m_submitted != ch->m_retired;
+        });
+        DPRINTF(Chimera, "[writeThread %d] active, ready to work\n", ch->m_id);
+        if (ready2Transmit->isEmpty() && writeDone.load(std::memory_order_acquire)
+            && ch->m_submitted == ch->m_retired) {
+            break;
+        }
+        if (!ready2Transmit->isEmpty() && ch->m_submitted - ch->m_retired < m_dmaQueueDepth) {
+            // queue as many batches as there is room for, the transport sends them as one ordered chain
+            do {
+                issueBatch(ch);
+            } while (!ready2Transmit->isEmpty() && ch->m_submitted - ch->m_retired < m_dmaQueueDepth);
+            m_fpga->dev_flush(ch->m_id);
+        }
 
-            m_osdReqPkt->m_valid = 0x1;
-            m_osdReqPkt->m_batch = 1;
+        if (ch->m_submitted != ch->m_retired) {
+            // only wait for a write when no new batch can be issued
+            bool block = ready2Transmit->isEmpty() || ch->m_submitted - ch->m_retired == m_dmaQueueDepth;
+            done.clear();
+            m_fpga->dev_reap(ch->m_id, done, block ? 1 : 0);
+            for (const DMACompletion& completion : done) { retireBatch(ch, completion); }
+            if (!done.empty()) { accountCpuTime(cpuTime); }
+        }
+    }
+    accountCpuTime(cpuTime);
+    DPRINTF(Chimera, "WRITE Thread %d Exit...\n", ch->m_id);
+}
 
-            lock.unlock();
+// build the next batch in a free packet pair and hand it to the transport
+void Chimera::issueBatch(ChimeraChannel* ch)
+{
+    if (isBulk(ch->m_ready2Transmit->peek())) { return issueBulk(ch); }
 
-            DPRINTF(Chimera, "[writeThread] ready to issue pcie write request\n");
+    int            pkt   = ch->m_submitted % m_dmaQueueDepth;
+    InflightWrite& write = ch->m_inflight[pkt];
+    write.m_tableIDs.clear();
+    write.m_bulk    = -1;
+    write.m_bulkEnd = false;
 
-            if (lastTaskAttr & 0x4) {
-                for (int i = 0; i < submitTaskTableID.size(); ++i) {
-                    m_lifeCycleTable[submitTaskTableID[i]].m_pre_submitTime = get_system_time_nanosecond();
-                }
+    write.m_attr = collectBatch(ch, write.m_tableIDs);
+    int batch    = write.m_tableIDs.size();
 
-                m_fpga->dev_write(0x0, m_osdReqPkt->m_size, m_osdReqPkt);
+    PCIeReqPkt* reqPkt = ch->m_osdReqPkt[pkt];
+    reqPkt->m_valid    = 0x1;
+    reqPkt->m_batch    = batch;
+    ch->m_writeBatches.add(batch);
 
-                for (int i = 0; i < submitTaskTableID.size(); ++i) {
-                    m_lifeCycleTable[submitTaskTableID[i]].m_post_submitTime = get_system_time_nanosecond();
-                }
+    DPRINTF(Chimera, "[writeThread %d] ready to issue pcie write request, batch: %d\n", ch->m_id, batch);
 
-                if (lastTaskAttr & 0x2) {
-                    [[maybe_unused]] int value = osdTaskCounter.fetch_add(m_osdReqPkt->m_batch, std::memory_order_relaxed);
-                    readCV.notify_one();
-                    DPRINTF(Chimera, "the request need response, notify read thread\n");
-                } else {
-                    for (int i = 0; i < m_osdReqPkt->m_batch; ++i) {
-                        int tableID = m_osdReqPkt->m_tasks[i].m_tableID;
-                    
-                        submitLifeCycle(tableID);
+    for (int i = 0; i < batch; ++i) {
+        m_lifeCycleTable[write.m_tableIDs[i]].m_pre_submitTime = get_system_time_nanosecond();
+    }
 
-                        assert(m_idleTaskTableID.enqueue(tableID));
+    if (m_hasCaps) {
+        uint64_t input = 0;
+        for (int8_t tableID : write.m_tableIDs) { input += inputSlots(m_taskTable[tableID]->m_task); }
+        takeCredits(input, (write.m_attr & 0x2) && !m_cdma_enable ? batch : 0, ch->m_id);
+    }
 
-                        parentRetryCallback();
+    if (write.m_attr & 0x4) {
+        fillBatch(ch, pkt, write.m_tableIDs);
+        write.m_size = reqPkt->getSize();
+        m_fpga->dev_write_async(CHIMERA_REQ_WINDOW, write.m_size, reqPkt, ch->m_id, ch->m_submitted);
+    } else if (write.m_attr & 0x10) {
+        if (batch == 1) {
+            // a lone chunk goes out straight from its task slot
+            PCIeTask* task = m_taskTable[write.m_tableIDs[0]]->m_task;
+            write.m_size   = task->m_size;
+            m_fpga->dev_write_async(task->m_addr, task->m_size, task->m_content, ch->m_id, ch->m_submitted);
+        } else {
+            PCIeDataPkt* dataPkt = ch->m_osdDataPkt[pkt];
+            fillBatch(ch, pkt, write.m_tableIDs);
+            write.m_size = dataPkt->getSize();
+            m_fpga->dev_write_async(dataPkt->getAddr(), dataPkt->getSize(), dataPkt->getDataPtr(), ch->m_id,
+                                    ch->m_submitted);
+        }
+    } else {
+        assert(false);
+    }
+    ch->m_submitted++;
+}
 
-                        m_taskTable[tableID]->m_valid = 0x0;
-                        m_validTaskTableNum.fetch_add(1, std::memory_order_relaxed);
-                        DPRINTF(Chimera, "the request dont need response, release task table entry: %d\n", tableID);
-                    }
-                }
-            } else if (lastTaskAttr & 0x8) {
-                [[maybe_unused]] int value = osdTaskCounter.fetch_add(m_osdReqPkt->m_batch, std::memory_order_relaxed);
-                readCV.notify_one();
-                DPRINTF(Chimera, "the request need response, notify read thread\n");
-            } else if (lastTaskAttr & 0x10) {
-                m_fpga->dev_write(m_osdDataPkt->getAddr(), m_osdDataPkt->getSize(), m_osdDataPkt->getDataPtr());
+/**
+ * Hand the next chunk of the bulk transfer at the head of ready2Transmit to
+ * the transport as one scatter-gather write. It is data plane, so it takes
+ * an input slot per beat and no output. A credited card gets a window: each
+ * chunk takes every slot that is free when it is issued, and at least half
+ * the buffer, waiting for those credits if need be. The drained count is
+ * asked for again as soon as a chunk is out, so it comes back while the
+ * chunk is on its way and the next one is sized by how far the card got.
+ * Without credits the transfer goes in one. The transfer leaves
+ * ready2Transmit with its last chunk.
+ */
+void Chimera::issueBulk(ChimeraChannel* ch)
+{
+    int            pkt   = ch->m_submitted % m_dmaQueueDepth;
+    InflightWrite& write = ch->m_inflight[pkt];
+    write.m_tableIDs.clear();
+    write.m_bulk = ch->m_ready2Transmit->peek() - m_taskTableNum;
+    write.m_attr = 0x10;
+
+    BulkTransfer& bulk   = m_bulk[write.m_bulk];
+    uint64_t      offset = bulk.m_issued;
+    write.m_size         = bulk.m_size - offset;
+    if (m_hasCaps) {
+        uint64_t pending = m_inputIssued.load(std::memory_order_relaxed)
+                           - m_inputConsumed.load(std::memory_order_acquire);
+        uint64_t free    = m_caps.m_ibufferDepth - std::min<uint64_t>(pending, m_caps.m_ibufferDepth);
+        uint64_t beats   = std::max<uint64_t>(free, std::max<uint64_t>(m_caps.m_ibufferDepth / 2, 1));
+        write.m_size     = std::min(write.m_size, beats * CHIMERA_DATA_BEAT_SIZE);
+    }
 
-                for (int i = 0; i < m_osdReqPkt->m_batch; ++i) {
-                    int tableID = m_osdReqPkt->m_tasks[i].m_tableID;
-                    
-                    submitLifeCycle(tableID);
+    write.m_iov.clear();
+    for (uint64_t left = write.m_size; left > 0;) {
+        const iovec& iov   = bulk.m_iov[bulk.m_nextIov];
+        uint64_t     bytes = std::min<uint64_t>(iov.iov_len - bulk.m_nextOffset, left);
+        write.m_iov.push_back({static_cast<uint8_t*>(iov.iov_base) + bulk.m_nextOffset, bytes});
+        left -= bytes;
+        bulk.m_nextOffset += bytes;
+        if (bulk.m_nextOffset == iov.iov_len) {
+            bulk.m_nextIov++;
+            bulk.m_nextOffset = 0;
+        }
+    }
+    bulk.m_issued += write.m_size;
+    write.m_bulkEnd = bulk.m_issued == bulk.m_size;
+    if (write.m_bulkEnd) { ch->m_ready2Transmit->dequeue(); }
 
-                    assert(m_idleTaskTableID.enqueue(tableID));
+    DPRINTF(Chimera, "[writeThread %d] issuing %d bytes of bulk transfer %d to %#x, %d buffers\n", ch->m_id,
+            write.m_size, write.m_bulk, bulk.m_addr + offset, write.m_iov.size());
 
-                    parentRetryCallback();
+    if (m_hasCaps) {
+        takeCredits(write.m_size / CHIMERA_DATA_BEAT_SIZE, 0, ch->m_id);
+        requestCreditRefresh();
+    }
+    m_fpga->dev_writev_async(bulk.m_addr + offset, write.m_iov.data(), write.m_iov.size(), ch->m_id,
+                             ch->m_submitted);
+    if (write.m_bulkEnd) { m_stats->bulkTransfers += 1; }
+    m_stats->bulkBytes += write.m_size;
+    ch->m_submitted++;
+}
+
+// a write reached the card: wake the collect thread or free the entries
+void Chimera::retireBatch(ChimeraChannel* ch, const DMACompletion& completion)
+{
+    assert(completion.m_tag == ch->m_retired);
+    InflightWrite& write = ch->m_inflight[completion.m_tag % m_dmaQueueDepth];
+    int            batch = write.m_tableIDs.size();
+    if (completion.m_result != (int64_t)write.m_size) {
+        panic("*** ERROR: failed to write %d bytes through %s transport (channel %d), result: %d\n", write.m_size,
+              m_fpga->getTransport()->name(), ch->m_id, completion.m_result);
+    }
 
-                    m_taskTable[tableID]->m_valid = 0x0;
-                    m_validTaskTableNum.fetch_add(1, std::memory_order_relaxed);
+    for (int i = 0; i < batch; ++i) {
+        m_lifeCycleTable[write.m_tableIDs[i]].m_post_submitTime = get_system_time_nanosecond();
+    }
 
-                    issued_data_packet++;
-                    DPRINTF(Chimera, "the request dont need response, release task table entry: %d\n", tableID);
-                }
-            } else {
-                assert(false);
+    if (write.m_bulk >= 0) {
+        if (write.m_bulkEnd) { releaseBulk(write.m_bulk); }
+    } else if (write.m_attr & 0x4) {
+        if (write.m_attr & 0x2) {
+            [[maybe_unused]] int value = ch->m_osdTaskCounter.fetch_add(batch, std::memory_order_relaxed);
+            ch->m_readWaiter.notify();
+            DPRINTF(Chimera, "the request need response, notify read thread\n");
+        } else {
+            releaseTasks(ch, write.m_tableIDs);
+        }
+    } else {
+        issued_data_packet += batch;
+        releaseTasks(ch, write.m_tableIDs);
+    }
+
+    DPRINTF(Chimera, "[writeThread %d] pcie write request finished\n", ch->m_id);
+    ch->m_osdReqPkt[completion.m_tag % m_dmaQueueDepth]->m_valid = 0x0;
+    ch->m_retired++;
+}
+
+/**
+ * Pick the tasks at the head of ready2Transmit that can share one
+ * transfer: control writes with identical attributes, or data chunks each
+ * continuing the previous one. The batch is closed when it holds
+ * m_batchSize tasks, or the next task does not fit the batch or the input
+ * buffer of the card, or is a bulk transfer. If the queue runs dry
+ * first, a batch of posted writes is held for up to m_batchTimeout ns; one
+ * that needs a response is sent at once since its producer is waiting for
+ * the result. Nothing is copied here, see fillBatch().
+ */
+int Chimera::collectBatch(ChimeraChannel* ch, std::vector<int8_t>& tableIDs)
+{
+    RingBuffer<int>* ready2Transmit = ch->m_ready2Transmit;
+
+    PCIeTask* head = m_taskTable[ready2Transmit->peek()]->m_task;
+    if (!head->isWrite() && !head->isData()) { panic("chimera can only submit write and data tasks\n"); }
+
+    bool     holdBack = m_batchSize > 1 && !head->isNeedResp();
+    uint64_t deadline = get_system_time_nanosecond() + m_batchTimeout;
+    uint64_t nextAddr = head->m_addr;
+    uint64_t slots    = 0;
+
+    while ((int)tableIDs.size() < m_batchSize) {
+        if (ready2Transmit->isEmpty()) {
+            if (holdBack && !writeDone.load(std::memory_order_acquire) && get_system_time_nanosecond() < deadline) {
+                // what is queued already must not wait for this batch
+                m_fpga->dev_flush(ch->m_id);
+                sched_yield();
+                continue;
             }
+            break;
+        }
+
+        int tableID = ready2Transmit->peek();
+        if (isBulk(tableID)) { break; }
+        PCIeTask* task = m_taskTable[tableID]->m_task;
+        if (task->m_basic != head->m_basic) { break; }
+        if (task->isData()) {
+            if (task->m_addr != nextAddr) { break; }
+            nextAddr += task->m_size;
+        }
+        // a batch never takes more than the whole input buffer of the card
+        if (m_hasCaps && slots + inputSlots(task) > m_caps.m_ibufferDepth) { break; }
+        slots += inputSlots(task);
+        ready2Transmit->dequeue();
+        tableIDs.push_back(tableID);
+    }
+    return head->m_basic;
+}
+
+// gather the task slots of a batch into the pinned request or data packet
+void Chimera::fillBatch(ChimeraChannel* ch, int pkt, const std::vector<int8_t>& tableIDs)
+{
+    for (int i = 0; i < tableIDs.size(); ++i) {
+        PCIeTask* task = m_taskTable[tableIDs[i]]->m_task;
+        if (task->isData()) {
+            [[maybe_unused]] int result = ch->m_osdDataPkt[pkt]->fillTask(i, *task);
+            assert(result == 0);
+        } else {
+            ch->m_osdReqPkt[pkt]->fillTask(i, *task);
+        }
+    }
+}
 
-            DPRINTF(Chimera, "[writeThread] pcie write request finished\n");
-            m_osdReqPkt->m_valid = 0x0;
+void Chimera::releaseTasks(ChimeraChannel* ch, const std::vector<int8_t>& tableIDs)
+{
+    for (int8_t tableID : tableIDs) {
+        TaskTraceRecord record = retireLifeCycle(tableID);
+        while (!ch->m_retiredTasks->enqueue(record)) {
+            m_auxWaiter.notify();
+            sched_yield();
         }
+        if (ch->m_retiredTasks->size() == std::max(m_taskTableNum / 2, 1)) { m_auxWaiter.notify(); }
+
+        releaseEntry(tableID);
+
+        m_taskTable[tableID]->m_valid = 0x0;
+        m_validTaskTableNum.fetch_add(1, std::memory_order_relaxed);
+        DPRINTF(Chimera, "the request dont need response, release task table entry: %d\n", tableID);
     }
-    DPRINTF(Chimera, "WRITE Thread Exit...\n");
 }
 
-void Chimera::collectThreadFunc()
+void Chimera::collectThreadFunc(ChimeraChannel* ch)
 {
     pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, NULL);
 
-    int threadCore = 6;
+    m_collectPlacement.apply("collect", ch->m_id);
 
-    cpu_set_t cpuset;
-    CPU_ZERO(&cpuset);                               
-    CPU_SET(threadCore, &cpuset);                    
-    sched_setaffinity(0, sizeof(cpu_set_t), &cpuset);
+    PollBackoff backoff(pollBackoffMax());
+    uint64_t    cpuTime = get_thread_cpu_time_nanosecond();
 
     while (true) {
         DPRINTF(
-            Chimera, "[readThread] acquiring for locks, osdTaskCounter: %d, readyDone: %d\n",
-            osdTaskCounter.load(std::memory_order_relaxed), readDone.load(std::memory_order_relaxed));
-        std::unique_lock<std::mutex> lock(readMTX);
-        readCV.wait(
-            lock, [this] { return osdTaskCounter.load(std::memory_order_relaxed) > 0 || readDone.load(std::memory_order_relaxed); });
+            Chimera, "[readThread %d] waiting for outstanding tasks, osdTaskCounter: %d, readyDone: %d\n", ch->m_id,
+            ch->m_osdTaskCounter.load(std::memory_order_relaxed), readDone.load(std::memory_order_relaxed));
+        ch->m_readWaiter.wait([&] {
+            return ch->m_osdTaskCounter.load(std::memory_order_acquire) > 0 || readDone.load(std::memory_order_acquire)
+                || (ch->m_id == 0 && m_creditRefresh.load(std::memory_order_acquire));
+        });
 
 
-        if (readDone.load(std::memory_order_relaxed)) {
-            DPRINTF(Chimera, "[readThread] readDone, this thread ready to exit\n");
+        if (readDone.load(std::memory_order_acquire)) {
+            DPRINTF(Chimera, "[readThread %d] readDone, this thread ready to exit\n", ch->m_id);
             break;
         }
 
-        if (!m_cdma_enable) {
-            DPRINTF(Chimera, "[readThread] issuing pcie read request\n");
-            uint64_t pre_latency = get_system_time_nanosecond();
-
-            m_fpga->dev_read(0x0, m_osdRespPkt->m_size, m_osdRespPkt);
+        // with CDMA, the reads of channel 0 and so the credit refresh are its
+        if (ch->m_id == 0) {
+            if (!m_cdma_enable) {
+                serviceCreditRefresh(ch->m_id);
+            } else if (ch->m_osdTaskCounter.load(std::memory_order_acquire) == 0) {
+                m_cdma->serviceCredits();
+            }
+        }
+        if (ch->m_osdTaskCounter.load(std::memory_order_acquire) == 0) { continue; }
 
-            [[maybe_unused]] int value = osdTaskCounter.fetch_sub(m_osdRespPkt->m_batch, std::memory_order_relaxed);
+        // CDMA readback streams through the first channel only
+        if (!m_cdma_enable || ch->m_id != 0) {
+            DPRINTF(Chimera, "[readThread %d] issuing pcie read request\n", ch->m_id);
+            uint64_t pre_latency = get_system_time_nanosecond();
 
+            PCIeRespPkt* pkt = ch->m_osdRespPkt;
+            m_fpga->dev_read(CHIMERA_REQ_WINDOW, pkt->m_size, pkt, ch->m_id);
 
             DPRINTF(Chimera, "------RESPONSE DETAIL--------\n");
-            DPRINTF(Chimera, "batch: %d\n", m_osdRespPkt->m_batch);
-            DPRINTF(Chimera, "task1.tableID: %d\n", m_osdRespPkt->m_results[0].m_tableID);
-            DPRINTF(Chimera, "task2.tableID: %d\n", m_osdRespPkt->m_results[1].m_tableID);
+            DPRINTF(Chimera, "batch: %d\n", pkt->m_batch);
+            DPRINTF(Chimera, "task1.tableID: %d\n", pkt->m_results[0].m_tableID);
+            DPRINTF(Chimera, "task2.tableID: %d\n", pkt->m_results[1].m_tableID);
             DPRINTF(Chimera, "---------------------------\n");
 
-            if (m_osdRespPkt->m_valid == 0x1) {
-                for (int i = 0; i < m_osdRespPkt->m_batch; ++i) {
-                    m_lifeCycleTable[m_osdRespPkt->m_results[i].m_tableID].m_pre_collectTime  = pre_latency;
-                    m_lifeCycleTable[m_osdRespPkt->m_results[i].m_tableID].m_post_collectTime = get_system_time_nanosecond();
+            if (pkt->m_valid == 0x1) {
+                ch->m_readBatches.add(pkt->m_batch);
+                for (int i = 0; i < pkt->m_batch; ++i) {
+                    int tableID = pkt->m_results[i].m_tableID;
+                    m_lifeCycleTable[tableID].m_pre_collectTime  = pre_latency;
+                    m_lifeCycleTable[tableID].m_post_collectTime = get_system_time_nanosecond();
+                    // the result may belong to a task submitted on another channel
+                    channelOf(tableID)->m_osdTaskCounter.fetch_sub(1, std::memory_order_relaxed);
                 }
-                DPRINTF(Chimera, "[readThread] fetch valid response, notify auxThread\n");
-                assert(ready2Response->enqueue(*m_osdRespPkt));
-
-                DPRINTF(Chimera, "[readThread] to notify auxThread\n");
-                auxCV.notify_one();
+                if (m_hasCaps && !m_cdma_enable) { m_outputHeld.fetch_sub(pkt->m_batch, std::memory_order_relaxed); }
+                DPRINTF(Chimera, "[readThread %d] fetch valid response, notify auxThread\n", ch->m_id);
+                [[maybe_unused]] bool queued = ready2Response->enqueue(ch->m_osdRespSlot);
+                assert(queued);
+
+                DPRINTF(Chimera, "[readThread %d] to notify auxThread\n", ch->m_id);
+                m_auxWaiter.notify();
+
+                // the aux thread owns that slot now, collect into a free one
+                while (!ch->m_freeRespSlot->tryDequeue(ch->m_osdRespSlot)) { sched_yield(); }
+                ch->m_osdRespPkt = respSlot(ch->m_osdRespSlot);
+                backoff.reset();
+                accountCpuTime(cpuTime);
             } else {
-                DPRINTF(Chimera, "[readThread] fetch invalid response, ready to fetch again\n");
+                DPRINTF(Chimera, "[readThread %d] fetch invalid response, ready to fetch again\n", ch->m_id);
+                m_stats->pcieEmptyReads += 1;
+                waitCompletion(ch->m_id, backoff);
             }
 
-            m_osdRespPkt->m_valid = 0x0;
+            ch->m_osdRespPkt->m_valid = 0x0;
         } else {
             m_cdma->execute();
             disableCDMA();
         }
     }
 
-    assert(osdTaskCounter.load(std::memory_order_relaxed) == 0);
-    DPRINTF(Chimera, "READ Thread Exit...\n");
+    accountCpuTime(cpuTime);
+    assert(ch->m_osdTaskCounter.load(std::memory_order_relaxed) == 0);
+    DPRINTF(Chimera, "READ Thread %d Exit...\n", ch->m_id);
+}
+
+/**
+ * Pause a collect thread after an empty read of the response window. In
+ * interrupt mode it blocks until the transport signals a completion, for
+ * at most pollBackoffMax ns in case an interrupt is lost; otherwise it
+ * sleeps for the next backoff period, which in poll mode is always 0.
+ */
+void Chimera::waitCompletion(int channel, PollBackoff& backoff)
+{
+    Transport* transport = m_fpga->getTransport();
+    if (m_completionMode == ChimeraCompletion::interrupt && transport->hasEvents()) {
+        transport->waitEvent(channel, m_pollBackoffMax);
+        return;
+    }
+
+    uint64_t pause = backoff.next();
+    if (pause > 0) { std::this_thread::sleep_for(std::chrono::nanoseconds(pause)); }
+}
+
+// add the CPU time the calling thread used since last
+void Chimera::accountCpuTime(uint64_t& last)
+{
+    uint64_t now = get_thread_cpu_time_nanosecond();
+    m_workerCpuTime.fetch_add(now - last, std::memory_order_relaxed);
+    last = now;
 }
 
 void Chimera::auxThreadFunc()
 {
     pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, NULL);
 
-    int threadCore = 5;
+    m_auxPlacement.apply("aux");
 
-    cpu_set_t cpuset;
-    CPU_ZERO(&cpuset);                               
-    CPU_SET(threadCore, &cpuset);                    
-    sched_setaffinity(0, sizeof(cpu_set_t), &cpuset);
+    uint64_t          cpuTime = get_thread_cpu_time_nanosecond();
+    std::vector<bool> respNotify;
 
     while (true) {
-        DPRINTF(Chimera, "[auxThread] acquiring for locks\n");
-        std::unique_lock<std::mutex> lock(auxMTX);
-        auxCV.wait(lock, [this] { return !comeInList->isEmpty() || !ready2Response->isEmpty() || auxDone; });
+        DPRINTF(Chimera, "[auxThread] waiting for tasks or responses\n");
+        m_auxWaiter.wait([this] {
+            if (!comeInList->isEmpty() || !ready2Response->isEmpty() || auxDone.load(std::memory_order_acquire)) {
+                return true;
+            }
+            for (auto ch : m_channels) {
+                if (ch->m_retiredTasks->size() >= std::max(m_taskTableNum / 2, 1)) { return true; }
+            }
+            return false;
+        });
         DPRINTF(Chimera, "[auxThread] active, ready to work\n");
-        if (!comeInList->isEmpty()) {
+        while (!comeInList->isEmpty()) {
             DPRINTF(Chimera, "[auxThread] comeInList has outstanging task, ready to fetch\n");
 
-            PCIeTask handlingTask = comeInList->dequeue();
-            int      tableID      = handlingTask.m_tableID;
+            int tableID = comeInList->dequeue();
 
-            m_taskTable[tableID]->m_valid   = 0x1;
-            m_taskTable[tableID]->m_taskUID = m_totalTaskID++;
-            m_taskTable[tableID]->m_task = handlingTask;
+            if (!isBulk(tableID)) {
+                m_taskTable[tableID]->m_valid   = 0x1;
+                m_taskTable[tableID]->m_taskUID = m_totalTaskID++;
 
-            m_validTaskTableNum.fetch_sub(1, std::memory_order_relaxed);
-            assert(ready2Transmit->enqueue(handlingTask));
+                m_validTaskTableNum.fetch_sub(1, std::memory_order_relaxed);
+            }
+            ChimeraChannel* ch = channelOf(tableID);
+            [[maybe_unused]] bool queued = ch->m_ready2Transmit->enqueue(tableID);
+            assert(queued);
             DPRINTF(Chimera, "[auxThread] alloc task table entry\n");
-            DPRINTF(Chimera, "[auxThread] insert the task into ready2transimit and notify write thread\n");
+            DPRINTF(Chimera, "[auxThread] insert the task into ready2transimit and notify write thread %d\n", ch->m_id);
 
             DPRINTF(Chimera, "[auxThread] to notify writeThread\n");
-            writeCV.notify_one();
+            ch->m_writeWaiter.notify();
         }
 
-        if (!ready2Response->isEmpty()) {
-            PCIeRespPkt pkt = ready2Response->dequeue();
+        while (!ready2Response->isEmpty()) {
+            int          slot = ready2Response->dequeue();
+            PCIeRespPkt& pkt  = *respSlot(slot);
 
-            std::list<int> ready2CompleteList;
+            respNotify.assign(m_devices.size(), false);
             for (int i = 0; i < pkt.m_batch; ++i) {
                 int tableID = pkt.m_results[i].m_tableID;
                 
                 m_lifeCycleTable[tableID].m_respTime = get_system_time_nanosecond();
                 m_lifeCycleTable[tableID].m_post_hwTime = pkt.m_results[i].m_executedTime;
-                submitLifeCycle(tableID);
-
-                assert(m_idleTaskTableID.enqueue(tableID));
+                accountTask(retireLifeCycle(tableID));
 
-                parentRetryCallback();
-
-                m_taskTable[tableID]->m_result   = pkt.m_results[i];
-                m_taskTable[tableID]->m_complete = true;
-                ready2CompleteList.push_back(tableID);
+                publishResult(tableID, pkt.m_results[i]);
+                int device = m_taskTable[tableID]->m_device;
+                if (device >= 0) { respNotify[device] = true; }
             }
+            // back to the channel that read it; never full, it has a place
+            // for every slot of its channel
+            m_channels[slot / m_respSlotNum]->m_freeRespSlot->enqueue(slot);
+            DPRINTF(Chimera, "[auxThread] published the results and notify the devices\n");
 
-            std::lock_guard<std::mutex> lock(fetchMTX);
-            completeList.splice(completeList.end(), ready2CompleteList);
-            completeListUpdated = true;
-            DPRINTF(Chimera, "[auxThread] insert the task into completeList and notify gem5 thread\n");
-
-            DPRINTF(Chimera, "[auxThread] to notify gem5Thread\n");
-            fetchCV.notify_one();
+            for (int device = 0; device < respNotify.size(); ++device) {
+                if (respNotify[device]) { m_devices[device]->m_device->notifyResponse(); }
+            }
         }
+        sampleWorkerStats();
+        accountCpuTime(cpuTime);
 
         if (auxDone.load(std::memory_order_relaxed)) {
             if (!writeDone.load(std::memory_order_relaxed) && comeInList->isEmpty()) {
-                writeDone.store(true, std::memory_order_relaxed);
+                writeDone.store(true, std::memory_order_release);
 
                 DPRINTF(Chimera, "[auxThread] to notify writeThread\n");
-                writeCV.notify_one();
+                for (auto ch : m_channels) { ch->m_writeWaiter.notify(); }
             }
 
             if (!readDone.load(std::memory_order_relaxed) && m_validTaskTableNum.load(std::memory_order_relaxed) == m_taskTableNum) {
-                readDone.store(true, std::memory_order_relaxed);
+                readDone.store(true, std::memory_order_release);
 
                 DPRINTF(Chimera, "[auxThread] to notify readThread\n");
-                readCV.notify_one();
+                for (auto ch : m_channels) { ch->m_readWaiter.notify(); }
             } else {
                 DPRINTF(
                     Chimera, "readyDone: %d, m_validTaskTableNum: %d\n", readDone.load(std::memory_order_relaxed),
                     m_validTaskTableNum.load(std::memory_order_relaxed));
-                while (!m_idleTaskTableID.isEmpty()) { DPRINTF(Chimera, "remain valid table id: %d\n", m_idleTaskTableID.dequeue()); }
+                DPRINTF(Chimera, "remain idle table ids: %d\n", m_idleTaskTableID.size());
             }
             sleep(2);
         }
@@ -356,125 +809,448 @@ void Chimera::auxThreadFunc()
             break;
         }
     }
+    accountCpuTime(cpuTime);
     DPRINTF(Chimera, "AUX Thread Exit...\n");
 }
 
-bool Chimera::isFullAndMark()
+int Chimera::registerDevice(ChimeraClient* device, const std::string& client_name, int quota)
 {
-    bool result = m_idleTaskTableID.isEmpty();
-    if (result) { m_parent_retry = true; }
-    return result;
+    if (quota < 0 || quota > m_taskTableNum) {
+        fatal("chimera: task quota %d of %s is outside [0, %d]\n", quota, client_name, m_taskTableNum);
+    }
+    if (m_devices.size() > UINT8_MAX) { fatal("chimera: too many devices share one engine\n"); }
+
+    RegisteredDevice* dev = new RegisteredDevice();
+    dev->m_device         = device;
+    dev->m_quota          = quota;
+    m_devices.push_back(dev);
+    DPRINTF(Chimera, "device %s registered as %d, quota %d\n", client_name, m_devices.size() - 1, quota);
+    return m_devices.size() - 1;
 }
 
-int Chimera::recvTask(PCIeTask task)
+bool Chimera::isFullAndMark(int device)
 {
-    while (true) {
-        if (!m_idleTaskTableID.isEmpty()) { break; }
-    }
+    if (device < 0) { return m_idleTaskTableID.isEmpty(); }
+
+    RegisteredDevice* dev = m_devices[device];
+    if (!deviceFull(dev)) { return false; }
+
+    // flag first, then look again: an entry released in between is either
+    // seen here or sees the flag, so the retry cannot be lost
+    dev->m_retry.store(true, std::memory_order_seq_cst);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (deviceFull(dev)) { return true; }
+    dev->m_retry.store(false, std::memory_order_relaxed);
+    return false;
+}
 
-    int id = m_idleTaskTableID.dequeue();
+PCIeTask* Chimera::tryAllocTask(int device)
+{
+    // the gem5 thread is the only consumer, so an entry seen is an entry got
+    int id;
+    if (isFullAndMark(device) || !m_idleTaskTableID.tryDequeue(id)) { return nullptr; }
+    if (device >= 0) { m_devices[device]->m_held.fetch_add(1, std::memory_order_relaxed); }
+
+    m_taskTable[id]->m_device = device;
+    PCIeTask* task            = m_taskTable[id]->m_task;
+    *task                     = PCIeTask();
+    task->m_tableID           = id;
+    return task;
+}
 
-    assert(task.isValid());
-    task.m_tableID = id;
+int Chimera::submitTask(PCIeTask* task)
+{
+    int id = task->m_tableID;
+    assert(task == m_taskTable[id]->m_task);
+    assert(task->isValid());
 
     m_taskTable[id]->m_enqueueTime = curCycle();
 
     assert(!m_lifeCycleTable[id].m_valid);
 
     m_lifeCycleTable[id].m_valid    = true;
+    m_lifeCycleTable[id].m_needResp = task->isNeedResp();
     m_lifeCycleTable[id].m_recvTime = get_system_time_nanosecond();
-    m_lifeCycleTable[id].m_pre_hwTime = task.m_insertTime;
+    m_lifeCycleTable[id].m_pre_hwTime = task->m_insertTime;
 
-    assert(comeInList->enqueue(task));
+    [[maybe_unused]] bool queued = comeInList->enqueue(id);
+    assert(queued);
     DPRINTF(Chimera, "insert the task into comeInList (id: %d), notify auxThread\n", id);
 
     DPRINTF(Chimera, "[gem5Thread] to notify auxThread\n");
-    auxCV.notify_one();
+    m_auxWaiter.notify();
     return id;
 }
 
+bool Chimera::bulkFull(int segments)
+{
+    return m_idleBulk.isEmpty() || m_bulkFreeSegments.load(std::memory_order_acquire) < segments;
+}
+
+// as isFullAndMark(), for room in the bulk pool
+bool Chimera::bulkFullAndMark(int device, int segments)
+{
+    if (!bulkFull(segments)) { return false; }
+    if (device < 0) { return true; }
+
+    RegisteredDevice* dev = m_devices[device];
+    dev->m_retry.store(true, std::memory_order_seq_cst);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (bulkFull(segments)) { return true; }
+    dev->m_retry.store(false, std::memory_order_relaxed);
+    return false;
+}
+
+bool Chimera::submitBulk(int device, uint64_t addr, const uint8_t* data, uint64_t size)
+{
+    assert(size > 0 && size <= m_bulkMaxTransfer);
+    int segments = (size + CHIMERA_BULK_SEGMENT_SIZE - 1) / CHIMERA_BULK_SEGMENT_SIZE;
+    if (bulkFullAndMark(device, segments)) { return false; }
+
+    // the simulation thread is the only consumer, so what bulkFull() saw
+    // is there to take
+    int index = m_idleBulk.dequeue();
+    m_bulkFreeSegments.fetch_sub(segments, std::memory_order_relaxed);
+
+    BulkTransfer& bulk = m_bulk[index];
+    bulk.m_stream      = device >= 0 ? device : 0;
+    bulk.m_addr        = addr;
+    bulk.m_size        = size;
+    bulk.m_segments.clear();
+    bulk.m_iov.clear();
+    bulk.m_issued     = 0;
+    bulk.m_nextIov    = 0;
+    bulk.m_nextOffset = 0;
+    for (uint64_t offset = 0; offset < size; offset += CHIMERA_BULK_SEGMENT_SIZE) {
+        int      segment = m_idleSegments.dequeue();
+        uint8_t* base    = m_bulkPool->slot(segment);
+        uint64_t bytes   = std::min<uint64_t>(CHIMERA_BULK_SEGMENT_SIZE, size - offset);
+        std::memcpy(base, data + offset, bytes);
+        bulk.m_segments.push_back(segment);
+
+        iovec* last = bulk.m_iov.empty() ? nullptr : &bulk.m_iov.back();
+        if (last && static_cast<uint8_t*>(last->iov_base) + last->iov_len == base) {
+            last->iov_len += bytes;
+        } else {
+            bulk.m_iov.push_back({base, bytes});
+        }
+    }
+
+    [[maybe_unused]] bool queued = comeInList->enqueue(m_taskTableNum + index);
+    assert(queued);
+    DPRINTF(Chimera, "bulk transfer %d of %d bytes to %#x queued, %d segments\n", index, size, addr, segments);
+    m_auxWaiter.notify();
+    return true;
+}
+
+// the segments go back before the transfer, so a device that finds a free
+// transfer also finds the segments it had
+void Chimera::releaseBulk(int index)
+{
+    BulkTransfer& bulk = m_bulk[index];
+    // never full, there is a place for every segment
+    for (int segment : bulk.m_segments) { m_idleSegments.enqueue(segment); }
+    m_bulkFreeSegments.fetch_add(bulk.m_segments.size(), std::memory_order_release);
+
+    [[maybe_unused]] bool released = m_idleBulk.enqueue(index);
+    assert(released);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    retryDevices();
+}
+
+int Chimera::recvTask(PCIeTask task, int device)
+{
+    assert(task.isValid());
+
+    PCIeTask* slot = tryAllocTask(device);
+    if (!slot) { return -1; }
+
+    int       id    = slot->m_tableID;
+    *slot           = task;
+    slot->m_tableID = id;
+    return submitTask(slot);
+}
+
+void Chimera::startup()
+{
+    ClockedObject::startup();
+
+    // the devices registered in their init()
+    if (m_channels.size() > std::max<size_t>(m_devices.size(), 1)) {
+        warn("chimera: %d channels for %d devices; a device keeps to one channel, so %d of them stay idle\n",
+             m_channels.size(), m_devices.size(), m_channels.size() - std::max<size_t>(m_devices.size(), 1));
+    }
+}
+
 void Chimera::simBegin()
 {
+    // the reset empties the card buffers and its drained count
     m_fpga->dev_init();
+    m_inputIssued.store(0, std::memory_order_relaxed);
+    m_inputConsumed.store(0, std::memory_order_relaxed);
+    m_outputHeld.store(0, std::memory_order_relaxed);
 }
 
 void Chimera::simExit()
 {
-    auxDone.store(true, std::memory_order_relaxed);
+    // CDMA readback runs until told to stop, and holds a collect thread
+    m_cdma->stop();
+    auxDone.store(true, std::memory_order_release);
 
     DPRINTF(Chimera, "[gem5Thread] to notify auxThread (ready to exit)\n");
-    auxCV.notify_one();
+    m_auxWaiter.notify();
 
     auxThread.join();
-    readThread.join();
-    writeThread.join();
+    for (auto ch : m_channels) {
+        ch->m_readThread.join();
+        ch->m_writeThread.join();
+    }
+    // what the submit threads retired after the aux thread left
+    sampleWorkerStats();
 }
 
-std::pair<PCIeResult, uint64_t> Chimera::fetchResp(int id)
+bool Chimera::isDrained()
 {
-    while (true) {
-        DPRINTF(Chimera, "[gem5Thread] trying to fetch response\n");
+    // the simulation thread is the only one taking entries, so none can
+    // leave while this looks; results waiting to be fetched hold theirs
+    return m_idleTaskTableID.size() + pendingResults() == m_taskTableNum && comeInList->isEmpty()
+        && m_bulkFreeSegments.load(std::memory_order_acquire) == (m_bulkPool ? m_bulkPool->slotNum() : 0);
+}
+
+void Chimera::checkDrained()
+{
+    if (isDrained()) {
+        DPRINTF(Drain, "%s drained\n", name());
+        signalDrainDone();
+    } else {
+        schedule(m_drainEvent, clockEdge(Cycles(CHIMERA_DRAIN_POLL_CYCLES)));
+    }
+}
 
-        bool       findResponse = false;
+DrainState Chimera::drain()
+{
+    if (isDrained()) { return DrainState::Drained; }
+    schedule(m_drainEvent, clockEdge(Cycles(CHIMERA_DRAIN_POLL_CYCLES)));
+    return DrainState::Draining;
+}
+
+void Chimera::serialize(CheckpointOut& cp) const
+{
+    warn_once("chimera: checkpoints do not hold the state of the IP on the %s transport\n",
+              m_fpga->getTransport()->name());
+
+    SERIALIZE_SCALAR(m_totalTaskID);
+
+    std::vector<int>      complete_tableIDs, complete_devices;
+    std::vector<uint64_t> complete_enqueueTimes;
+    std::vector<uint8_t>  complete_results;
+    for (const CompletionSlot& slot : m_completions) {
+        if (!slot.m_ready.load(std::memory_order_acquire)) { continue; }
+        const CompletedTask& done = slot.m_done;
+        complete_tableIDs.push_back(done.m_tableID);
+        complete_devices.push_back(done.m_device);
+        complete_enqueueTimes.push_back(done.m_enqueueTime);
+        const uint8_t* result = reinterpret_cast<const uint8_t*>(&done.m_result);
+        complete_results.insert(complete_results.end(), result, result + sizeof(PCIeResult));
+    }
+    SERIALIZE_CONTAINER(complete_tableIDs);
+    SERIALIZE_CONTAINER(complete_devices);
+    SERIALIZE_CONTAINER(complete_enqueueTimes);
+    SERIALIZE_CONTAINER(complete_results);
+
+    // results the collect thread reads back after this are not included
+    bool     cdma_enabled = m_cdma->getStatus();
+    uint64_t cdma_addr    = m_cdma->getAddr();
+    uint64_t cdma_size    = m_cdma->getSize();
+    SERIALIZE_SCALAR(cdma_enabled);
+    SERIALIZE_SCALAR(cdma_addr);
+    SERIALIZE_SCALAR(cdma_size);
+    std::vector<uint8_t> cdma_data(m_cdma->pendingData(), m_cdma->pendingData() + m_cdma->getRemain());
+    SERIALIZE_CONTAINER(cdma_data);
+}
+
+void Chimera::unserialize(CheckpointIn& cp)
+{
+    UNSERIALIZE_SCALAR(m_totalTaskID);
+
+    std::vector<int>      complete_tableIDs, complete_devices;
+    std::vector<uint64_t> complete_enqueueTimes;
+    std::vector<uint8_t>  complete_results;
+    UNSERIALIZE_CONTAINER(complete_tableIDs);
+    UNSERIALIZE_CONTAINER(complete_devices);
+    UNSERIALIZE_CONTAINER(complete_enqueueTimes);
+    UNSERIALIZE_CONTAINER(complete_results);
+    fatal_if(complete_results.size() != complete_tableIDs.size() * sizeof(PCIeResult),
+             "chimera: checkpoint results do not match this build\n");
+    // the engine is drained, so every entry is idle; a result waiting to be
+    // fetched takes its entry back out of the idle ring and holds it as
+    // valid, counted against its device's quota
+    std::vector<bool> held(m_taskTableNum, false);
+    for (int i = 0; i < complete_tableIDs.size(); ++i) {
+        int             tableID = complete_tableIDs[i];
+        taskTableEntry* entry   = m_taskTable[tableID];
+        entry->m_device         = complete_devices[i];
+        entry->m_enqueueTime    = complete_enqueueTimes[i];
+        entry->m_valid          = 0x1;
+        std::memcpy(&entry->m_result, &complete_results[i * sizeof(PCIeResult)], sizeof(PCIeResult));
+        publishResult(tableID, entry->m_result);
+
+        held[tableID] = true;
+        if (entry->m_device >= 0) { m_devices[entry->m_device]->m_held.fetch_add(1, std::memory_order_relaxed); }
+        m_validTaskTableNum.fetch_sub(1, std::memory_order_relaxed);
+    }
+    std::vector<int> idle;
+    int              tableID;
+    while (m_idleTaskTableID.tryDequeue(tableID)) { idle.push_back(tableID); }
+    for (int id : idle) {
+        if (!held[id]) { m_idleTaskTableID.enqueue(id); }
+    }
 
-        std::pair<PCIeResult, uint64_t> final;
+    bool                 cdma_enabled;
+    uint64_t             cdma_addr, cdma_size;
+    std::vector<uint8_t> cdma_data;
+    UNSERIALIZE_SCALAR(cdma_enabled);
+    UNSERIALIZE_SCALAR(cdma_addr);
+    UNSERIALIZE_SCALAR(cdma_size);
+    UNSERIALIZE_CONTAINER(cdma_data);
+    if (cdma_enabled) {
+        // refilled before the collect thread is woken up to read on
+        m_cdma->enable(cdma_addr, cdma_size);
+        m_cdma->restore(cdma_data.data(), cdma_data.size());
+        m_channels[0]->m_osdTaskCounter.fetch_add(1, std::memory_order_release);
+        m_channels[0]->m_readWaiter.notify();
+    }
+}
 
-        std::unique_lock<std::mutex> lock(fetchMTX);
-        for (std::list<int>::iterator it = completeList.begin(); it != completeList.end(); ++it) {
-            completeListUpdated = false;
-            if (*it == id) {
-                findResponse = true;
-                final.first              = m_taskTable[id]->m_result;
-                final.second             = m_taskTable[id]->m_enqueueTime;
+void Chimera::publishResult(int tableID, const PCIeResult& result)
+{
+    taskTableEntry* entry = m_taskTable[tableID];
+    entry->m_result       = result;
+    entry->m_complete     = true;
+
+    CompletionSlot& slot = m_completions[tableID];
+    slot.m_done          = {tableID, entry->m_device, result, entry->m_enqueueTime};
+    slot.m_ready.store(true, std::memory_order_release);
+    m_readyMask[tableID / 64].fetch_or(1ULL << (tableID % 64), std::memory_order_release);
+}
 
-                m_taskTable[id]->m_valid = 0x0;
-                m_validTaskTableNum.fetch_add(1, std::memory_order_relaxed);
+void Chimera::retireResult(int tableID)
+{
+    // the slot is emptied before the entry is released, after which the aux
+    // thread may publish the next result of the entry into it
+    m_completions[tableID].m_ready.store(false, std::memory_order_relaxed);
+    m_readyMask[tableID / 64].fetch_and(~(1ULL << (tableID % 64)), std::memory_order_relaxed);
+
+    m_taskTable[tableID]->m_complete = false;
+    m_taskTable[tableID]->m_valid    = 0x0;
+    releaseEntry(tableID);
+    m_validTaskTableNum.fetch_add(1, std::memory_order_relaxed);
+    DPRINTF(Chimera, "[gem5Thread] fetched the response of task table entry %d\n", tableID);
+}
 
-                DPRINTF(Chimera, "[auxThread] release task table entry\n");
+int Chimera::pendingResults()
+{
+    int pending = 0;
+    for (const std::atomic<uint64_t>& word : m_readyMask) { pending += popCount(word.load(std::memory_order_relaxed)); }
+    return pending;
+}
 
-                completeList.erase(it);
+bool Chimera::tryFetchResp(int id, std::pair<PCIeResult, uint64_t>& resp)
+{
+    const CompletionSlot& slot = m_completions[id];
+    if (!slot.m_ready.load(std::memory_order_acquire)) { return false; }
 
-                DPRINTF(Chimera, "[gem5Thread] to notify auxThread\n");
-                auxCV.notify_one();
-                break;
-            }
-        }
+    resp.first  = slot.m_done.m_result;
+    resp.second = slot.m_done.m_enqueueTime;
+    retireResult(id);
 
-        if (!findResponse) {
-            DPRINTF(Chimera, "[gem5Thread] dont find response, ready to sleep\n");
-            fetchCV.wait(lock, [this] { return !completeList.empty() && completeListUpdated; });
-        } else {
-            DPRINTF(Chimera, "[gem5Thread] find the response, return it\n");
-            return final;
+    DPRINTF(Chimera, "[gem5Thread] to notify auxThread\n");
+    m_auxWaiter.notify();
+    return true;
+}
+
+int Chimera::harvestResps(int device, std::vector<CompletedTask>& done)
+{
+    int count = 0;
+    for (int word = 0; word < m_readyMask.size(); ++word) {
+        uint64_t ready = m_readyMask[word].load(std::memory_order_acquire);
+        while (ready) {
+            int tableID = word * 64 + ctz64(ready);
+            ready &= ready - 1;
+
+            const CompletionSlot& slot = m_completions[tableID];
+            if (slot.m_done.m_device != device) { continue; }
+            done.push_back(slot.m_done);
+            retireResult(tableID);
+            count++;
         }
     }
+
+    if (count > 0) {
+        DPRINTF(Chimera, "[gem5Thread] harvested %d responses of device %d, to notify auxThread\n", count, device);
+        m_auxWaiter.notify();
+    }
+    return count;
 }
 
-void Chimera::parentRetryCallback()
+void Chimera::releaseEntry(int tableID)
 {
-    if (m_parent_retry) {
-        if (m_parent_name == "mpeg2encoder") {
-            Mpeg2Encoder* parent = static_cast<Mpeg2Encoder*>(m_parent);
-            parent->retryCallback();
-        } else {
-            assert(false);
-        }
-        m_parent_retry = false;
+    int device = m_taskTable[tableID]->m_device;
+    if (device >= 0) { m_devices[device]->m_held.fetch_sub(1, std::memory_order_relaxed); }
+
+    [[maybe_unused]] bool released = m_idleTaskTableID.enqueue(tableID);
+    assert(released);
+    // pairs with the fence in isFullAndMark()
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    retryDevices();
+}
+
+void Chimera::retryDevices()
+{
+    // the entry is free for any device, so every device that ran out is
+    // given another go, not only the one that held it. This runs on worker
+    // threads; retry() itself is run by the device's event in the
+    // simulation thread
+    for (RegisteredDevice* dev : m_devices) {
+        if (dev->m_retry.exchange(false, std::memory_order_relaxed)) { dev->m_device->notifyRetry(); }
     }
 }
 
+void scheduleFromWorker(EventQueue* eq, Event* event)
+{
+    // the queue lock keeps the event loop out while the event goes in, and
+    // the thread borrows the queue as its own so tracing sees the
+    // simulated time. It is scheduled at the queue's current tick, which
+    // the simulation thread has not moved past yet
+    if (curEventQueue() == eq) {
+        // already in the simulation thread, which holds the lock
+        if (!event->scheduled()) { eq->schedule(event, eq->getCurTick()); }
+        return;
+    }
+
+    std::lock_guard<EventQueue> lock(*eq);
+    EventQueue* prev = curEventQueue();
+    curEventQueue(eq);
+    if (!event->scheduled()) { eq->schedule(event, eq->getCurTick()); }
+    curEventQueue(prev);
+}
+
 void Chimera::enableCDMA(uint64_t addr, uint64_t size)
 {
     m_cdma->enable(addr, size);
-    [[maybe_unused]] int value = osdTaskCounter.fetch_add(1, std::memory_order_relaxed);
-    readCV.notify_one();
+    [[maybe_unused]] int value = m_channels[0]->m_osdTaskCounter.fetch_add(1, std::memory_order_release);
+    m_channels[0]->m_readWaiter.notify();
 }
 
 void Chimera::disableCDMA()
 {
     m_cdma->disable();
-    [[maybe_unused]] int value = osdTaskCounter.fetch_sub(m_osdRespPkt->m_batch, std::memory_order_relaxed);
-    readCV.notify_one();
+    ChimeraChannel* ch = m_channels[0];
+    // drop the count enableCDMA() took
+    [[maybe_unused]] int value = ch->m_osdTaskCounter.fetch_sub(1, std::memory_order_relaxed);
+    ch->m_readWaiter.notify();
 }
 
 
@@ -485,7 +1261,24 @@ Chimera::ChimeraStats::ChimeraStats(Chimera& c, const std::string& name) :
     ADD_STAT(postFlow, statistics::units::Count::get(), "pcie read -> send resp"),
     ADD_STAT(pcieSubmit, statistics::units::Count::get(), "pcie write"),
     ADD_STAT(pcieCollect, statistics::units::Count::get(), "pcie read (warn)"),
-    ADD_STAT(hardwareExecution, statistics::units::Count::get(), "hardware execution time")
+    ADD_STAT(hardwareExecution, statistics::units::Count::get(), "hardware execution time"),
+    ADD_STAT(pcieWrites, statistics::units::Count::get(), "pcie write requests (one per batch)"),
+    ADD_STAT(pcieReads, statistics::units::Count::get(), "valid pcie read responses (one per batch)"),
+    ADD_STAT(pcieEmptyReads, statistics::units::Count::get(), "pcie reads that found no result"),
+    ADD_STAT(creditStalls, statistics::units::Count::get(), "pcie writes that waited for room on the card"),
+    ADD_STAT(creditRefreshes, statistics::units::Count::get(), "reads of the drained count of the card"),
+    ADD_STAT(bulkTransfers, statistics::units::Count::get(), "bulk data-plane transfers"),
+    ADD_STAT(bulkBytes, statistics::units::Byte::get(), "bytes of the bulk data-plane transfers"),
+    ADD_STAT(workerCpuTime, statistics::units::Count::get(), "CPU time used by the worker threads (ns)"),
+    ADD_STAT(cpuTimePerTask, statistics::units::Count::get(), "worker CPU time per handled task (ns)"),
+    ADD_STAT(preFlowLatency, statistics::units::Count::get(), "recv task -> pcie write, per task (ns)"),
+    ADD_STAT(pcieSubmitLatency, statistics::units::Count::get(), "pcie write, per task (ns)"),
+    ADD_STAT(pcieCollectLatency, statistics::units::Count::get(), "pcie read, per task with a response (ns)"),
+    ADD_STAT(postFlowLatency, statistics::units::Count::get(), "pcie read -> send resp, per task with a response (ns)"),
+    ADD_STAT(taskLatency, statistics::units::Count::get(), "recv task -> resp, or -> pcie write without one (ns)"),
+    ADD_STAT(hardwareCycles, statistics::units::Count::get(), "card cycles per task with a response"),
+    ADD_STAT(writeBatch, statistics::units::Count::get(), "tasks per pcie write"),
+    ADD_STAT(readBatch, statistics::units::Count::get(), "results per valid pcie read")
 {
 
 }
@@ -503,19 +1296,79 @@ Chimera::ChimeraStats::regStats()
     pcieSubmit.flags(total | nozero);
     pcieCollect.flags(total | nozero);
     hardwareExecution.flags(total | nozero);
+    pcieWrites.flags(total | nozero);
+    pcieReads.flags(total | nozero);
+    pcieEmptyReads.flags(total | nozero);
+
+    workerCpuTime.functor([this]() { return parent.m_workerCpuTime.load(std::memory_order_relaxed); });
+    cpuTimePerTask = workerCpuTime / handleCount;
+
+    preFlowLatency.init(CHIMERA_LATENCY_BUCKETS).flags(statistics::pdf | statistics::nozero);
+    pcieSubmitLatency.init(CHIMERA_LATENCY_BUCKETS).flags(statistics::pdf | statistics::nozero);
+    pcieCollectLatency.init(CHIMERA_LATENCY_BUCKETS).flags(statistics::pdf | statistics::nozero);
+    postFlowLatency.init(CHIMERA_LATENCY_BUCKETS).flags(statistics::pdf | statistics::nozero);
+    taskLatency.init(CHIMERA_LATENCY_BUCKETS).flags(statistics::pdf | statistics::nozero);
+    hardwareCycles.init(CHIMERA_LATENCY_BUCKETS).flags(statistics::pdf | statistics::nozero);
+
+    writeBatch.init(1, MAX_BATCH_THRESHOLD, 1).flags(statistics::pdf | statistics::nozero);
+    readBatch.init(1, MAX_BATCH_THRESHOLD, 1).flags(statistics::pdf | statistics::nozero);
 }
 
-void
-Chimera::printBatchRecord()
+TaskTraceRecord Chimera::retireLifeCycle(int tableID)
+{
+    LifeCycle& entry = m_lifeCycleTable[tableID];
+    assert(entry.m_valid);
+    entry.m_valid = false;
+
+    taskTableEntry* task = m_taskTable[tableID];
+    return {task->m_taskUID, tableID, task->m_device, channelOf(tableID)->m_id, entry};
+}
+
+void Chimera::accountTask(const TaskTraceRecord& record)
 {
-    for (int i = 0; i < m_rdBatch_record.size(); ++i) {
-        std::cout << "rdBatch_record: " << m_rdBatch_record.front() << std::endl;
-        m_rdBatch_record.pop_front();
+    const LifeCycle& entry = record.m_life;
+
+    m_stats->handleCount += 1;
+    m_stats->preFlow += (entry.m_pre_submitTime - entry.m_recvTime);
+    m_stats->pcieSubmit += (entry.m_post_submitTime - entry.m_pre_submitTime);
+    m_stats->preFlowLatency.sample(entry.m_pre_submitTime - entry.m_recvTime);
+    m_stats->pcieSubmitLatency.sample(entry.m_post_submitTime - entry.m_pre_submitTime);
+
+    if (entry.m_needResp) {
+        m_stats->pcieCollect += (entry.m_post_collectTime - entry.m_pre_collectTime);
+        m_stats->postFlow += (entry.m_respTime - entry.m_post_collectTime);
+        m_stats->hardwareExecution += (entry.m_post_hwTime - entry.m_pre_hwTime);
+        m_stats->pcieCollectLatency.sample(entry.m_post_collectTime - entry.m_pre_collectTime);
+        m_stats->postFlowLatency.sample(entry.m_respTime - entry.m_post_collectTime);
+        m_stats->hardwareCycles.sample(entry.m_post_hwTime - entry.m_pre_hwTime);
+        m_stats->taskLatency.sample(entry.m_respTime - entry.m_recvTime);
+    } else {
+        m_stats->taskLatency.sample(entry.m_post_submitTime - entry.m_recvTime);
     }
 
-    for (int j = 0; j < m_wrBatch_record.size(); ++j) {
-        std::cout << "wrBatch_record: " << m_wrBatch_record.front() << std::endl;
-        m_wrBatch_record.pop_front();
+    if (m_traceLog) { m_traceLog->log(record); }
+}
+
+void Chimera::sampleBatches(BatchCounter& counter, statistics::Scalar& transfers, statistics::Distribution& batches)
+{
+    for (int batch = 1; batch <= MAX_BATCH_THRESHOLD; ++batch) {
+        uint64_t count = counter.m_count[batch].load(std::memory_order_relaxed);
+        if (count == counter.m_sampled[batch]) { continue; }
+        transfers += count - counter.m_sampled[batch];
+        batches.sample(batch, count - counter.m_sampled[batch]);
+        counter.m_sampled[batch] = count;
+    }
+}
+
+// account what the submit and collect threads saw since the last call; on
+// the aux thread, or once the worker threads are gone
+void Chimera::sampleWorkerStats()
+{
+    for (auto ch : m_channels) {
+        TaskTraceRecord record;
+        while (ch->m_retiredTasks->tryDequeue(record)) { accountTask(record); }
+        sampleBatches(ch->m_writeBatches, m_stats->pcieWrites, m_stats->writeBatch);
+        sampleBatches(ch->m_readBatches, m_stats->pcieReads, m_stats->readBatch);
     }
 }
 
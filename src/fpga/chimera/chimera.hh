@@ -7,82 +7,352 @@
 
 #include <thread>
 #include <mutex>
-#include <list>
 #include <atomic>
 
 #include "fpga/chimera/common.hh"
+#include "fpga/chimera/dma_pool.hh"
 #include "fpga/chimera/ringBuffer.hh"
+#include "fpga/chimera/thread_placement.hh"
+#include "fpga/chimera/trace_log.hh"
+#include "fpga/chimera/wait_policy.hh"
 #include "fpga/chimera/fpga_engine.hh"
 #include "fpga/chimera/cdma.hh"
 
 #include "base/statistics.hh"
 
+// how often a draining engine looks whether the card is done
+#define CHIMERA_DRAIN_POLL_CYCLES 100
+
+// buckets of the per-stage latency histograms
+#define CHIMERA_LATENCY_BUCKETS 20
+
+// bulk transfers are gathered from segments of one page
+#define CHIMERA_BULK_SEGMENT_SIZE CHIMERA_PAGE_SIZE
+
 namespace gem5
 {
 namespace fpga
 {
 
+/**
+ * What submits tasks to the engine: a device on the memory bus or a
+ * traffic generator. The engine calls these from its worker threads once
+ * a table entry is released after the client found none, and once results
+ * of its tasks are back; the client moves on in the simulation thread.
+ */
+class ChimeraClient
+{
+  public:
+    virtual ~ChimeraClient()
+    {
+    }
+
+    virtual void notifyRetry()    = 0;
+    virtual void notifyResponse() = 0;
+};
+
+// schedules event at the current tick of eq from a worker thread (or from
+// the simulation thread itself)
+void scheduleFromWorker(EventQueue* eq, Event* event);
+
+/**
+ * One DMA channel (an H2C/C2H pair of the transport) with its own submit
+ * and collect thread. A stream is always mapped to the same channel, so
+ * tasks of one stream reach the card in order. Results are not tagged
+ * with a channel on the card; a collect thread hands whatever it reads to
+ * the aux thread, and in-flight counts are kept per submitting channel.
+ *
+ * The submit thread keeps up to dmaQueueDepth writes in flight. It queues
+ * every batch it has room for before flushing the channel, so the
+ * transport can chain them. Each write owns a request and a data packet
+ * until the transport reports it done; writes are tagged with their
+ * sequence number and retire in order.
+ */
+struct InflightWrite {
+    std::vector<int8_t> m_tableIDs;
+    uint8_t             m_attr;
+    uint64_t            m_size;
+    int                 m_bulk = -1; // bulk transfer it carries a chunk of, if any
+    bool                m_bulkEnd;   // the last chunk, which frees the transfer
+    std::vector<iovec>  m_iov;       // buffers of the chunk
+};
+
+// result of a task that asked for one, kept until the device fetches it
+struct CompletedTask {
+    int        m_tableID;
+    int        m_device;
+    PCIeResult m_result;
+    uint64_t   m_enqueueTime;
+};
+
+// completion slot of a table entry, ready from the moment the aux thread
+// publishes the result of its task until the device fetches it. The entry
+// is held meanwhile, so a table ID stands for one result at a time and the
+// slot is written by the aux thread only while it is not ready
+struct CompletionSlot {
+    std::atomic<bool> m_ready{false};
+    CompletedTask     m_done;
+};
+
+// contiguous data-plane bytes of one stream, copied into segments of the
+// bulk pool and written with vectored DMAs, in chunks the card has credits
+// for; segments that happen to be adjacent share an iovec. The transfer is
+// owned by the simulation thread while it is free, then by the threads it
+// passes through. m_issued bytes of it are sent, up to m_iov[m_nextIov]
+// and m_nextOffset bytes into it
+struct BulkTransfer {
+    uint8_t            m_stream;
+    uint64_t           m_addr;
+    uint64_t           m_size;
+    std::vector<int>   m_segments;
+    std::vector<iovec> m_iov;
+    uint64_t           m_issued;
+    size_t             m_nextIov;
+    uint64_t           m_nextOffset;
+};
+
+// transfers of one thread by the tasks they carry, counted by that thread
+// alone and sampled into the stats by the aux thread
+struct BatchCounter {
+    std::atomic<uint64_t> m_count[MAX_BATCH_THRESHOLD + 1] = {};
+    uint64_t              m_sampled[MAX_BATCH_THRESHOLD + 1] = {};
+
+    void add(int batch)
+    {
+        m_count[batch].store(m_count[batch].load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+};
+
+struct ChimeraChannel {
+    int              m_id;
+    std::thread      m_writeThread;
+    std::thread      m_readThread;
+    RingBuffer<int>* m_ready2Transmit;
+    RingBuffer<int>* m_freeRespSlot;
+    AdaptiveWaiter   m_writeWaiter;
+    AdaptiveWaiter   m_readWaiter;
+    std::atomic<int> m_osdTaskCounter;
+
+    std::vector<PCIeReqPkt*>    m_osdReqPkt;
+    std::vector<PCIeDataPkt*>   m_osdDataPkt;
+    std::vector<InflightWrite>  m_inflight;
+    uint64_t                    m_submitted;
+    uint64_t                    m_retired;
+    PCIeRespPkt*                m_osdRespPkt;
+    int                         m_osdRespSlot;
+
+    // tasks the submit thread retired without a result, for the aux thread
+    // to account
+    RingBuffer<TaskTraceRecord>* m_retiredTasks;
+    BatchCounter                 m_writeBatches;
+    BatchCounter                 m_readBatches;
+};
+
 class Chimera : public ClockedObject
 {
   private:
     std::thread auxThread;
-    std::thread readThread;
-    std::thread writeThread;
 
     std::vector<taskTableEntry*> m_taskTable;
     std::atomic<int>             m_validTaskTableNum;
     int                          m_taskTableNum;
 
-    RingBuffer<int> m_idleTaskTableID;
+    MPSCRingBuffer<int> m_idleTaskTableID;
     uint64_t        m_totalTaskID;
 
     FPGAEngine* m_fpga;
     CDMA*       m_cdma;
-    std::string m_parent_name;
-    SimObject*  m_parent;
-    bool        m_parent_retry;
 
-    PCIeReqPkt*  m_osdReqPkt;
-    PCIeDataPkt* m_osdDataPkt;
-    PCIeRespPkt* m_osdRespPkt;
+    // accelerators sharing the engine, indexed by device ID. Each may hold
+    // at most m_quota table entries (0: no limit); m_retry is set when the
+    // device found no entry and wants retry() once one is released
+    struct RegisteredDevice {
+        ChimeraClient*    m_device;
+        int               m_quota;
+        std::atomic<int>  m_held{0};
+        std::atomic<bool> m_retry{false};
+    };
+    std::vector<RegisteredDevice*> m_devices;
+
+    bool deviceFull(RegisteredDevice* dev)
+    {
+        return m_idleTaskTableID.isEmpty()
+            || (dev->m_quota > 0 && dev->m_held.load(std::memory_order_relaxed) >= dev->m_quota);
+    }
 
-    bool  m_cdma_enable;
-    bool  m_pollReadMode_enable;
+    // tasks live in m_taskPool (one slot per table entry), packets in
+    // m_pktPool: m_dmaQueueDepth request and data packets per channel, then
+    // the response slots, m_respSlotNum per channel
+    DMABufferPool*               m_taskPool;
+    DMABufferPool*               m_pktPool;
+    int                          m_dmaQueueDepth;
+    int                          m_respSlotNum;
+    std::vector<ChimeraChannel*> m_channels;
+
+    bool     m_cdma_enable;
+    bool     m_pollReadMode_enable;
+    int      m_batchSize;
+    uint64_t m_batchTimeout;
+
+    // what the card reports at CHIMERA_REG_CAPS; without it (older
+    // bitstreams) nothing below is credited. Input slots are taken by the
+    // submit threads and handed back as the drained count the card reports
+    // grows, output slots are taken per result a batch asks for and handed
+    // back by the collect threads as they read them. IP output shares the
+    // output buffer and is not credited, neither are results in CDMA mode,
+    // which the CDMA readback drains
+    bool                  m_hasCaps;
+    ChimeraCaps           m_caps;
+    std::atomic<uint64_t> m_inputIssued{0};
+    std::atomic<uint64_t> m_inputConsumed{0};
+    std::atomic<uint64_t> m_outputHeld{0};
+    // set by a submit thread short of input slots, cleared by the collect
+    // thread of channel 0 as it reads the drained count again
+    std::atomic<bool>     m_creditRefresh{false};
+
+    // bulk streaming: transfers queue behind the tasks of their stream under
+    // IDs from m_taskTableNum on, so they keep their order without taking a
+    // table entry. The submit threads hand free transfers and segments back;
+    // m_bulkFreeSegments counts the segments that may be taken
+    DMABufferPool*            m_bulkPool;
+    std::vector<BulkTransfer> m_bulk;
+    MPSCRingBuffer<int>       m_idleBulk;
+    MPSCRingBuffer<int>       m_idleSegments;
+    std::atomic<int>          m_bulkFreeSegments{0};
+    uint64_t                  m_bulkMaxTransfer;
+
+    bool isBulk(int id)
+    {
+        return id >= m_taskTableNum;
+    }
+    bool bulkFull(int segments);
+    bool bulkFullAndMark(int device, int segments);
+    void issueBulk(ChimeraChannel* ch);
+    void releaseBulk(int index);
+
+    void     discoverCaps();
+    uint64_t inputSlots(PCIeTask* task);
+    bool     tryTakeCredits(uint64_t input, uint64_t output);
+    void     takeCredits(uint64_t input, uint64_t output, int channel);
+    void     requestCreditRefresh();
+
+    ChimeraCompletion m_completionMode;
+    uint64_t          m_pollBackoffMax;
+
+    // NUMA node of the card, -1 if unknown
+    int             m_numaNode;
+    ThreadPlacement m_submitPlacement;
+    ThreadPlacement m_collectPlacement;
+    ThreadPlacement m_auxPlacement;
 
     std::atomic<bool>        auxDone;
     std::atomic<bool>        writeDone;
     std::atomic<bool>        readDone;
-    std::atomic<int>         osdTaskCounter;
-    RingBuffer<PCIeTask>*    comeInList;
-    RingBuffer<PCIeTask>*    ready2Transmit;
-    RingBuffer<PCIeRespPkt>* ready2Response;
-    std::list<int>           completeList;
-    bool                     completeListUpdated;
-
-    uint64_t issued_data_packet = 0;
+    RingBuffer<int>*         comeInList;
+    MPSCRingBuffer<int>*     ready2Response;
+    AdaptiveWaiter           m_auxWaiter;
+
+    // results waiting to be fetched, a slot per table entry, and a bit per
+    // entry whose slot is ready so harvestResps() only looks at those
+    std::vector<CompletionSlot>        m_completions;
+    std::vector<std::atomic<uint64_t>> m_readyMask;
+
+    void publishResult(int tableID, const PCIeResult& result);
+    void retireResult(int tableID);
+    int  pendingResults();
+
+    std::atomic<uint64_t> issued_data_packet{0};
+    // CPU time the worker threads have used, in ns
+    std::atomic<uint64_t> m_workerCpuTime{0};
+
+    // the engine drains once every table entry is back; results not yet
+    // fetched and the CDMA readback buffer go into checkpoints. What the
+    // card itself holds does not, so checkpoints are best taken between
+    // sequences
+    EventFunctionWrapper m_drainEvent;
+    bool                 isDrained();
+    void                 checkDrained();
 
   public:
     Chimera(const ChimeraParams& p);
     ~Chimera();
 
-    void setParent(std::string name, SimObject* parent)
+    // a device registers before simulation starts; the returned ID is the
+    // device argument of the submission calls below
+    int registerDevice(ChimeraClient* device, const std::string& client_name, int quota);
+
+    void auxThreadFunc();
+    void collectThreadFunc(ChimeraChannel* ch);
+    void submitThreadFunc(ChimeraChannel* ch);
+
+    int  collectBatch(ChimeraChannel* ch, std::vector<int8_t>& tableIDs);
+    void fillBatch(ChimeraChannel* ch, int pkt, const std::vector<int8_t>& tableIDs);
+    void issueBatch(ChimeraChannel* ch);
+    void retireBatch(ChimeraChannel* ch, const DMACompletion& completion);
+    void releaseTasks(ChimeraChannel* ch, const std::vector<int8_t>& tableIDs);
+    void releaseEntry(int tableID);
+
+    void waitCompletion(int channel, PollBackoff& backoff);
+    void accountCpuTime(uint64_t& last);
+    // reads the drained count of the card if a submit thread asked for it;
+    // only the thread reading through channel may call it (with CDMA, the
+    // readback, see CDMA)
+    void serviceCreditRefresh(int channel);
+
+    // cap of the backoff between empty polls, 0 when polling flat out
+    uint64_t pollBackoffMax()
     {
-        m_parent      = parent;
-        m_parent_name = name;
+        return m_completionMode == ChimeraCompletion::poll ? 0 : m_pollBackoffMax;
     }
 
-    void auxThreadFunc();
-    void collectThreadFunc();
-    void submitThreadFunc();
+    // the channel of a stream; the card applies a device's register and
+    // data writes in the order they are sent, so each device is one stream
+    // and keeps to one channel, and the channels are striped across devices
+    ChimeraChannel* channelOf(int id)
+    {
+        uint8_t stream = isBulk(id) ? m_bulk[id - m_taskTableNum].m_stream : m_taskTable[id]->m_task->m_stream;
+        return m_channels[stream % m_channels.size()];
+    }
 
-    bool isFullAndMark();
-    int  recvTask(PCIeTask task);
+    // The submission calls never block the simulation. A device counts as
+    // full when the table is, or when it holds its quota; the calls then
+    // report that they would block (-1 or nullptr) and the device is sent
+    // retry() once an entry is released
+    bool isFullAndMark(int device = -1);
+    int  recvTask(PCIeTask task, int device = -1);
+
+    // zero-copy submission: the producer fills the task slot of a free
+    // table entry in place and hands it back with submitTask()
+    PCIeTask* tryAllocTask(int device = -1);
+    int       submitTask(PCIeTask* task);
+
+    // bulk streaming of the data plane, past the task table: size bytes
+    // for addr on the card, copied into the bulk pool and written with one
+    // vectored DMAs, in order with the tasks of the device. False while the
+    // pool has no room; the device is then sent retry() once a transfer is
+    // done. size is at most bulkMaxTransfer(), which is 0 without a pool
+    bool     submitBulk(int device, uint64_t addr, const uint8_t* data, uint64_t size);
+    uint64_t bulkMaxTransfer()
+    {
+        return m_bulkMaxTransfer;
+    }
     void simBegin();
     void simExit();
 
-    std::pair<PCIeResult, uint64_t> fetchResp(int id);
+    void       startup() override;
+    DrainState drain() override;
+    void       serialize(CheckpointOut& cp) const override;
+    void       unserialize(CheckpointIn& cp) override;
+
+    // result and enqueue cycle of a task that asked for a response, false
+    // while it has not come back yet; the device is sent responseReady()
+    // when it does. The task holds its table entry until it is fetched
+    bool tryFetchResp(int id, std::pair<PCIeResult, uint64_t>& resp);
+    // fetches every result of device that is back, appending them to done;
+    // returns how many there were
+    int harvestResps(int device, std::vector<CompletedTask>& done);
 
-    void parentRetryCallback();
+    void retryDevices();
 
     FPGAEngine* getFPGAEngine()
     {
@@ -101,6 +371,11 @@ class Chimera : public ClockedObject
         m_cdma->fetchData(buf, size);
     }
 
+    void CDMAPeekData(void* buf, uint64_t size)
+    {
+        m_cdma->peekData(buf, size);
+    }
+
     int64_t CDMARemain()
     {
         int64_t result = m_cdma->getRemain();
@@ -120,29 +395,49 @@ class Chimera : public ClockedObject
         statistics::Scalar pcieSubmit;
         statistics::Scalar pcieCollect;
         statistics::Scalar hardwareExecution;
+        statistics::Scalar pcieWrites;
+        statistics::Scalar pcieReads;
+        statistics::Scalar pcieEmptyReads;
+        statistics::Scalar creditStalls;
+        statistics::Scalar creditRefreshes;
+        statistics::Scalar bulkTransfers;
+        statistics::Scalar bulkBytes;
+        statistics::Value   workerCpuTime;
+        statistics::Formula cpuTimePerTask;
+
+        // per-task latency of each stage, in ns; the last three only for
+        // tasks that ask for a result
+        statistics::Histogram preFlowLatency;
+        statistics::Histogram pcieSubmitLatency;
+        statistics::Histogram pcieCollectLatency;
+        statistics::Histogram postFlowLatency;
+        statistics::Histogram taskLatency;
+        // card clock cycles a task spent in the IP, as the card reports it
+        statistics::Histogram hardwareCycles;
+
+        statistics::Distribution writeBatch;
+        statistics::Distribution readBatch;
     };
 
     ChimeraStats*          m_stats;
     std::vector<LifeCycle> m_lifeCycleTable;
 
-    std::list<uint64_t>    m_rdBatch_record;
-    std::list<uint64_t>    m_wrBatch_record;
+    // only the aux thread samples the stats and logs the trace, the other
+    // threads hand it what they saw through their channel
+    ChimeraTraceLog* m_traceLog;
+
+    // the life of a task once it is over, and its accounting
+    TaskTraceRecord retireLifeCycle(int tableID);
+    void            accountTask(const TaskTraceRecord& record);
+    void            sampleBatches(BatchCounter& counter, statistics::Scalar& transfers,
+                                  statistics::Distribution& batches);
+    void            sampleWorkerStats();
 
-    void submitLifeCycle(int tableID)
+  private:
+    PCIeRespPkt* respSlot(int index)
     {
-        LifeCycle entry             = m_lifeCycleTable[tableID];
-        assert(entry.m_valid);
-        
-        m_stats->handleCount       += 1;
-        m_stats->preFlow           += (entry.m_pre_submitTime - entry.m_recvTime);
-        m_stats->pcieSubmit        += (entry.m_post_submitTime - entry.m_pre_submitTime);
-        m_stats->pcieCollect       += (entry.m_post_collectTime - entry.m_pre_collectTime);
-        m_stats->postFlow          += (entry.m_respTime - entry.m_post_collectTime);
-
-        m_lifeCycleTable[tableID].m_valid = false;
+        return m_pktPool->at<PCIeRespPkt>(2 * m_dmaQueueDepth * m_channels.size() + index);
     }
-
-    void printBatchRecord();
 };
 
 } // namespace fpga
@@ -0,0 +1,636 @@
+#include "fpga/chimera/chimera_device.hh"
+
+#include "base/logging.hh"
+#include "base/trace.hh"
+#include "debug/ChimeraDevice.hh"
+#include "debug/Drain.hh"
+#include "dev/dma_device.hh"
+#include "sim/process.hh"
+#include "sim/system.hh"
+
+namespace gem5
+{
+namespace fpga
+{
+
+ChimeraDevice::ChimeraDevice(const ChimeraDeviceParams& p) :
+    ClockedObject(p), m_chimera(p.chimera), m_deviceID(-1), m_taskQuota(p.task_quota), m_pioAddr(p.pio_addr),
+    m_statusReg(p.status_reg), m_dataOffset(p.data_offset), m_outOffset(p.out_offset), m_cardBase(p.card_base),
+    m_pioDelay(p.pio_latency), m_enable_dataPlane_opt(p.enable_dataPlane_opt), m_bulk(p.bulk_data),
+    m_bulkFlushDelay(p.bulk_flush_delay), m_bulkMax(0), m_bulkAddr(0), m_system(p.system), m_dmaReg(p.dma_reg),
+    m_dmaVirtual(p.dma_virtual), m_dmaAddr(0), m_dmaSize(0), m_dmaStatusAddr(0), m_dmaControl(0), m_dmaWritten(0),
+    m_dmaInflight(0), m_dmaStatus(0), m_dmaBusy(false), m_dmaStatusPending(false)
+{
+    if (m_statusReg >= m_dataOffset || m_dataOffset >= m_outOffset || m_outOffset >= p.pio_size) {
+        fatal("%s: the register, data-plane and output-buffer windows must follow each other within the %#x "
+              "byte window\n",
+              name(), p.pio_size);
+    }
+    if (isDmaRegister(m_statusReg) || m_dmaReg + CHIMERA_DMA_REGS_SIZE > m_dataOffset) {
+        fatal("%s: the DMA registers at %#x overlap the status register or the data plane\n", name(), m_dmaReg);
+    }
+
+    m_cpu_side_port = new ChimeraDeviceCpuSidePort(name() + ".cpu_side_port", this, RangeSize(p.pio_addr, p.pio_size));
+    m_wakeupEvent   = new EventFunctionWrapper([this] { wakeup(); }, name() + ".wakeupEvent");
+    m_retryEvent    = new EventFunctionWrapper([this] { retry(); }, name() + ".retryEvent");
+    m_responseEvent = new EventFunctionWrapper([this] { responseReady(); }, name() + ".responseEvent");
+
+    m_dmaPort        = new DmaPort(this, m_system);
+    m_dmaEvent       = new EventFunctionWrapper([this] { dmaStep(); }, name() + ".dmaEvent");
+    m_dmaBurstEvent  = new EventFunctionWrapper([this] { dmaBurstDone(); }, name() + ".dmaBurstEvent");
+    m_dmaStatusEvent = new EventFunctionWrapper([this] { dmaStatusDone(); }, name() + ".dmaStatusEvent");
+    m_dmaData.resize(CHIMERA_DEVICE_DMA_BURST);
+    m_bulkFlushEvent = new EventFunctionWrapper([this] { flushBulk(); }, name() + ".bulkFlushEvent");
+
+    m_staged.resize(CHIMERA_DEVICE_STAGING_TASKS);
+    m_node_head       = 0;
+    m_node_tail       = 0;
+    m_local_node_ptr  = 0;
+    m_local_node_addr = 0;
+
+    m_stalling_packet = nullptr;
+}
+
+ChimeraDevice::~ChimeraDevice()
+{
+}
+
+Port& ChimeraDevice::getPort(const std::string& if_name, PortID idx)
+{
+    if (if_name == "cpu_side_port") {
+        return *m_cpu_side_port;
+    } else if (if_name == "dma") {
+        return *m_dmaPort;
+    } else {
+        return ClockedObject::getPort(if_name, idx);
+    }
+}
+
+void ChimeraDevice::init()
+{
+    if (!m_cpu_side_port->isConnected()) { fatal("%s: cpu_side_port must be connected.\n", name()); }
+
+    m_cpu_side_port->sendRangeChange();
+
+    if (m_chimera) { m_deviceID = m_chimera->registerDevice(this, name(), m_taskQuota); }
+
+    if (m_bulk) {
+        m_bulkMax = m_chimera ? m_chimera->bulkMaxTransfer() : 0;
+        fatal_if(m_bulkMax == 0, "%s: bulk_data needs a chimera engine with a bulk pool (bulkSegments)\n", name());
+        m_bulkData.reserve(m_bulkMax);
+    }
+}
+
+bool ChimeraDevice::isDrained() const
+{
+    // a descriptor waiting for output goes into the checkpoint, a burst
+    // being written does not
+    return m_pending_packets.empty() && m_stalling_packet == nullptr && m_node_head == m_node_tail
+        && m_dmaInflight == 0 && !m_dmaStatusPending;
+}
+
+void ChimeraDevice::checkDrained()
+{
+    if (drainState() == DrainState::Draining && isDrained()) {
+        DPRINTF(Drain, "%s drained\n", name());
+        signalDrainDone();
+    }
+}
+
+DrainState ChimeraDevice::drain()
+{
+    flushBulk();
+    return isDrained() ? DrainState::Drained : DrainState::Draining;
+}
+
+void ChimeraDevice::serialize(CheckpointOut& cp) const
+{
+    SERIALIZE_ARRAY(m_local_node, TASK_DATA_SIZE);
+    SERIALIZE_SCALAR(m_local_node_addr);
+    SERIALIZE_SCALAR(m_local_node_ptr);
+
+    SERIALIZE_SCALAR(m_dmaAddr);
+    SERIALIZE_SCALAR(m_dmaSize);
+    SERIALIZE_SCALAR(m_dmaStatusAddr);
+    SERIALIZE_SCALAR(m_dmaControl);
+    SERIALIZE_SCALAR(m_dmaWritten);
+    SERIALIZE_SCALAR(m_dmaStatus);
+    SERIALIZE_SCALAR(m_dmaBusy);
+}
+
+void ChimeraDevice::unserialize(CheckpointIn& cp)
+{
+    UNSERIALIZE_ARRAY(m_local_node, TASK_DATA_SIZE);
+    UNSERIALIZE_SCALAR(m_local_node_addr);
+    UNSERIALIZE_SCALAR(m_local_node_ptr);
+
+    UNSERIALIZE_SCALAR(m_dmaAddr);
+    UNSERIALIZE_SCALAR(m_dmaSize);
+    UNSERIALIZE_SCALAR(m_dmaStatusAddr);
+    UNSERIALIZE_SCALAR(m_dmaControl);
+    UNSERIALIZE_SCALAR(m_dmaWritten);
+    UNSERIALIZE_SCALAR(m_dmaStatus);
+    UNSERIALIZE_SCALAR(m_dmaBusy);
+    if (m_dmaBusy && !m_dmaEvent->scheduled()) { schedule(m_dmaEvent, nextCycle()); }
+}
+
+void ChimeraDevice::addRegister(Addr offset, uint64_t start_bits, uint64_t end_bits)
+{
+    assert(offset < m_dataOffset && offset != m_statusReg && !isDmaRegister(offset));
+    m_registers.push_back({offset, start_bits, end_bits});
+}
+
+const ChimeraRegister* ChimeraDevice::findRegister(Addr offset) const
+{
+    for (const ChimeraRegister& reg : m_registers) {
+        if (reg.m_offset == offset) { return &reg; }
+    }
+    return nullptr;
+}
+
+void ChimeraDevice::retry()
+{
+    submit();
+}
+
+void ChimeraDevice::requestWakeup()
+{
+    if (!m_wakeupEvent->scheduled()) { schedule(m_wakeupEvent, nextCycle()); }
+}
+
+void ChimeraDevice::notifyRetry()
+{
+    scheduleFromWorker(eventQueue(), m_retryEvent);
+}
+
+void ChimeraDevice::notifyResponse()
+{
+    scheduleFromWorker(eventQueue(), m_responseEvent);
+}
+
+void ChimeraDevice::submit()
+{
+    while (m_node_head != m_node_tail) {
+        if (!stagedTask(m_node_head).isValid()) {
+            StagedBulk& bulk = m_stagedBulk.front();
+            if (!m_chimera->submitBulk(m_deviceID, bulk.m_addr, bulk.m_data.data(), bulk.m_data.size())) {
+                DPRINTF(ChimeraDevice, "no room for a bulk transfer, %d tasks wait for retry\n",
+                        m_node_tail - m_node_head);
+                break;
+            }
+            // the engine has its own copy, keep the storage for the next one
+            bulk.m_data.clear();
+            m_bulkSpare.swap(bulk.m_data);
+            m_stagedBulk.pop_front();
+            m_node_head++;
+            continue;
+        }
+
+        // the task is copied straight into its entry's pinned slot
+        PCIeTask* task = m_chimera->tryAllocTask(m_deviceID);
+        if (!task) {
+            DPRINTF(ChimeraDevice, "no free table entry, %d tasks wait for retry\n", m_node_tail - m_node_head);
+            break;
+        }
+        int8_t id       = task->m_tableID;
+        *task           = stagedTask(m_node_head);
+        task->m_tableID = id;
+        m_chimera->submitTask(task);
+        m_node_head++;
+    }
+    checkDrained();
+}
+
+void ChimeraDevice::pushTask(const PCIeTask& task)
+{
+    stagedTask(m_node_tail) = task;
+    m_node_tail++;
+
+    if (m_node_tail - m_node_head == m_staged.size()) {
+        std::vector<PCIeTask> staged(m_staged.size() * 2);
+        for (uint64_t i = m_node_head; i < m_node_tail; ++i) { staged[i - m_node_head] = stagedTask(i); }
+        m_node_tail -= m_node_head;
+        m_node_head = 0;
+        m_staged.swap(staged);
+    }
+}
+
+void ChimeraDevice::pushDataNode()
+{
+    // a partial chunk at the end of a sequence is padded with zeros
+    std::memset(m_local_node + m_local_node_ptr, 0, TASK_DATA_SIZE - m_local_node_ptr);
+
+    PCIeTask task;
+    task.setValid();
+    task.setDataType();
+    task.fillData(m_cardBase + m_local_node_addr, m_local_node, TASK_DATA_SIZE);
+    task.m_stream = m_deviceID;
+    pushTask(task);
+
+    m_local_node_ptr  = 0;
+    m_local_node_addr = 0;
+}
+
+void ChimeraDevice::pushBulk()
+{
+    // the card takes whole beats, a partial one is padded with zeros
+    uint64_t size = (m_bulkData.size() + CHIMERA_DATA_BEAT_SIZE - 1) & ~(uint64_t)(CHIMERA_DATA_BEAT_SIZE - 1);
+    m_bulkData.resize(size, 0);
+    m_stagedBulk.push_back({m_cardBase + m_bulkAddr, std::move(m_bulkData)});
+    pushTask(PCIeTask());
+
+    m_bulkData.clear();
+    m_bulkData.swap(m_bulkSpare);
+    m_bulkAddr = 0;
+    if (m_bulkFlushEvent->scheduled()) { deschedule(m_bulkFlushEvent); }
+}
+
+void ChimeraDevice::flushBulk()
+{
+    if (m_bulkData.empty()) { return; }
+    DPRINTF(ChimeraDevice, "flushing a bulk transfer of %d bytes\n", m_bulkData.size());
+    pushBulk();
+    submit();
+}
+
+void ChimeraDevice::readAccess(PacketPtr pkt, Addr offset)
+{
+    if (offset == m_statusReg) {
+        panic_if(pkt->getSize() != sizeof(uint64_t), "%s: status register read of %d bytes\n", name(),
+                 pkt->getSize());
+        uint64_t value = 0;
+        value |= 0x1;
+        value |= ((uint64_t)outputEnded() << 2);
+        value |= (outputAvailable() << 32);
+        pkt->setLE<uint64_t>(value);
+    } else if (offset >= m_outOffset) {
+        readOutput(pkt->getPtr<uint8_t>(), pkt->getSize());
+    } else if (isDmaRegister(offset)) {
+        dmaRead(pkt, offset);
+    } else {
+        panic("%s: read of unmapped offset %#x\n", name(), offset);
+    }
+}
+
+void ChimeraDevice::writeAccess(PacketPtr pkt, Addr offset)
+{
+    if (offset >= m_outOffset) {
+        panic("%s: write to the output buffer at %#x\n", name(), offset);
+    } else if (offset >= m_dataOffset) {
+        writeData(pkt, offset);
+    } else if (isDmaRegister(offset)) {
+        dmaWrite(pkt, offset);
+    } else {
+        const ChimeraRegister* reg = findRegister(offset);
+        if (!reg) { panic("%s: write to undeclared register %#x\n", name(), offset); }
+        writeRegister(*reg, pkt, offset);
+    }
+}
+
+void ChimeraDevice::writeRegister(const ChimeraRegister& reg, PacketPtr pkt, Addr offset)
+{
+    panic_if(pkt->getSize() > TASK_DATA_SIZE - sizeof(uint64_t), "%s: register write of %d bytes\n", name(),
+             pkt->getSize());
+
+    uint64_t addr  = m_cardBase + offset;
+    uint64_t value = 0;
+    std::memcpy(&value, pkt->getPtr<uint8_t>(), std::min<uint64_t>(pkt->getSize(), sizeof(uint64_t)));
+
+    PCIeTask task;
+    task.setValid();
+    task.setWriteType();
+    task.m_stream = m_deviceID;
+    std::memcpy(&(task.m_content[0]), &addr, sizeof(uint64_t));
+    std::memcpy(&(task.m_content[8]), pkt->getPtr<uint8_t>(), pkt->getSize());
+
+    // data written before the register reaches the card before it
+    if (!m_bulkData.empty()) { pushBulk(); }
+    if (value & reg.m_endBits) {
+        DPRINTF(ChimeraDevice, "end of stream, %d tasks to send first\n", m_node_tail - m_node_head);
+        if (m_local_node_ptr > 0) { pushDataNode(); }
+    } else if (value & reg.m_startBits) {
+        // a stop write carries the start bit too, it must not start the readback again
+        m_chimera->enableCDMA(m_cardBase + m_outOffset, 0);
+    }
+
+    pushTask(task);
+    submit();
+}
+
+void ChimeraDevice::writeData(PacketPtr pkt, Addr offset)
+{
+    // write-combining CPUs send whole lines, which may span chunks
+    const uint8_t* data = pkt->getPtr<uint8_t>();
+    uint64_t       size = pkt->getSize();
+
+    if (m_bulk) {
+        while (size > 0) {
+            if (!m_bulkData.empty() && offset != m_bulkAddr + m_bulkData.size()) { pushBulk(); }
+            if (m_bulkData.empty()) { m_bulkAddr = offset; }
+
+            uint64_t bytes = std::min<uint64_t>(size, m_bulkMax - m_bulkData.size());
+            m_bulkData.insert(m_bulkData.end(), data, data + bytes);
+            if (m_bulkData.size() == m_bulkMax) { pushBulk(); }
+
+            data += bytes;
+            offset += bytes;
+            size -= bytes;
+        }
+        if (!m_bulkData.empty()) { reschedule(m_bulkFlushEvent, curTick() + m_bulkFlushDelay, true); }
+    } else if (m_enable_dataPlane_opt) {
+        while (size > 0) {
+            uint64_t bytes = std::min<uint64_t>(size, TASK_DATA_SIZE - m_local_node_ptr);
+            std::memcpy(m_local_node + m_local_node_ptr, data, bytes);
+
+            if (m_local_node_ptr == 0) { m_local_node_addr = offset; }
+
+            m_local_node_ptr += bytes;
+            if (m_local_node_ptr == TASK_DATA_SIZE) { pushDataNode(); }
+
+            data += bytes;
+            offset += bytes;
+            size -= bytes;
+        }
+    } else {
+        panic_if(size % sizeof(uint64_t), "%s: data-plane write of %d bytes\n", name(), size);
+
+        for (; size > 0; data += sizeof(uint64_t), offset += sizeof(uint64_t), size -= sizeof(uint64_t)) {
+            uint64_t addr = m_cardBase + offset;
+            PCIeTask task;
+            task.setValid();
+            task.setWriteType();
+            task.m_stream = m_deviceID;
+            std::memcpy(&(task.m_content[0]), &addr, sizeof(uint64_t));
+            std::memcpy(&(task.m_content[8]), data, sizeof(uint64_t));
+
+            pushTask(task);
+        }
+    }
+    submit();
+}
+
+uint64_t ChimeraDevice::outputAvailable()
+{
+    return m_chimera->CDMARemain();
+}
+
+void ChimeraDevice::readOutput(uint8_t* data, uint64_t size)
+{
+    m_chimera->CDMAFetchData(data, size);
+}
+
+void ChimeraDevice::peekOutput(uint8_t* data, uint64_t size)
+{
+    m_chimera->CDMAPeekData(data, size);
+}
+
+bool ChimeraDevice::outputEnded()
+{
+    return !m_chimera->CDMAStatus();
+}
+
+void ChimeraDevice::dmaRead(PacketPtr pkt, Addr offset)
+{
+    panic_if(pkt->getSize() != sizeof(uint64_t), "%s: DMA register read of %d bytes\n", name(), pkt->getSize());
+
+    uint64_t value = 0;
+    switch (offset - m_dmaReg) {
+        case CHIMERA_DMA_ADDR: value = m_dmaAddr; break;
+        case CHIMERA_DMA_SIZE: value = m_dmaSize; break;
+        case CHIMERA_DMA_STATUS_ADDR: value = m_dmaStatusAddr; break;
+        case CHIMERA_DMA_CONTROL: value = m_dmaStatus | (m_dmaBusy ? CHIMERA_DMA_BUSY : 0); break;
+        default: panic("%s: read of unaligned DMA register %#x\n", name(), offset);
+    }
+    pkt->setLE<uint64_t>(value);
+}
+
+void ChimeraDevice::dmaWrite(PacketPtr pkt, Addr offset)
+{
+    panic_if(pkt->getSize() != sizeof(uint64_t), "%s: DMA register write of %d bytes\n", name(), pkt->getSize());
+
+    uint64_t value = pkt->getLE<uint64_t>();
+    if (m_dmaBusy) {
+        warn("%s: DMA register %#x written while a descriptor runs, ignored\n", name(), offset);
+        return;
+    }
+
+    switch (offset - m_dmaReg) {
+        case CHIMERA_DMA_ADDR: m_dmaAddr = value; break;
+        case CHIMERA_DMA_SIZE: m_dmaSize = value; break;
+        case CHIMERA_DMA_STATUS_ADDR: m_dmaStatusAddr = value; break;
+        case CHIMERA_DMA_CONTROL:
+            if (!(value & CHIMERA_DMA_START)) { break; }
+            fatal_if(!m_dmaPort->isConnected(), "%s: output DMA started with the dma port unconnected\n", name());
+            DPRINTF(ChimeraDevice, "DMA of up to %d bytes to %#x%s\n", m_dmaSize, m_dmaAddr,
+                    (value & CHIMERA_DMA_UNTIL_END) ? ", until the end of the stream" : "");
+            m_dmaControl = value;
+            m_dmaWritten = 0;
+            m_dmaStatus  = 0;
+            m_dmaBusy    = true;
+            dmaStep();
+            break;
+        default: panic("%s: write of unaligned DMA register %#x\n", name(), offset);
+    }
+}
+
+bool ChimeraDevice::dmaTranslate(Addr vaddr, Addr& paddr, uint64_t& extent)
+{
+    if (!m_dmaVirtual) {
+        paddr  = vaddr;
+        extent = CHIMERA_DEVICE_DMA_BURST;
+        return true;
+    }
+
+    Process* process = m_system->threads.size() > 0 ? m_system->threads[0]->getProcessPtr() : nullptr;
+    if (!process || !process->pTable->translate(vaddr, paddr)) { return false; }
+    Addr page_size = process->pTable->pageSize();
+    extent         = page_size - (vaddr & (page_size - 1));
+    return true;
+}
+
+void ChimeraDevice::dmaStep()
+{
+    if (!m_dmaBusy || m_dmaInflight > 0 || m_dmaStatusPending) { return; }
+
+    uint64_t room      = m_dmaSize - m_dmaWritten;
+    uint64_t available = outputAvailable();
+    if (available == 0 && outputEnded()) { return dmaFinish(CHIMERA_DMA_END); }
+    if (room == 0) { return dmaFinish(CHIMERA_DMA_OVERFLOW); }
+    if (available == 0) {
+        if (!(m_dmaControl & CHIMERA_DMA_UNTIL_END)) { return dmaFinish(0); }
+        if (!m_dmaEvent->scheduled()) { schedule(m_dmaEvent, clockEdge(Cycles(CHIMERA_DEVICE_DMA_POLL_CYCLES))); }
+        return;
+    }
+
+    Addr     paddr;
+    uint64_t extent;
+    if (!dmaTranslate(m_dmaAddr + m_dmaWritten, paddr, extent)) {
+        warn("%s: DMA buffer address %#x is not mapped\n", name(), m_dmaAddr + m_dmaWritten);
+        return dmaFinish(CHIMERA_DMA_FAULT);
+    }
+
+    uint64_t size = std::min({available, room, extent, (uint64_t)CHIMERA_DEVICE_DMA_BURST});
+    readOutput(m_dmaData.data(), size);
+    m_dmaInflight = size;
+    m_dmaPort->dmaAction(MemCmd::WriteReq, paddr, size, m_dmaBurstEvent, m_dmaData.data(), 0);
+}
+
+void ChimeraDevice::dmaBurstDone()
+{
+    m_dmaWritten += m_dmaInflight;
+    m_dmaInflight = 0;
+    dmaStep();
+    checkDrained();
+}
+
+void ChimeraDevice::dmaFinish(uint64_t flags)
+{
+    m_dmaStatus = (m_dmaWritten << 32) | flags | CHIMERA_DMA_COMPLETE;
+    DPRINTF(ChimeraDevice, "DMA complete, %d bytes written, status %#x\n", m_dmaWritten, m_dmaStatus);
+
+    Addr     paddr;
+    uint64_t extent;
+    if (m_dmaStatusAddr != 0) {
+        if (dmaTranslate(m_dmaStatusAddr, paddr, extent) && extent >= sizeof(uint64_t)) {
+            m_dmaStatusPending = true;
+            m_dmaPort->dmaAction(MemCmd::WriteReq, paddr, sizeof(uint64_t), m_dmaStatusEvent,
+                                 reinterpret_cast<uint8_t*>(&m_dmaStatus), 0);
+            return;
+        }
+        warn("%s: DMA status word address %#x is not mapped\n", name(), m_dmaStatusAddr);
+        m_dmaStatus |= CHIMERA_DMA_FAULT;
+    }
+    m_dmaBusy = false;
+}
+
+void ChimeraDevice::dmaStatusDone()
+{
+    m_dmaStatusPending = false;
+    m_dmaBusy          = false;
+    checkDrained();
+}
+
+void ChimeraDevice::kickDma()
+{
+    if (m_dmaBusy && m_dmaInflight == 0 && !m_dmaEvent->scheduled()) { schedule(m_dmaEvent, nextCycle()); }
+}
+
+void ChimeraDevice::wakeup()
+{
+    if (m_pending_packets.size() > 0 && m_stalling_packet == nullptr) {
+        PacketPtr pkt = m_pending_packets.front();
+        access(pkt);
+        respond(pkt);
+    }
+}
+
+void ChimeraDevice::access(PacketPtr pkt)
+{
+    Addr offset = pkt->getAddr() - m_pioAddr;
+    if (pkt->isRead()) {
+        readAccess(pkt, offset);
+    } else if (pkt->isWrite()) {
+        writeAccess(pkt, offset);
+    } else {
+        panic("%s: unsupported request %s\n", name(), pkt->cmdString());
+    }
+}
+
+Tick ChimeraDevice::atomicAccess(PacketPtr pkt)
+{
+    // the memory mode only changes once the device is drained
+    panic_if(!m_pending_packets.empty(), "%s: atomic request with timing requests queued\n", name());
+
+    DPRINTF(ChimeraDevice, "atomic req %s\n", pkt->print());
+    access(pkt);
+    pkt->makeAtomicResponse();
+    return m_pioDelay;
+}
+
+void ChimeraDevice::functionalAccess(PacketPtr pkt)
+{
+    Addr offset = pkt->getAddr() - m_pioAddr;
+    DPRINTF(ChimeraDevice, "functional req %s\n", pkt->print());
+    if (pkt->isRead()) {
+        bool reg = offset == m_statusReg || isDmaRegister(offset);
+        if (offset >= m_outOffset) {
+            peekOutput(pkt->getPtr<uint8_t>(), pkt->getSize());
+        } else if (reg && pkt->getSize() == sizeof(uint64_t)) {
+            // the registers read back without side effects
+            readAccess(pkt, offset);
+        } else {
+            std::memset(pkt->getPtr<uint8_t>(), 0, pkt->getSize());
+        }
+    }
+    // a write would send tasks to the card, it is dropped
+    pkt->makeResponse();
+}
+
+void ChimeraDevice::respond(PacketPtr pkt)
+{
+    pkt->makeTimingResponse();
+    if (!m_cpu_side_port->sendTimingResp(pkt)) { m_stalling_packet = pkt; }
+
+    m_pending_packets.pop_front();
+
+    if (m_pending_packets.size() > 0) { requestWakeup(); }
+    checkDrained();
+}
+
+ChimeraDevice::ChimeraDeviceCpuSidePort::ChimeraDeviceCpuSidePort(const std::string& _name, ChimeraDevice* parent,
+                                                                  AddrRange range) :
+    ResponsePort(_name), m_parent(parent)
+{
+    ranges.push_back(range);
+}
+
+ChimeraDevice::ChimeraDeviceCpuSidePort::~ChimeraDeviceCpuSidePort()
+{
+}
+
+bool ChimeraDevice::ChimeraDeviceCpuSidePort::recvTimingReq(PacketPtr pkt)
+{
+    DPRINTF(ChimeraDevice, "received req %s\n", pkt->print());
+    m_parent->m_pending_packets.push_back(pkt);
+    m_parent->requestWakeup();
+    return true;
+}
+
+void ChimeraDevice::ChimeraDeviceCpuSidePort::recvRespRetry()
+{
+    assert(m_parent->m_stalling_packet);
+    if (sendTimingResp(m_parent->m_stalling_packet)) {
+        m_parent->m_stalling_packet = nullptr;
+        if (m_parent->m_pending_packets.size() > 0) { m_parent->requestWakeup(); }
+        m_parent->checkDrained();
+    }
+}
+
+Tick ChimeraDevice::ChimeraDeviceCpuSidePort::recvAtomic(PacketPtr pkt)
+{
+    return m_parent->atomicAccess(pkt);
+}
+
+Tick ChimeraDevice::ChimeraDeviceCpuSidePort::recvAtomicBackdoor(PacketPtr pkt, MemBackdoorPtr& backdoor)
+{
+    // the windows are registers and streams, never plain memory
+    return m_parent->atomicAccess(pkt);
+}
+
+void ChimeraDevice::ChimeraDeviceCpuSidePort::recvFunctional(PacketPtr pkt)
+{
+    m_parent->functionalAccess(pkt);
+}
+
+void ChimeraDevice::ChimeraDeviceCpuSidePort::recvMemBackdoorReq(const MemBackdoorReq& req, MemBackdoorPtr& backdoor)
+{
+    // no backdoor: backdoor stays null
+}
+
+AddrRangeList ChimeraDevice::ChimeraDeviceCpuSidePort::getAddrRanges() const
+{
+    return ranges;
+}
+
+} // namespace fpga
+} // namespace gem5
@@ -0,0 +1,304 @@
+#ifndef __FPGA_CHIMERA_CHIMERA_DEVICE_HH__
+#define __FPGA_CHIMERA_CHIMERA_DEVICE_HH__
+
+#include <deque>
+#include <list>
+#include <vector>
+
+#include "params/ChimeraDevice.hh"
+#include "sim/clocked_object.hh"
+#include "mem/packet.hh"
+#include "mem/port.hh"
+
+#include "fpga/chimera/chimera.hh"
+
+#define CHIMERA_DEVICE_STAGING_TASKS 1024
+
+// output DMA: largest write issued at once, and how often a descriptor
+// waiting for output looks again
+#define CHIMERA_DEVICE_DMA_BURST       4096
+#define CHIMERA_DEVICE_DMA_POLL_CYCLES 100
+
+// output DMA descriptor registers, as offsets from dma_reg
+#define CHIMERA_DMA_ADDR        0x0
+#define CHIMERA_DMA_SIZE        0x8
+#define CHIMERA_DMA_STATUS_ADDR 0x10
+#define CHIMERA_DMA_CONTROL     0x18
+#define CHIMERA_DMA_REGS_SIZE   0x20
+
+// control bits
+#define CHIMERA_DMA_START     0x1
+#define CHIMERA_DMA_UNTIL_END 0x2
+
+// status word bits; the bytes written are in bits 63:32
+#define CHIMERA_DMA_COMPLETE 0x1
+#define CHIMERA_DMA_OVERFLOW 0x2
+#define CHIMERA_DMA_END      0x4
+#define CHIMERA_DMA_BUSY     0x8
+#define CHIMERA_DMA_FAULT    0x10
+
+namespace gem5
+{
+
+class DmaPort;
+class System;
+
+namespace fpga
+{
+
+/**
+ * A control register of the IP behind a ChimeraDevice. Writing a value
+ * with one of the start bits set starts CDMA readback of the output
+ * buffer; one with an end bit set ends the input stream, so it is held
+ * back until every data-plane chunk before it has been sent.
+ */
+struct ChimeraRegister {
+    Addr     m_offset;
+    uint64_t m_startBits;
+    uint64_t m_endBits;
+};
+
+/**
+ * Base of an accelerator on the memory bus whose RTL runs behind Chimera.
+ * The device claims one window of the address space, split in three:
+ *  - registers, below the data-plane offset: 8-byte control registers,
+ *    each write forwarded to the card as a write task. The status register
+ *    is answered locally: ready (bit 0), readback done (bit 2) and the
+ *    bytes waiting in the output buffer (63:32).
+ *  - the data plane, up to the output-buffer offset: streaming input,
+ *    gathered into TASK_DATA_SIZE chunks and sent as data tasks, or one
+ *    write task per 8 bytes when coalescing is off. With bulk_data it is
+ *    gathered into transfers of up to the engine's bulkMaxTransfer
+ *    instead, which take no table entry. Writes may be up to a line long,
+ *    from CPUs that write-combine the data plane.
+ *  - the output buffer, to the end of the window: reads drain the results
+ *    CDMA has read back.
+ * Task addresses are the offsets within the window, moved by cardBase to
+ * where the IP sits on the card.
+ *
+ * Instead of reading the output buffer, software can hand the device a
+ * descriptor through the registers at dma_reg: the address and size of a
+ * buffer and the address of a status word. Writing the control register
+ * with the start bit set streams the output into the buffer through the
+ * dma port, in bursts the port splits into cache lines, until the output
+ * runs dry (or, with the until-end bit, until the stream ends) or the
+ * buffer is full. The status word is then written with the bytes written
+ * (63:32), complete (bit 0), buffer full (bit 1) and end of stream (bit
+ * 2); a buffer address that cannot be translated sets bit 4. Reading the
+ * control register returns the same word, with bit 3 set while busy. In
+ * SE mode the addresses are virtual addresses of the process on system and
+ * are translated page by page.
+ *
+ * A subclass only declares its registers with addRegister(). It may
+ * override retry() and requestWakeup() to handle requests itself, as the
+ * in-process Verilator model of the MPEG2 encoder does.
+ *
+ * Several devices can share one Chimera engine. Each is given a device
+ * ID, which is also the stream its tasks are sent on, so they stay in
+ * order on one channel, and may hold at most taskQuota table entries.
+ *
+ * Requests never wait for the card: writes are answered once their task is
+ * staged, and tasks that find no free entry stay staged until the engine
+ * calls retry(). The simulated CPU keeps running while the card works.
+ * Atomic requests are served at once and pio_latency after they arrive,
+ * so setup can be fast-forwarded with atomic or KVM CPUs; the card goes on
+ * working as simulated time passes. Functional requests only look: a read
+ * returns the registers and the output as they are without consuming it,
+ * and a write is ignored.
+ *
+ * The device drains once every request is answered and every staged task
+ * is in the engine; the data chunk being filled goes into checkpoints, a
+ * bulk transfer being filled is sent when draining starts.
+ */
+class ChimeraDevice : public ClockedObject, public ChimeraClient
+{
+  protected:
+    class ChimeraDeviceCpuSidePort : public ResponsePort
+    {
+      private:
+        ChimeraDevice* m_parent;
+        AddrRangeList  ranges;
+
+      public:
+        ChimeraDeviceCpuSidePort(const std::string& _name, ChimeraDevice* parent, AddrRange range);
+        ~ChimeraDeviceCpuSidePort();
+        bool          recvTimingReq(PacketPtr pkt) override;
+        void          recvRespRetry() override;
+        Tick          recvAtomic(PacketPtr pkt) override;
+        Tick          recvAtomicBackdoor(PacketPtr pkt, MemBackdoorPtr& backdoor) override;
+        void          recvFunctional(PacketPtr pkt) override;
+        void          recvMemBackdoorReq(const MemBackdoorReq& req, MemBackdoorPtr& backdoor) override;
+        AddrRangeList getAddrRanges() const override;
+    };
+
+    Chimera*                  m_chimera;
+    ChimeraDeviceCpuSidePort* m_cpu_side_port;
+    int                       m_deviceID;
+    int                       m_taskQuota;
+
+    Addr m_pioAddr;
+    Addr m_statusReg;
+    Addr m_dataOffset;
+    Addr m_outOffset;
+    Addr m_cardBase;
+    Tick m_pioDelay;
+
+    std::vector<ChimeraRegister> m_registers;
+
+    // tasks waiting for a table entry, in a staging ring that is
+    // preallocated and only grows (by doubling) when every task is still
+    // waiting. Data chunks and register writes share it, so they reach the
+    // card in the order they were written; m_local_node is the data chunk
+    // being filled
+    std::vector<PCIeTask> m_staged;
+    uint64_t              m_node_head;
+    uint64_t              m_node_tail;
+    uint8_t               m_local_node[TASK_DATA_SIZE];
+    uint64_t              m_local_node_addr;
+    uint64_t              m_local_node_ptr;
+
+    PCIeTask& stagedTask(uint64_t index)
+    {
+        return m_staged[index & (m_staged.size() - 1)];
+    }
+    void pushTask(const PCIeTask& task);
+    void pushDataNode();
+
+    bool m_enable_dataPlane_opt;
+
+    // bulk streaming: data-plane writes gather in m_bulkData, from
+    // m_bulkAddr, until it holds m_bulkMax bytes, a write does not follow
+    // on, a register is written or no write came for m_bulkFlushDelay. A
+    // transfer the engine has no room for yet waits in m_stagedBulk, with
+    // an invalid task standing for it in the staging ring
+    struct StagedBulk {
+        Addr                 m_addr;
+        std::vector<uint8_t> m_data;
+    };
+    bool                   m_bulk;
+    Tick                   m_bulkFlushDelay;
+    uint64_t               m_bulkMax;
+    Addr                   m_bulkAddr;
+    std::vector<uint8_t>   m_bulkData;
+    std::vector<uint8_t>   m_bulkSpare;
+    std::deque<StagedBulk> m_stagedBulk;
+    EventFunctionWrapper*  m_bulkFlushEvent;
+
+    void pushBulk();
+    void flushBulk();
+
+    // output DMA, see above; m_dmaData holds the burst being written
+    System*               m_system;
+    DmaPort*              m_dmaPort;
+    Addr                  m_dmaReg;
+    bool                  m_dmaVirtual;
+    Addr                  m_dmaAddr;
+    uint64_t              m_dmaSize;
+    Addr                  m_dmaStatusAddr;
+    uint64_t              m_dmaControl;
+    uint64_t              m_dmaWritten;
+    uint64_t              m_dmaInflight;
+    uint64_t              m_dmaStatus;
+    bool                  m_dmaBusy;
+    bool                  m_dmaStatusPending;
+    std::vector<uint8_t>  m_dmaData;
+    EventFunctionWrapper* m_dmaEvent;
+    EventFunctionWrapper* m_dmaBurstEvent;
+    EventFunctionWrapper* m_dmaStatusEvent;
+
+    bool isDmaRegister(Addr offset) const
+    {
+        return offset >= m_dmaReg && offset < m_dmaReg + CHIMERA_DMA_REGS_SIZE;
+    }
+    void dmaRead(PacketPtr pkt, Addr offset);
+    void dmaWrite(PacketPtr pkt, Addr offset);
+    bool dmaTranslate(Addr vaddr, Addr& paddr, uint64_t& extent);
+    void dmaStep();
+    void dmaBurstDone();
+    void dmaFinish(uint64_t flags);
+    void dmaStatusDone();
+
+    // output may have come in; a descriptor waiting for it goes on
+    void kickDma();
+
+    // the output the device produces, read back from the card by CDMA;
+    // a subclass that produces it itself overrides all four. peekOutput()
+    // reads like readOutput() and leaves the output in place
+    virtual uint64_t outputAvailable();
+    virtual void     readOutput(uint8_t* data, uint64_t size);
+    virtual void     peekOutput(uint8_t* data, uint64_t size);
+    virtual bool     outputEnded();
+
+    void addRegister(Addr offset, uint64_t start_bits = 0, uint64_t end_bits = 0);
+    const ChimeraRegister* findRegister(Addr offset) const;
+
+    void access(PacketPtr pkt);
+    void readAccess(PacketPtr pkt, Addr offset);
+    void writeAccess(PacketPtr pkt, Addr offset);
+    void writeRegister(const ChimeraRegister& reg, PacketPtr pkt, Addr offset);
+    void writeData(PacketPtr pkt, Addr offset);
+
+    // sends the response of the request at the head of the queue and
+    // moves on to the next one
+    void respond(PacketPtr pkt);
+
+    // serves a request at once, for atomic accesses; a subclass that
+    // handles requests itself overrides it as well
+    virtual Tick atomicAccess(PacketPtr pkt);
+    // answers a functional request from the current state, changing nothing
+    void functionalAccess(PacketPtr pkt);
+
+    // nothing is left that drain() waits for; subclasses add their own
+    // conditions and call checkDrained() once they may have been met
+    virtual bool isDrained() const;
+    void         checkDrained();
+
+  public:
+    EventFunctionWrapper* m_wakeupEvent;
+    EventFunctionWrapper* m_retryEvent;
+    EventFunctionWrapper* m_responseEvent;
+    std::list<PacketPtr>  m_pending_packets;
+    PacketPtr             m_stalling_packet;
+
+    ChimeraDevice(const ChimeraDeviceParams& p);
+    ~ChimeraDevice();
+
+    int deviceID()
+    {
+        return m_deviceID;
+    }
+
+    Addr pioAddr()
+    {
+        return m_pioAddr;
+    }
+
+    // called by the engine's worker threads when table entries have been
+    // released, and when results of tasks that asked for one are back;
+    // retry() and responseReady() then run in the simulation thread
+    void notifyRetry() override;
+    void notifyResponse() override;
+
+    virtual void retry();
+    virtual void responseReady()
+    {
+    }
+
+    // schedules processing of the pending requests
+    virtual void requestWakeup();
+
+    void  wakeup();
+    void  init() override;
+
+    DrainState drain() override;
+    void       serialize(CheckpointOut& cp) const override;
+    void       unserialize(CheckpointIn& cp) override;
+
+    void  submit();
+    Port& getPort(const std::string& if_name, PortID idx = InvalidPortID) override;
+};
+
+} // namespace fpga
+} // namespace gem5
+
+#endif
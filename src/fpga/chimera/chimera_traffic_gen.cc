@@ -0,0 +1,200 @@
+#include "fpga/chimera/chimera_traffic_gen.hh"
+
+#include <cstring>
+
+#include "base/logging.hh"
+#include "base/random.hh"
+#include "base/trace.hh"
+#include "debug/ChimeraTrafficGen.hh"
+#include "fpga/chimera/utils.hh"
+#include "sim/sim_exit.hh"
+
+namespace gem5
+{
+namespace fpga
+{
+
+ChimeraTrafficGen::ChimeraTrafficGen(const ChimeraTrafficGenParams& p) :
+    ClockedObject(p), m_chimera(p.chimera), m_deviceID(-1), m_taskQuota(p.task_quota), m_numTasks(p.num_tasks),
+    m_writePercent(p.write_percent), m_dataPercent(p.data_percent), m_respPercent(p.resp_percent),
+    m_payloadSize(p.payload_size), m_minPeriod(p.min_period), m_maxPeriod(p.max_period),
+    m_maxOutstanding(p.max_outstanding), m_cardBase(p.card_base), m_ctrlReg(p.ctrl_reg), m_stopReg(p.stop_reg),
+    m_stopValue(p.stop_value), m_sent(0), m_nextKind(DATA), m_hasNext(false), m_dataAddr(0), m_outstanding(0), m_waiting(false),
+    m_startTime(0), m_endTime(0), m_sendEvent([this] { send(); }, name() + ".sendEvent"),
+    m_notifyEvent([this] { wake(); }, name() + ".notifyEvent"), m_stats(*this)
+{
+    if (p.write_percent + p.data_percent + p.resp_percent + p.stop_percent != 100) {
+        fatal("%s: the shares of the task kinds must add up to 100\n", name());
+    }
+    if (m_payloadSize == 0 || m_payloadSize > TASK_DATA_SIZE || m_payloadSize % sizeof(uint64_t)) {
+        fatal("%s: payload_size must be a multiple of 8 up to %d\n", name(), TASK_DATA_SIZE);
+    }
+    if (m_minPeriod > m_maxPeriod) { fatal("%s: min_period is above max_period\n", name()); }
+}
+
+void ChimeraTrafficGen::init()
+{
+    m_deviceID = m_chimera->registerDevice(this, name(), m_taskQuota);
+}
+
+void ChimeraTrafficGen::startup()
+{
+    if (m_numTasks > 0) { schedule(m_sendEvent, nextCycle()); }
+}
+
+void ChimeraTrafficGen::notifyRetry()
+{
+    scheduleFromWorker(eventQueue(), &m_notifyEvent);
+}
+
+void ChimeraTrafficGen::notifyResponse()
+{
+    scheduleFromWorker(eventQueue(), &m_notifyEvent);
+}
+
+void ChimeraTrafficGen::wake()
+{
+    // a table entry or a result the generator waits for has come in; it
+    // goes on at once rather than at the next poll. A generator waiting
+    // for its next period picks results up then
+    if (m_waiting) {
+        m_waiting = false;
+        reschedule(m_sendEvent, curTick(), true);
+    }
+}
+
+ChimeraTrafficGen::TaskKind ChimeraTrafficGen::pickKind()
+{
+    unsigned draw = random_mt.random(0, 99);
+    if (draw < m_writePercent) { return CTRL_WRITE; }
+    draw -= m_writePercent;
+    if (draw < m_dataPercent) { return DATA; }
+    draw -= m_dataPercent;
+    if (draw < m_respPercent) { return RESP; }
+    return STOP;
+}
+
+void ChimeraTrafficGen::fillTask(PCIeTask* task, TaskKind kind)
+{
+    task->setValid();
+    task->m_stream = m_deviceID;
+
+    if (kind == DATA) {
+        // chunks follow each other through the data plane, from its start
+        // again once they reach the CDMA window
+        uint8_t payload[TASK_DATA_SIZE];
+        for (unsigned i = 0; i < m_payloadSize; i += sizeof(uint64_t)) {
+            uint64_t word = random_mt.random<uint64_t>();
+            std::memcpy(payload + i, &word, sizeof(uint64_t));
+        }
+        task->setDataType();
+        task->fillData(m_cardBase + CHIMERA_DATA_PLANE_BASE + m_dataAddr, payload, m_payloadSize);
+        m_dataAddr = (m_dataAddr + m_payloadSize) % (CHIMERA_CDMA_BASE - CHIMERA_DATA_PLANE_BASE);
+        m_stats.dataChunks++;
+        m_stats.bytes += m_payloadSize;
+        return;
+    }
+
+    uint64_t addr  = m_cardBase + (kind == STOP ? m_stopReg : m_ctrlReg);
+    uint64_t value = kind == STOP ? m_stopValue : m_sent;
+    task->setWriteType();
+    if (kind == RESP) { task->setNeedResp(); }
+    std::memcpy(&(task->m_content[0]), &addr, sizeof(uint64_t));
+    std::memcpy(&(task->m_content[8]), &value, sizeof(uint64_t));
+    m_stats.bytes += TASK_CTRL_DATA_SIZE;
+
+    if (kind == CTRL_WRITE) {
+        m_stats.ctrlWrites++;
+    } else if (kind == RESP) {
+        m_stats.respTasks++;
+    } else {
+        m_stats.stops++;
+    }
+}
+
+void ChimeraTrafficGen::collect()
+{
+    m_harvested.clear();
+    int count = m_chimera->harvestResps(m_deviceID, m_harvested);
+    m_outstanding -= count;
+    m_stats.responses += count;
+}
+
+void ChimeraTrafficGen::send()
+{
+    m_waiting = false;
+    collect();
+
+    while (m_sent < m_numTasks) {
+        if (!m_hasNext) {
+            m_nextKind = pickKind();
+            m_hasNext  = true;
+        }
+        if (m_nextKind == RESP && m_maxOutstanding > 0 && m_outstanding >= m_maxOutstanding) { break; }
+
+        PCIeTask* task = m_chimera->tryAllocTask(m_deviceID);
+        if (!task) {
+            DPRINTF(ChimeraTrafficGen, "no free table entry after %d tasks\n", m_sent);
+            m_stats.noEntry++;
+            break;
+        }
+
+        if (m_sent == 0) { m_startTime = get_system_time_nanosecond(); }
+        fillTask(task, m_nextKind);
+        m_chimera->submitTask(task);
+        if (m_nextKind == RESP) { m_outstanding++; }
+        m_hasNext = false;
+        m_sent++;
+        m_stats.tasks++;
+
+        if (m_maxPeriod > 0 && m_sent < m_numTasks) {
+            schedule(m_sendEvent, curTick() + random_mt.random(m_minPeriod, m_maxPeriod));
+            return;
+        }
+    }
+
+    if (m_sent == m_numTasks && m_outstanding == 0) {
+        m_endTime = get_system_time_nanosecond();
+        DPRINTF(ChimeraTrafficGen, "%d tasks done in %d ns\n", m_sent, m_endTime - m_startTime);
+        exitSimLoop(name() + " done");
+        return;
+    }
+
+    // waiting for a table entry or a result; the poll keeps simulated time
+    // going while the worker threads get there
+    m_waiting = true;
+    schedule(m_sendEvent, clockEdge(Cycles(CHIMERA_TRAFFIC_GEN_POLL_CYCLES)));
+}
+
+ChimeraTrafficGen::ChimeraTrafficGenStats::ChimeraTrafficGenStats(ChimeraTrafficGen& g) :
+    statistics::Group(&g), parent(g),
+    ADD_STAT(tasks, statistics::units::Count::get(), "tasks sent"),
+    ADD_STAT(ctrlWrites, statistics::units::Count::get(), "control writes sent"),
+    ADD_STAT(dataChunks, statistics::units::Count::get(), "data chunks sent"),
+    ADD_STAT(respTasks, statistics::units::Count::get(), "tasks sent that ask for a response"),
+    ADD_STAT(stops, statistics::units::Count::get(), "stream stops sent"),
+    ADD_STAT(bytes, statistics::units::Byte::get(), "payload bytes sent"),
+    ADD_STAT(responses, statistics::units::Count::get(), "responses fetched"),
+    ADD_STAT(noEntry, statistics::units::Count::get(), "times a task found no free table entry"),
+    ADD_STAT(hostSeconds, statistics::units::Second::get(), "host time from the first task to the last response"),
+    ADD_STAT(tasksPerSecond, statistics::units::Rate<statistics::units::Count, statistics::units::Second>::get(),
+             "tasks per second of host time"),
+    ADD_STAT(bytesPerSecond, statistics::units::Rate<statistics::units::Byte, statistics::units::Second>::get(),
+             "payload bytes per second of host time")
+{
+}
+
+void ChimeraTrafficGen::ChimeraTrafficGenStats::regStats()
+{
+    statistics::Group::regStats();
+
+    hostSeconds.functor([this]() {
+        if (parent.m_endTime == 0) { return 0.0; }
+        return (parent.m_endTime - parent.m_startTime) / 1e9;
+    });
+    tasksPerSecond = tasks / hostSeconds;
+    bytesPerSecond = bytes / hostSeconds;
+}
+
+} // namespace fpga
+} // namespace gem5
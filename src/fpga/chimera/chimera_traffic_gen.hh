@@ -0,0 +1,122 @@
+#ifndef __FPGA_CHIMERA_CHIMERA_TRAFFIC_GEN_HH__
+#define __FPGA_CHIMERA_CHIMERA_TRAFFIC_GEN_HH__
+
+#include <vector>
+
+#include "base/statistics.hh"
+#include "params/ChimeraTrafficGen.hh"
+#include "sim/clocked_object.hh"
+
+#include "fpga/chimera/chimera.hh"
+
+// how often a generator waiting for the engine looks again; the engine's
+// notifications bring it back earlier
+#define CHIMERA_TRAFFIC_GEN_POLL_CYCLES 1000
+
+namespace gem5
+{
+namespace fpga
+{
+
+/**
+ * Synthetic traffic for a Chimera engine, modelled on the memory traffic
+ * generators, to characterise the engine apart from any device model and
+ * guest code. It hands the engine a random mix of the tasks a device
+ * sends:
+ *  - control writes to ctrl_reg, posted
+ *  - data chunks of payload_size bytes, at consecutive data-plane
+ *    addresses so the engine may batch them
+ *  - response tasks, control tasks to ctrl_reg that ask for a result, as
+ *    register reads do; the result is fetched once the engine has it
+ *  - stream stops, stop_value written to stop_reg
+ *
+ * A task goes every min_period to max_period (open loop), or as soon as a
+ * table entry is free when both are 0. At most max_outstanding response
+ * tasks wait for their result at once (closed loop); every task also
+ * waits for a table entry, of which the generator holds at most
+ * task_quota. The simulation exits once num_tasks are sent and every
+ * response is back.
+ *
+ * Throughput is measured in host time, from the first task to the last
+ * response, since that is what the engine and the card take; the latency
+ * of each task is in the engine's stats and trace. IP output shares the
+ * result window with responses, as on the card, so mixes of response tasks
+ * and data or stops need an IP without output (emulatedOutput=False on the
+ * emulated card).
+ */
+class ChimeraTrafficGen : public ClockedObject, public ChimeraClient
+{
+  private:
+    enum TaskKind { CTRL_WRITE, DATA, RESP, STOP };
+
+    Chimera* m_chimera;
+    int      m_deviceID;
+    int      m_taskQuota;
+
+    uint64_t m_numTasks;
+    unsigned m_writePercent;
+    unsigned m_dataPercent;
+    unsigned m_respPercent;
+    unsigned m_payloadSize;
+    Tick     m_minPeriod;
+    Tick     m_maxPeriod;
+    unsigned m_maxOutstanding;
+    Addr     m_cardBase;
+    Addr     m_ctrlReg;
+    Addr     m_stopReg;
+    uint64_t m_stopValue;
+
+    uint64_t         m_sent;
+    TaskKind         m_nextKind;
+    bool             m_hasNext;
+    Addr             m_dataAddr;
+    unsigned         m_outstanding;
+    bool             m_waiting;
+    uint64_t         m_startTime;
+    uint64_t         m_endTime;
+
+    // results of the last collect(), kept to reuse its storage
+    std::vector<CompletedTask> m_harvested;
+
+    EventFunctionWrapper m_sendEvent;
+    EventFunctionWrapper m_notifyEvent;
+
+    TaskKind pickKind();
+    void     fillTask(PCIeTask* task, TaskKind kind);
+
+    void send();
+    void collect();
+    void wake();
+
+  public:
+    ChimeraTrafficGen(const ChimeraTrafficGenParams& p);
+
+    void init() override;
+    void startup() override;
+
+    void notifyRetry() override;
+    void notifyResponse() override;
+
+    struct ChimeraTrafficGenStats : public statistics::Group {
+        ChimeraTrafficGenStats(ChimeraTrafficGen& g);
+        ChimeraTrafficGen& parent;
+        void regStats() override;
+
+        statistics::Scalar  tasks;
+        statistics::Scalar  ctrlWrites;
+        statistics::Scalar  dataChunks;
+        statistics::Scalar  respTasks;
+        statistics::Scalar  stops;
+        statistics::Scalar  bytes;
+        statistics::Scalar  responses;
+        statistics::Scalar  noEntry;
+        statistics::Value   hostSeconds;
+        statistics::Formula tasksPerSecond;
+        statistics::Formula bytesPerSecond;
+    } m_stats;
+};
+
+} // namespace fpga
+} // namespace gem5
+
+#endif
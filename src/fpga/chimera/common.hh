@@ -11,15 +11,56 @@ namespace gem5
 namespace fpga
 {
 
-#define MAX_BATCH_THRESHOLD 3
+// ceiling of the runtime batch size: the request header carries the task
+// count in 4 bits (wbatch in axi_wrapper.sv)
+#define MAX_BATCH_THRESHOLD 15
 #define TASK_HEADER_SIZE 10
 #define TASK_CTRL_DATA_SIZE 16
 #define TASK_CTRL_PKT_SIZE ((TASK_HEADER_SIZE) + (TASK_CTRL_DATA_SIZE))
 #define TASK_DATA_SIZE 64
 #define RESULT_DATA_SIZE 32
 
+// register/response map of the card (see axi_wrapper.sv)
+#define CHIMERA_REQ_WINDOW      0x0
+#define CHIMERA_REG_RESET       0x1000
+#define CHIMERA_REG_READ_MODE   0x1008
+#define CHIMERA_REG_BATCH       0x1010
+#define CHIMERA_REG_STOP        0x2000
+#define CHIMERA_REG_CAPS        0x3000
+#define CHIMERA_DATA_PLANE_BASE 0x1000000
+#define CHIMERA_CDMA_BASE       0x10000000
+#define CHIMERA_REG_MSG_SIZE    32
+
+// the capability block read at CHIMERA_REG_CAPS. The magic reads "RMHC";
+// its low bit is clear, so the block never passes for a response packet,
+// and a card built without the block answers with an empty packet
+#define CHIMERA_CAPS_MAGIC   0x43484d52
+#define CHIMERA_CAPS_VERSION 1
+
+// bytes of data plane the card takes into one input-buffer slot
+#define CHIMERA_DATA_BEAT_SIZE 8
+
 #pragma pack(1)
 
+/**
+ * What the card was built with, so the host sizes its transfers from the
+ * bitstream rather than from constants kept in step by hand, and the
+ * count of input-buffer slots the IP has drained since the last reset,
+ * from which the host works out how many it may fill. Every control task
+ * takes one slot, a data-plane write one per CHIMERA_DATA_BEAT_SIZE bytes.
+ */
+struct ChimeraCaps {
+    uint32_t m_magic;
+    uint16_t m_version;
+    uint16_t m_maxBatch;     // tasks or results one transfer may carry
+    uint32_t m_ibufferDepth; // slots of the input buffer
+    uint32_t m_obufferDepth; // results the output buffer holds
+    uint16_t m_taskBits;     // width of a task on the card
+    uint16_t m_resultBits;   // width of a result on the card
+    uint32_t m_reserved;
+    uint64_t m_consumed;     // input-buffer slots drained since reset
+};
+
 struct PCIeCtrlTask {
     uint8_t  m_basic;                        // [7:0]  0: valid; 1: needResp; 2: write; 3: read; 4: data, 5~7: reserved
     int8_t   m_tableID;                      // [15:8]
@@ -40,6 +81,7 @@ struct PCIeTask {
     uint8_t  m_content[TASK_DATA_SIZE];
     uint32_t m_addr;
     uint32_t m_size;
+    uint8_t  m_stream;     // tasks of one stream keep their order and channel; one stream per device
 
     PCIeTask()
     {
@@ -48,6 +90,7 @@ struct PCIeTask {
         m_insertTime = 0;
         m_addr       = 0;
         m_size       = 0;
+        m_stream     = 0;
         std::memset(&m_content, 0, TASK_DATA_SIZE);
     }
 
@@ -174,16 +217,19 @@ struct taskTableEntry {
     bool       m_valid;
     bool       m_complete;
     int8_t     m_tableID;
+    int        m_device;   // device holding the entry, -1 if none
     uint64_t   m_taskUID;
-    PCIeTask   m_task;
+    PCIeTask*  m_task;     // the entry's slot in the pinned task pool
     PCIeResult m_result;
     uint64_t   m_enqueueTime;
 
-    taskTableEntry(int tableID)
+    taskTableEntry(int tableID, PCIeTask* task)
     {
         m_valid       = false;
         m_complete    = false;
         m_tableID     = tableID;
+        m_device      = -1;
+        m_task        = task;
         m_enqueueTime = 0;
     }
 };
@@ -196,17 +242,25 @@ struct alignas(16) PCIeReqPkt {
 
     PCIeReqPkt(int limit_batch_size)
     {
+        assert(limit_batch_size > 0 && limit_batch_size <= MAX_BATCH_THRESHOLD);
         m_valid = 0x0;
+        m_batch = 0;
         m_size  = 1 + 1 + sizeof(PCIeCtrlTask) * limit_batch_size;
     }
 
-    void fillTask(int index, PCIeTask task)
+    void fillTask(int index, const PCIeTask& task)
     {
         m_tasks[index].m_basic      = task.m_basic;
         m_tasks[index].m_tableID    = task.m_tableID;
         m_tasks[index].m_insertTime = task.m_insertTime;
         std::memcpy(&(m_tasks[index].m_content[0]), &(task.m_content[0]), TASK_CTRL_DATA_SIZE);
     }
+
+    // bytes on the wire for the tasks filled so far
+    uint64_t getSize()
+    {
+        return 1 + 1 + sizeof(PCIeCtrlTask) * m_batch;
+    }
 };
 
 struct alignas(16) PCIeDataPkt {
@@ -217,30 +271,27 @@ struct alignas(16) PCIeDataPkt {
 
     PCIeDataPkt(int limit_batch_size)
     {
+        assert(limit_batch_size > 0 && limit_batch_size <= MAX_BATCH_THRESHOLD);
         m_start_addr = 0;
         m_total_size = 0;
         std::memset(&m_data, 0, MAX_BATCH_THRESHOLD * TASK_DATA_SIZE);
-        m_size = 4 + 4 + TASK_DATA_SIZE * limit_batch_size;
+        m_size = TASK_DATA_SIZE * limit_batch_size;
     }
 
-    int fillTask(int index, PCIeTask task)
+    // appends a chunk; fails if it does not continue the chunks already in
+    // the packet or does not fit
+    int fillTask(int index, const PCIeTask& task)
     {
-        int result = 0;
+        assert(task.m_size <= TASK_DATA_SIZE);
         if (index == 0) {
             m_start_addr = task.m_addr;
-            m_total_size = task.m_size;
-            std::memcpy(&m_data, &task.m_content, TASK_DATA_SIZE);
-            result = 0;
-        } else {
-            if (m_start_addr + m_total_size != task.m_addr) {
-                result = -1;
-            } else {
-                m_total_size += task.m_size;
-                std::memcpy(&m_data + index * TASK_DATA_SIZE, &task.m_content, TASK_DATA_SIZE);
-                result = 0;
-            }
+            m_total_size = 0;
+        } else if (m_start_addr + m_total_size != task.m_addr || m_total_size + task.m_size > m_size) {
+            return -1;
         }
-        return result;
+        std::memcpy(m_data + m_total_size, &task.m_content, task.m_size);
+        m_total_size += task.m_size;
+        return 0;
     }
 
     uint8_t* getDataPtr()
@@ -267,6 +318,7 @@ struct alignas(16) PCIeRespPkt {
 
     PCIeRespPkt(int limit_batch_size)
     {
+        assert(limit_batch_size > 0 && limit_batch_size <= MAX_BATCH_THRESHOLD);
         m_valid = 0x0;
         m_size  = 1 + 1 + sizeof(PCIeResult) * limit_batch_size;
     }
@@ -0,0 +1,69 @@
+#include <gtest/gtest.h>
+
+#include "fpga/chimera/common.hh"
+
+using namespace gem5::fpga;
+
+static PCIeTask dataTask(uint32_t addr, uint8_t fill)
+{
+    PCIeTask task;
+    task.setValid();
+    task.setDataType();
+    task.m_addr = addr;
+    task.m_size = TASK_DATA_SIZE;
+    std::memset(&task.m_content, fill, TASK_DATA_SIZE);
+    return task;
+}
+
+TEST(ChimeraPacketTest, DataPktCoalescesContiguousChunks)
+{
+    PCIeDataPkt pkt(3);
+
+    EXPECT_EQ(pkt.fillTask(0, dataTask(0x1000000, 0xa)), 0);
+    EXPECT_EQ(pkt.fillTask(1, dataTask(0x1000040, 0xb)), 0);
+    EXPECT_EQ(pkt.getAddr(), 0x1000000);
+    EXPECT_EQ(pkt.getSize(), 2 * TASK_DATA_SIZE);
+    EXPECT_EQ(pkt.getDataPtr()[0], 0xa);
+    EXPECT_EQ(pkt.getDataPtr()[TASK_DATA_SIZE - 1], 0xa);
+    EXPECT_EQ(pkt.getDataPtr()[TASK_DATA_SIZE], 0xb);
+    EXPECT_EQ(pkt.getDataPtr()[2 * TASK_DATA_SIZE - 1], 0xb);
+}
+
+TEST(ChimeraPacketTest, DataPktRejectsGapsAndOverflow)
+{
+    PCIeDataPkt pkt(2);
+
+    EXPECT_EQ(pkt.fillTask(0, dataTask(0x1000000, 0x1)), 0);
+    EXPECT_EQ(pkt.fillTask(1, dataTask(0x1000080, 0x2)), -1);
+    EXPECT_EQ(pkt.fillTask(1, dataTask(0x1000040, 0x3)), 0);
+    EXPECT_EQ(pkt.fillTask(2, dataTask(0x1000080, 0x4)), -1);
+    EXPECT_EQ(pkt.getSize(), 2 * TASK_DATA_SIZE);
+
+    // a new batch starts over at index 0
+    EXPECT_EQ(pkt.fillTask(0, dataTask(0x2000000, 0x5)), 0);
+    EXPECT_EQ(pkt.getAddr(), 0x2000000);
+    EXPECT_EQ(pkt.getSize(), TASK_DATA_SIZE);
+    EXPECT_EQ(pkt.getDataPtr()[0], 0x5);
+}
+
+TEST(ChimeraPacketTest, ReqPktSizeFollowsBatch)
+{
+    PCIeReqPkt pkt(MAX_BATCH_THRESHOLD);
+
+    PCIeTask task;
+    task.setValid();
+    task.setWriteType();
+    for (int i = 0; i < 4; ++i) {
+        task.m_tableID = i;
+        pkt.fillTask(i, task);
+    }
+    pkt.m_batch = 4;
+
+    EXPECT_EQ(pkt.getSize(), 2 + 4 * sizeof(PCIeCtrlTask));
+    EXPECT_EQ(pkt.m_tasks[3].m_tableID, 3);
+
+    // the header and tasks are what goes on the wire, back to back
+    const uint8_t* wire = reinterpret_cast<const uint8_t*>(&pkt);
+    EXPECT_EQ(wire[1], 4);
+    EXPECT_EQ((int8_t)wire[2 + 3 * sizeof(PCIeCtrlTask) + 1], 3);
+}
@@ -0,0 +1,88 @@
+#include "fpga/chimera/dma_pool.hh"
+
+#include <linux/mempolicy.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <vector>
+
+#include "base/logging.hh"
+#include "base/trace.hh"
+#include "debug/Chimera.hh"
+#include "fpga/chimera/ringBuffer.hh"
+
+namespace gem5
+{
+namespace fpga
+{
+
+static uint64_t roundUp(uint64_t value, uint64_t align)
+{
+    return (value + align - 1) / align * align;
+}
+
+// prefer the pages of [base, base + size) on node; they must not be
+// faulted in yet
+static bool bindToNode(void* base, uint64_t size, int node)
+{
+    const int                  bits = 8 * sizeof(unsigned long);
+    std::vector<unsigned long> mask(node / bits + 1, 0);
+    mask[node / bits] |= 1UL << (node % bits);
+    return syscall(SYS_mbind, base, size, MPOL_PREFERRED, mask.data(), mask.size() * bits + 1, 0) == 0;
+}
+
+DMABufferPool::DMABufferPool(int slot_num, uint64_t slot_size, bool huge_page, int numa_node) :
+    m_base(nullptr), m_slotNum(slot_num), m_hugePage(false), m_locked(false), m_numaNode(-1)
+{
+    assert(slot_num > 0 && slot_size > 0);
+    m_slotSize = roundUp(slot_size, CHIMERA_CACHE_LINE_SIZE);
+
+    void* base = MAP_FAILED;
+    if (huge_page) {
+        m_mapSize = roundUp(m_slotSize * slot_num, CHIMERA_HUGE_PAGE_SIZE);
+        base      = mmap(nullptr, m_mapSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (base == MAP_FAILED) {
+            warn_once("chimera: no huge pages reserved for the DMA buffer pool, falling back to regular pages\n");
+        } else {
+            m_hugePage = true;
+        }
+    }
+    if (base == MAP_FAILED) {
+        m_mapSize = roundUp(m_slotSize * slot_num, CHIMERA_PAGE_SIZE);
+        base      = mmap(nullptr, m_mapSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (base == MAP_FAILED) { panic("chimera: failed to map %d bytes for the DMA buffer pool\n", m_mapSize); }
+        if (huge_page) { madvise(base, m_mapSize, MADV_HUGEPAGE); }
+    }
+    m_base = static_cast<uint8_t*>(base);
+
+    if (numa_node >= 0) {
+        if (bindToNode(m_base, m_mapSize, numa_node)) {
+            m_numaNode = numa_node;
+        } else {
+            warn_once("chimera: failed to bind the DMA buffer pool to NUMA node %d\n", numa_node);
+        }
+    }
+
+    if (mlock(m_base, m_mapSize) == 0) {
+        m_locked = true;
+    } else {
+        warn_once("chimera: failed to lock the DMA buffer pool (RLIMIT_MEMLOCK?), it may be paged out\n");
+    }
+
+    // touch every page now rather than on the first transfer
+    std::memset(m_base, 0, m_mapSize);
+
+    DPRINTF(Chimera, "DMA buffer pool: %d slots of %d bytes, huge page: %d, locked: %d, numa node: %d\n", m_slotNum,
+            m_slotSize, m_hugePage, m_locked, m_numaNode);
+}
+
+DMABufferPool::~DMABufferPool()
+{
+    if (m_locked) { munlock(m_base, m_mapSize); }
+    munmap(m_base, m_mapSize);
+}
+
+} // namespace fpga
+} // namespace gem5
@@ -0,0 +1,92 @@
+#ifndef __FPGA_CHIMERA_DMA_POOL_HH__
+#define __FPGA_CHIMERA_DMA_POOL_HH__
+
+#include <assert.h>
+#include <stdint.h>
+
+namespace gem5
+{
+namespace fpga
+{
+
+#define CHIMERA_PAGE_SIZE      4096
+#define CHIMERA_HUGE_PAGE_SIZE (2 * 1024 * 1024)
+
+/**
+ * Pinned memory the Chimera packets are built and DMA'd from. The region
+ * is mapped once and page aligned. It is backed by huge pages when asked
+ * and the host has them reserved, and by transparent huge pages
+ * otherwise. When a NUMA node is given, the pages are allocated on it,
+ * next to the card. It is locked, so the driver never has to fault it in
+ * while it sets up a transfer. The region is split into equal, cache-line
+ * aligned slots addressed by index. Threads hand a slot over by passing
+ * its index; the pool itself does no bookkeeping.
+ */
+class DMABufferPool
+{
+  private:
+    uint8_t* m_base;
+    uint64_t m_mapSize;
+    uint64_t m_slotSize;
+    int      m_slotNum;
+    bool     m_hugePage;
+    bool     m_locked;
+    int      m_numaNode;
+
+  public:
+    DMABufferPool(int slot_num, uint64_t slot_size, bool huge_page = false, int numa_node = -1);
+    ~DMABufferPool();
+
+    uint8_t* slot(int index)
+    {
+        assert(index >= 0 && index < m_slotNum);
+        return m_base + index * m_slotSize;
+    }
+
+    template <typename T>
+    T* at(int index)
+    {
+        assert(sizeof(T) <= m_slotSize);
+        return reinterpret_cast<T*>(slot(index));
+    }
+
+    uint8_t* base()
+    {
+        return m_base;
+    }
+
+    uint64_t mapSize()
+    {
+        return m_mapSize;
+    }
+
+    int slotNum()
+    {
+        return m_slotNum;
+    }
+
+    uint64_t slotSize()
+    {
+        return m_slotSize;
+    }
+
+    bool isHugePage()
+    {
+        return m_hugePage;
+    }
+
+    bool isLocked()
+    {
+        return m_locked;
+    }
+
+    int numaNode()
+    {
+        return m_numaNode;
+    }
+};
+
+} // namespace fpga
+} // namespace gem5
+
+#endif
@@ -0,0 +1,291 @@
+#include "fpga/chimera/emulated_transport.hh"
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sched.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <new>
+
+#include "base/logging.hh"
+#include "base/trace.hh"
+#include "debug/FPGAEngine.hh"
+#include "fpga/chimera/utils.hh"
+
+namespace gem5
+{
+namespace fpga
+{
+
+EmulatedTransport::EmulatedTransport(const std::string& shm_name, int channel_num, bool output) :
+    Transport(channel_num), m_shmName(shm_name), m_card(nullptr), m_startTime(0), m_output(output), m_foldBytes(0),
+    m_eventFd(-1), m_eventWaiters(0)
+{
+    std::memset(m_fold, 0, RESULT_DATA_SIZE);
+}
+
+EmulatedTransport::~EmulatedTransport()
+{
+    close();
+}
+
+void EmulatedTransport::open()
+{
+    void* region = MAP_FAILED;
+    if (m_shmName.empty()) {
+        region = mmap(nullptr, sizeof(EmulatedCardState), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    } else {
+        int fd = shm_open(m_shmName.c_str(), O_CREAT | O_RDWR, 0600);
+        if (fd < 0) { panic("*** ERROR: failed to open shared memory %s\n", m_shmName); }
+        if (ftruncate(fd, sizeof(EmulatedCardState)) != 0) {
+            panic("*** ERROR: failed to size shared memory %s\n", m_shmName);
+        }
+        region = mmap(nullptr, sizeof(EmulatedCardState), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        ::close(fd);
+    }
+    if (region == MAP_FAILED) { panic("*** ERROR: failed to map emulated card state\n"); }
+
+    m_card = new (region) EmulatedCardState();
+    m_card->m_head.store(0, std::memory_order_relaxed);
+    m_card->m_tail.store(0, std::memory_order_relaxed);
+    m_card->m_batchThreshold.store(1, std::memory_order_relaxed);
+    m_card->m_pollMode.store(0, std::memory_order_relaxed);
+    m_card->m_stopped.store(0, std::memory_order_relaxed);
+    m_card->m_overflow.store(0, std::memory_order_relaxed);
+    m_card->m_consumed.store(0, std::memory_order_relaxed);
+
+    m_eventFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (m_eventFd < 0) { warn("emulated card: no eventfd, results can only be polled\n"); }
+
+    m_startTime = get_system_time_nanosecond();
+    DPRINTF(FPGAEngine, "SUCCESS: open emulated card (%s)\n", m_shmName.empty() ? "anonymous" : m_shmName);
+}
+
+void EmulatedTransport::close()
+{
+    if (m_eventFd >= 0) {
+        ::close(m_eventFd);
+        m_eventFd = -1;
+    }
+    if (m_card) {
+        m_card->~EmulatedCardState();
+        munmap(m_card, sizeof(EmulatedCardState));
+        m_card = nullptr;
+        if (!m_shmName.empty()) { shm_unlink(m_shmName.c_str()); }
+    }
+}
+
+uint64_t EmulatedTransport::counter()
+{
+    return (get_system_time_nanosecond() - m_startTime) / EMULATED_CLOCK_PERIOD_NS;
+}
+
+void EmulatedTransport::pushResult(const PCIeResult& result)
+{
+    uint64_t head = m_card->m_head.load(std::memory_order_relaxed);
+    if (head - m_card->m_tail.load(std::memory_order_acquire) >= EMULATED_OBUFFER_DEPTH) {
+        m_card->m_overflow.fetch_add(1, std::memory_order_relaxed);
+        warn_once("emulated card output buffer overflow, results are dropped\n");
+        return;
+    }
+    m_card->m_results[head % EMULATED_OBUFFER_DEPTH] = result;
+    m_card->m_head.store(head + 1, std::memory_order_release);
+
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_eventFd >= 0 && m_eventWaiters.load(std::memory_order_relaxed) > 0) {
+        uint64_t one = 1;
+        [[maybe_unused]] ssize_t ret = ::write(m_eventFd, &one, sizeof(one));
+    }
+}
+
+bool EmulatedTransport::waitEvent(int channel, uint64_t timeout_ns)
+{
+    m_eventWaiters.fetch_add(1, std::memory_order_seq_cst);
+    bool ready = m_card->m_head.load(std::memory_order_acquire) != m_card->m_tail.load(std::memory_order_acquire);
+    if (!ready) {
+        pollfd          pfd     = {m_eventFd, POLLIN, 0};
+        struct timespec timeout = {(time_t)(timeout_ns / 1000000000), (long)(timeout_ns % 1000000000)};
+        ready                   = ppoll(&pfd, 1, &timeout, nullptr) > 0;
+    }
+    // every waiter wakes up on a signal, whoever drains it
+    uint64_t count = 0;
+    [[maybe_unused]] ssize_t ret = ::read(m_eventFd, &count, sizeof(count));
+    m_eventWaiters.fetch_sub(1, std::memory_order_relaxed);
+    return ready;
+}
+
+void EmulatedTransport::pushData(const void* data, uint64_t size)
+{
+    assert(size <= RESULT_DATA_SIZE);
+    PCIeResult result;
+    std::memset(&result, 0, sizeof(PCIeResult));
+    result.m_valid = 0x1;
+    std::memcpy(&(result.m_content[0]), data, size);
+    pushResult(result);
+}
+
+void EmulatedTransport::pushFinish()
+{
+    PCIeResult result;
+    std::memset(&result, 0, sizeof(PCIeResult));
+    result.m_valid = 0x3;
+    pushResult(result);
+}
+
+void EmulatedTransport::ipReset()
+{
+    std::memset(m_fold, 0, RESULT_DATA_SIZE);
+    m_foldBytes = 0;
+}
+
+void EmulatedTransport::ipCaps(ChimeraCaps& caps)
+{
+    caps.m_magic        = CHIMERA_CAPS_MAGIC;
+    caps.m_version      = CHIMERA_CAPS_VERSION;
+    caps.m_maxBatch     = MAX_BATCH_THRESHOLD;
+    caps.m_ibufferDepth = EMULATED_IBUFFER_DEPTH;
+    caps.m_obufferDepth = EMULATED_OBUFFER_DEPTH;
+    caps.m_taskBits     = sizeof(PCIeCtrlTask) * 8;
+    caps.m_resultBits   = sizeof(PCIeResult) * 8;
+    caps.m_reserved     = 0;
+    caps.m_consumed     = m_card->m_consumed.load(std::memory_order_relaxed);
+}
+
+void EmulatedTransport::ipTask(const PCIeCtrlTask& task)
+{
+    uint64_t addr  = 0;
+    uint64_t value = 0;
+    std::memcpy(&addr, &(task.m_content[0]), sizeof(uint64_t));
+    std::memcpy(&value, &(task.m_content[8]), sizeof(uint64_t));
+
+    if (addr >= CHIMERA_DATA_PLANE_BASE) {
+        ipData(addr, &(task.m_content[8]));
+    } else if (addr == 0x0 && (value & 0x2)) {
+        if (m_output) {
+            if (m_foldBytes % (RESULT_DATA_SIZE * EMULATED_OUTPUT_RATIO) != 0) { pushData(m_fold, RESULT_DATA_SIZE); }
+            pushFinish();
+        }
+        ipReset();
+    }
+
+    if (task.m_basic & 0x2) {
+        PCIeResult result;
+        std::memset(&result, 0, sizeof(PCIeResult));
+        result.m_valid        = 0x1;
+        result.m_tableID      = task.m_tableID;
+        result.m_executedTime = counter() - task.m_insertTime;
+        std::memcpy(&(result.m_content[0]), &(task.m_content[0]), TASK_CTRL_DATA_SIZE);
+        pushResult(result);
+    }
+}
+
+void EmulatedTransport::ipData(uint64_t addr, const uint8_t* beat)
+{
+    if (!m_output) { return; }
+
+    uint64_t offset = m_foldBytes % RESULT_DATA_SIZE;
+    for (int i = 0; i < 8; ++i) { m_fold[offset + i] ^= beat[i]; }
+    m_foldBytes += 8;
+
+    if (m_foldBytes % (RESULT_DATA_SIZE * EMULATED_OUTPUT_RATIO) == 0) {
+        pushData(m_fold, RESULT_DATA_SIZE);
+        std::memset(m_fold, 0, RESULT_DATA_SIZE);
+    }
+}
+
+void EmulatedTransport::decodeRequest(const uint8_t* pkt, uint64_t size)
+{
+    uint8_t batch = pkt[1];
+    assert(2 + batch * sizeof(PCIeCtrlTask) <= size);
+    for (int i = 0; i < batch; ++i) {
+        PCIeCtrlTask task;
+        std::memcpy(&task, pkt + 2 + i * sizeof(PCIeCtrlTask), sizeof(PCIeCtrlTask));
+        // the card stamps the decode time into the insert field
+        task.m_insertTime = counter();
+        ipTask(task);
+        m_card->m_consumed.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+int64_t EmulatedTransport::write(uint64_t addr, uint64_t size, const void* msg, int channel)
+{
+    assert(channel < m_channelNum);
+    std::lock_guard<std::mutex> lock(m_writeMTX);
+
+    const uint8_t* bytes = static_cast<const uint8_t*>(msg);
+
+    if (addr >= CHIMERA_DATA_PLANE_BASE) {
+        for (uint64_t i = 0; i + 8 <= size; i += 8) { ipData(addr + i, bytes + i); }
+        m_card->m_consumed.fetch_add(size / CHIMERA_DATA_BEAT_SIZE, std::memory_order_relaxed);
+    } else if (addr == CHIMERA_REQ_WINDOW) {
+        decodeRequest(bytes, size);
+    } else if (addr == CHIMERA_REG_RESET) {
+        m_card->m_tail.store(m_card->m_head.load(std::memory_order_acquire), std::memory_order_release);
+        m_card->m_stopped.store(0, std::memory_order_relaxed);
+        m_card->m_consumed.store(0, std::memory_order_relaxed);
+        ipReset();
+    } else if (addr == CHIMERA_REG_READ_MODE) {
+        m_card->m_pollMode.store(1, std::memory_order_relaxed);
+    } else if (addr == CHIMERA_REG_BATCH) {
+        uint32_t threshold = std::min<uint32_t>(bytes[0], MAX_BATCH_THRESHOLD);
+        m_card->m_batchThreshold.store(threshold, std::memory_order_relaxed);
+    } else if (addr == CHIMERA_REG_STOP) {
+        m_card->m_stopped.store(1, std::memory_order_release);
+    } else {
+        DPRINTF(FPGAEngine, "emulated card ignores write to %#x\n", addr);
+    }
+    return size;
+}
+
+bool EmulatedTransport::waitForResult()
+{
+    while (m_card->m_head.load(std::memory_order_acquire) == m_card->m_tail.load(std::memory_order_relaxed)) {
+        if (m_card->m_pollMode.load(std::memory_order_relaxed) || m_card->m_stopped.load(std::memory_order_acquire)) {
+            return false;
+        }
+        sched_yield();
+    }
+    return true;
+}
+
+int64_t EmulatedTransport::read(uint64_t addr, uint64_t size, void* msg, int channel)
+{
+    assert(channel < m_channelNum);
+    std::lock_guard<std::mutex> lock(m_readMTX);
+
+    uint8_t* bytes = static_cast<uint8_t*>(msg);
+    std::memset(bytes, 0, size);
+
+    if (addr == CHIMERA_REG_CAPS) {
+        ChimeraCaps caps;
+        ipCaps(caps);
+        std::memcpy(bytes, &caps, std::min<uint64_t>(size, sizeof(ChimeraCaps)));
+        return size;
+    }
+
+    if (size < 2 || !waitForResult()) { return size; }
+
+    uint64_t tail      = m_card->m_tail.load(std::memory_order_relaxed);
+    uint64_t available = m_card->m_head.load(std::memory_order_acquire) - tail;
+    uint64_t capacity  = (size - 2) / sizeof(PCIeResult);
+    uint64_t batch     = std::min<uint64_t>(available, m_card->m_batchThreshold.load(std::memory_order_relaxed));
+    batch              = std::min(batch, capacity);
+
+    for (uint64_t i = 0; i < batch; ++i) {
+        std::memcpy(bytes + 2 + i * sizeof(PCIeResult), &(m_card->m_results[(tail + i) % EMULATED_OBUFFER_DEPTH]),
+                    sizeof(PCIeResult));
+    }
+    m_card->m_tail.store(tail + batch, std::memory_order_release);
+
+    if (batch > 0) {
+        bytes[0] = 0x1;
+        bytes[1] = batch;
+    }
+    return size;
+}
+
+} // namespace fpga
+} // namespace gem5
@@ -0,0 +1,117 @@
+#ifndef __FPGA_CHIMERA_EMULATED_TRANSPORT_HH__
+#define __FPGA_CHIMERA_EMULATED_TRANSPORT_HH__
+
+#include <atomic>
+#include <mutex>
+
+#include "fpga/chimera/common.hh"
+#include "fpga/chimera/transport.hh"
+
+namespace gem5
+{
+namespace fpga
+{
+
+#define EMULATED_OBUFFER_DEPTH   4096
+#define EMULATED_IBUFFER_DEPTH   1024
+#define EMULATED_CLOCK_PERIOD_NS 4
+#define EMULATED_OUTPUT_RATIO    16
+
+/**
+ * Card state shared between the host side and the emulated endpoint. It
+ * mirrors what axi_wrapper.sv keeps in registers and in the output buffer,
+ * so it can also be placed in a named shared-memory object and served by
+ * a process outside gem5.
+ */
+struct EmulatedCardState {
+    std::atomic<uint64_t> m_head;
+    std::atomic<uint64_t> m_tail;
+    std::atomic<uint32_t> m_batchThreshold;
+    std::atomic<uint32_t> m_pollMode;
+    std::atomic<uint32_t> m_stopped;
+    std::atomic<uint64_t> m_overflow;
+    std::atomic<uint64_t> m_consumed;
+    PCIeResult            m_results[EMULATED_OBUFFER_DEPTH];
+};
+
+/**
+ * In-process emulation of the card behind the XDMA endpoint. Requests
+ * written to the 0x0 window are decoded like W_DECODE does in hardware,
+ * and reads of any address return a PCIeRespPkt built from the output
+ * ring, so both the poll path and CDMA readback work unchanged.
+ *
+ * The default IP is a loopback model: tasks that need a response are
+ * echoed back, data-plane beats are XOR-folded into one result per
+ * EMULATED_OUTPUT_RATIO result-sized inputs (a stand-in for a compressing
+ * stream accelerator), and a sequence stop yields a finish result.
+ * Subclasses replace the ip*() hooks to put a different model behind the
+ * same register map. With output off, the loopback IP only answers tasks
+ * that need a response: IP output shares the output ring with responses,
+ * as on the card, so traffic generators mixing both turn it off.
+ *
+ * The capability block reports the output ring and an input buffer of
+ * EMULATED_IBUFFER_DEPTH slots, which the IP drains as soon as a task or
+ * data beat is written.
+ *
+ * All channels lead to the same card; like the AXI slave of the wrapper,
+ * it takes one write and one read at a time. New results are signalled on
+ * an eventfd, standing in for the card's user interrupt; it is only
+ * written while a reader is waiting on it.
+ */
+class EmulatedTransport : public Transport
+{
+  private:
+    std::string        m_shmName;
+    EmulatedCardState* m_card;
+    uint64_t           m_startTime;
+    bool               m_output;
+
+    uint8_t  m_fold[RESULT_DATA_SIZE];
+    uint64_t m_foldBytes;
+
+    std::mutex m_writeMTX;
+    std::mutex m_readMTX;
+
+    int              m_eventFd;
+    std::atomic<int> m_eventWaiters;
+
+    void decodeRequest(const uint8_t* pkt, uint64_t size);
+    bool waitForResult();
+
+  protected:
+    uint64_t counter();
+    void     pushResult(const PCIeResult& result);
+    void     pushData(const void* data, uint64_t size);
+    void     pushFinish();
+
+    virtual void ipReset();
+    virtual void ipCaps(ChimeraCaps& caps);
+    virtual void ipTask(const PCIeCtrlTask& task);
+    virtual void ipData(uint64_t addr, const uint8_t* beat);
+
+  public:
+    EmulatedTransport(const std::string& shm_name, int channel_num = 1, bool output = true);
+    ~EmulatedTransport();
+
+    void    open() override;
+    void    close() override;
+    int64_t write(uint64_t addr, uint64_t size, const void* msg, int channel) override;
+    int64_t read(uint64_t addr, uint64_t size, void* msg, int channel) override;
+
+    bool hasEvents() const override
+    {
+        return m_eventFd >= 0;
+    }
+
+    bool waitEvent(int channel, uint64_t timeout_ns) override;
+
+    std::string name() const override
+    {
+        return "emulated";
+    }
+};
+
+} // namespace fpga
+} // namespace gem5
+
+#endif
@@ -1,98 +1,107 @@
 #include "base/logging.hh"
 #include "fpga/chimera/fpga_engine.hh"
+#include "fpga/chimera/common.hh"
 
 #include <math.h>
-#include <iostream>
 
 namespace gem5
 {
 namespace fpga
 {
 
-FPGAEngine::FPGAEngine()
+FPGAEngine::FPGAEngine(Transport* transport) : m_transport(transport)
 {
-    const char* wstr    = "/dev/xdma0_h2c_0";
-    m_writeEngineDevice = open(wstr, O_RDWR);
-    if (m_writeEngineDevice < 0) {
-        std::cout << m_writeEngineDevice << std::endl;
-        panic("*** ERROR: failed to open device /dev/xdma0_h2c_0\n");
-    } else {
-        DPRINTF(FPGAEngine, "SUCCESS: open write engine device\n");
-    }
-
-    const char* rstr   = "/dev/xdma0_c2h_0";
-    m_readEngineDevice = open(rstr, O_RDWR);
-    if (m_readEngineDevice < 0) {
-        panic("*** ERROR: failed to open device /dev/xdma0_c2h_0\n");
-    } else {
-        DPRINTF(FPGAEngine, "SUCCESS: open read engine device\n");
-    }
+    m_transport->open();
+    DPRINTF(FPGAEngine, "SUCCESS: open %s transport\n", m_transport->name());
 }
 
 FPGAEngine::~FPGAEngine()
 {
+    m_transport->close();
+    delete m_transport;
 }
 
-int FPGAEngine::dev_write(uint64_t addr, uint64_t size, void* msg)
+int FPGAEngine::dev_write(uint64_t addr, uint64_t size, void* msg, int channel)
 {
-    if (addr != lseek(m_writeEngineDevice, addr, SEEK_SET)) { panic("*** ERROR: failed to set address of /dev/xdma0_h2c_0\n"); }
     long nanosecond = get_system_time_nanosecond();
-    if (size != write(m_writeEngineDevice, (void*)msg, size)) {
-        panic("*** ERROR: failed to set size of /dev/xdma0_h2c_0\n");
+    if ((int64_t)size != m_transport->write(addr, size, msg, channel)) {
+        panic("*** ERROR: failed to write %d bytes to %#x through %s transport (channel %d)\n", size, addr,
+              m_transport->name(), channel);
     } else {
-        DPRINTF(FPGAEngine, "SUCCESS: finish once fpga write, address: %#x, size: %d\n", addr, size);
+        DPRINTF(FPGAEngine, "SUCCESS: finish once fpga write, address: %#x, size: %d, channel: %d\n", addr, size,
+                channel);
     }
     nanosecond = get_system_time_nanosecond() - nanosecond;
     DPRINTF(FPGAEngine, "pcie write time: %lu\n", nanosecond);
     return 0;
 }
 
-int FPGAEngine::dev_read(uint64_t addr, uint64_t size, void* msg)
+int FPGAEngine::dev_read(uint64_t addr, uint64_t size, void* msg, int channel)
 {
-    if (addr != lseek(m_readEngineDevice, addr, SEEK_SET)) { panic("*** ERROR: failed to set address of /dev/xdma0_c2h_0\n"); }
     long nanosecond = get_system_time_nanosecond();
-    if (size != read(m_readEngineDevice, (void*)msg, size)) {
-        panic("*** ERROR: failed to set size of /dev/xdma0_c2h_0\n");
+    if ((int64_t)size != m_transport->read(addr, size, msg, channel)) {
+        panic("*** ERROR: failed to read %d bytes from %#x through %s transport (channel %d)\n", size, addr,
+              m_transport->name(), channel);
     } else {
-        DPRINTF(FPGAEngine, "SUCCESS: finish once fpga read, address: %#x, size: %d\n", addr, size);
+        DPRINTF(FPGAEngine, "SUCCESS: finish once fpga read, address: %#x, size: %d, channel: %d\n", addr, size,
+                channel);
     }
     nanosecond = get_system_time_nanosecond() - nanosecond;
     DPRINTF(FPGAEngine, "pcie read time: %lu\n", nanosecond);
     return 0;
 }
 
+void FPGAEngine::dev_write_async(uint64_t addr, uint64_t size, const void* msg, int channel, uint64_t tag)
+{
+    m_transport->submitWrite(addr, size, msg, channel, tag);
+    DPRINTF(FPGAEngine, "SUCCESS: queue fpga write %lu, address: %#x, size: %d, channel: %d\n", tag, addr, size,
+            channel);
+}
+
+void FPGAEngine::dev_writev_async(uint64_t addr, const iovec* iov, int iovcnt, int channel, uint64_t tag)
+{
+    m_transport->submitWritev(addr, iov, iovcnt, channel, tag);
+    DPRINTF(FPGAEngine, "SUCCESS: queue fpga write %lu, address: %#x, %d buffers, channel: %d\n", tag, addr, iovcnt,
+            channel);
+}
+
+void FPGAEngine::dev_flush(int channel)
+{
+    m_transport->flush(channel);
+}
+
+int FPGAEngine::dev_reap(int channel, std::vector<DMACompletion>& done, unsigned min_complete)
+{
+    int num = m_transport->reap(channel, done, min_complete);
+    if (num > 0) { DPRINTF(FPGAEngine, "SUCCESS: reap %d fpga writes, channel: %d\n", num, channel); }
+    return num;
+}
+
 void FPGAEngine::dev_init()
 {
-    void* msg = static_cast<void*>(std::malloc(32));
-    dev_write(0x1000, 32, msg);
+    void* msg = static_cast<void*>(std::calloc(1, CHIMERA_REG_MSG_SIZE));
+    dev_write(CHIMERA_REG_RESET, CHIMERA_REG_MSG_SIZE, msg);
     free(msg);
 }
 
 void FPGAEngine::config_read_mode_poll()
 {
-    void* msg = static_cast<void*>(std::malloc(32));
-    dev_write(0x1008, 32, msg);
+    void* msg = static_cast<void*>(std::calloc(1, CHIMERA_REG_MSG_SIZE));
+    dev_write(CHIMERA_REG_READ_MODE, CHIMERA_REG_MSG_SIZE, msg);
     free(msg);
 }
 
-void FPGAEngine::dev_stop()
+bool FPGAEngine::dev_caps(ChimeraCaps& caps, int channel)
 {
-    void* msg = static_cast<void*>(std::malloc(32));
-    dev_write(0x2000, 32, msg);
-    free(msg);
+    dev_read(CHIMERA_REG_CAPS, sizeof(ChimeraCaps), &caps, channel);
+    return caps.m_magic == CHIMERA_CAPS_MAGIC;
 }
 
-void FPGAEngine::printPCIeTime()
+void FPGAEngine::dev_stop()
 {
-    for(int i = 0; i < m_pcie_read_time.size(); ++i) {
-        std::cout << "pcie_read_time: " << m_pcie_read_time.front() << std::endl;
-        m_pcie_read_time.pop_front();
-    }
-
-    for (int j = 0; j < m_pcie_write_time.size(); ++j) {
-        std::cout << "pcie_write_time: " << m_pcie_write_time.front() << std::endl;
-        m_pcie_write_time.pop_front();
-    }
+    void* msg = static_cast<void*>(std::calloc(1, CHIMERA_REG_MSG_SIZE));
+    dev_write(CHIMERA_REG_STOP, CHIMERA_REG_MSG_SIZE, msg);
+    free(msg);
 }
 
 } // namespace fpga
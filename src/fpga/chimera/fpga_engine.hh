@@ -12,6 +12,8 @@
 #include "base/trace.hh"
 #include "debug/FPGAEngine.hh"
 
+#include "fpga/chimera/common.hh"
+#include "fpga/chimera/transport.hh"
 #include "fpga/chimera/utils.hh"
 
 namespace gem5
@@ -22,23 +24,34 @@ namespace fpga
 class FPGAEngine
 {
   private:
-    int m_writeEngineDevice;
-    int m_readEngineDevice;
-
-    std::list<uint64_t> m_pcie_write_time;
-    std::list<uint64_t> m_pcie_read_time;
+    Transport* m_transport;
 
   public:
-    FPGAEngine();
+    FPGAEngine(Transport* transport);
     ~FPGAEngine();
 
+    Transport* getTransport()
+    {
+        return m_transport;
+    }
+
     void dev_init();
     void dev_stop();
-    int  dev_write(uint64_t addr, uint64_t size, void* msg);
-    int  dev_read(uint64_t addr, uint64_t size, void* msg);
+    int  dev_write(uint64_t addr, uint64_t size, void* msg, int channel = 0);
+    int  dev_read(uint64_t addr, uint64_t size, void* msg, int channel = 0);
+
+    // queue a write that finishes later, see Transport::submitWrite()
+    void dev_write_async(uint64_t addr, uint64_t size, const void* msg, int channel, uint64_t tag);
+    // the same for a scatter-gather list, see Transport::submitWritev()
+    void dev_writev_async(uint64_t addr, const iovec* iov, int iovcnt, int channel, uint64_t tag);
+    // pass queued writes on to the card, see Transport::flush()
+    void dev_flush(int channel);
+    int  dev_reap(int channel, std::vector<DMACompletion>& done, unsigned min_complete);
 
     void config_read_mode_poll();
-    void printPCIeTime();
+
+    // reads the capability block of the card; false if it has none
+    bool dev_caps(ChimeraCaps& caps, int channel = 0);
 };
 
 } // namespace fpga
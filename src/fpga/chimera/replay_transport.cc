@@ -0,0 +1,581 @@
+#include "fpga/chimera/replay_transport.hh"
+
+#include <fcntl.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+
+#include "base/logging.hh"
+#include "base/trace.hh"
+#include "debug/FPGAEngine.hh"
+
+namespace gem5
+{
+namespace fpga
+{
+
+uint64_t replaySessionHash(const std::string& session, const std::string& transport)
+{
+    // FNV-1a
+    uint64_t    hash = 0xcbf29ce484222325ULL;
+    std::string key  = session + '\0' + transport;
+    for (unsigned char c : key) {
+        hash ^= c;
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+std::string replayLogPath(const std::string& dir, const std::string& session, const std::string& transport)
+{
+    char file[32];
+    std::snprintf(file, sizeof(file), "chimera-%016lx.rec", (unsigned long)replaySessionHash(session, transport));
+    return (dir.empty() ? std::string(".") : dir) + "/" + file;
+}
+
+RecordingTransport::RecordingTransport(Transport* live, const std::string& path, uint64_t session) :
+    Transport(live->channelNum()), m_live(live), m_path(path), m_session(session), m_file(nullptr), m_records(0),
+    m_failed(false)
+{
+    std::memset(&m_caps, 0, sizeof(m_caps));
+}
+
+RecordingTransport::~RecordingTransport()
+{
+    close();
+    delete m_live;
+}
+
+void RecordingTransport::open()
+{
+    m_live->open();
+
+    m_file = fopen(m_path.c_str(), "wb");
+    if (!m_file) { panic("*** ERROR: failed to create response log %s\n", m_path); }
+
+    // rewritten with the record count on close; a log cut short by a crash
+    // holds no records and is simply replayed live
+    ReplayLogHeader header;
+    std::memcpy(header.m_magic, REPLAY_LOG_MAGIC, sizeof(header.m_magic));
+    header.m_session = m_session;
+    header.m_records = 0;
+    std::memset(&header.m_caps, 0, sizeof(header.m_caps));
+    if (fwrite(&header, sizeof(header), 1, m_file) != 1 || fflush(m_file) != 0) {
+        panic("*** ERROR: failed to write response log %s: %s\n", m_path, std::strerror(errno));
+    }
+    m_records = 0;
+    m_failed  = false;
+    DPRINTF(FPGAEngine, "SUCCESS: record responses of the %s transport to %s\n", m_live->name(), m_path);
+}
+
+void RecordingTransport::close()
+{
+    if (m_file) {
+        ReplayLogHeader header;
+        std::memcpy(header.m_magic, REPLAY_LOG_MAGIC, sizeof(header.m_magic));
+        header.m_session = m_session;
+        header.m_records = m_failed ? 0 : m_records;
+        header.m_caps    = m_caps;
+        // seeking writes out what is buffered, so a late failure shows here
+        bool failed = fseek(m_file, 0, SEEK_SET) != 0 || fwrite(&header, sizeof(header), 1, m_file) != 1;
+        failed      = fclose(m_file) != 0 || failed;
+        m_file      = nullptr;
+        if (failed && !m_failed) {
+            warn("chimera: failed to write response log %s: %s\n", m_path, std::strerror(errno));
+        } else if (!m_failed) {
+            inform("chimera: %lu records in response log %s\n", m_records, m_path);
+        }
+    }
+    m_live->close();
+}
+
+void RecordingTransport::logRecord(const ReplayRecord& record)
+{
+    if (m_failed) { return; }
+    if (fwrite(&record, sizeof(record), 1, m_file) != 1) {
+        warn("chimera: failed to write response log %s, it will hold no records: %s\n", m_path,
+             std::strerror(errno));
+        m_failed = true;
+        return;
+    }
+    m_records++;
+}
+
+void RecordingTransport::logWrite(uint64_t addr, uint64_t size, const void* msg)
+{
+    const uint8_t* bytes = static_cast<const uint8_t*>(msg);
+    ReplayRecord   record;
+    std::memset(&record, 0, sizeof(record));
+
+    std::lock_guard<std::mutex> lock(m_logMTX);
+    if (addr == CHIMERA_REQ_WINDOW) {
+        record.m_kind = ReplayRecord::TASK;
+        for (int i = 0; i < bytes[1]; ++i) {
+            PCIeCtrlTask task;
+            std::memcpy(&task, bytes + 2 + i * sizeof(PCIeCtrlTask), sizeof(PCIeCtrlTask));
+            record.m_basic   = task.m_basic;
+            record.m_tableID = task.m_tableID;
+            std::memcpy(record.m_content, task.m_content, TASK_CTRL_DATA_SIZE);
+            logRecord(record);
+        }
+    } else if (addr >= CHIMERA_DATA_PLANE_BASE) {
+        // the card takes the data plane in 8-byte beats
+        record.m_kind = ReplayRecord::DATA;
+        for (uint64_t offset = 0; offset + 8 <= size; offset += RESULT_DATA_SIZE) {
+            record.m_word = addr + offset;
+            record.m_size = std::min<uint64_t>(RESULT_DATA_SIZE, (size & ~7ULL) - offset);
+            std::memcpy(record.m_content, bytes + offset, record.m_size);
+            logRecord(record);
+        }
+    }
+}
+
+void RecordingTransport::logRead(const void* msg, uint64_t size)
+{
+    const uint8_t* bytes = static_cast<const uint8_t*>(msg);
+    if (size < 2 || !(bytes[0] & 0x1)) { return; }
+
+    ReplayRecord record;
+    std::memset(&record, 0, sizeof(record));
+    record.m_kind = ReplayRecord::RESULT;
+
+    std::lock_guard<std::mutex> lock(m_logMTX);
+    for (int i = 0; i < bytes[1]; ++i) {
+        PCIeResult result;
+        std::memcpy(&result, bytes + 2 + i * sizeof(PCIeResult), sizeof(PCIeResult));
+        record.m_basic   = result.m_valid;
+        record.m_tableID = result.m_tableID;
+        record.m_word    = result.m_executedTime;
+        std::memcpy(record.m_content, result.m_content, RESULT_DATA_SIZE);
+        logRecord(record);
+    }
+}
+
+int64_t RecordingTransport::write(uint64_t addr, uint64_t size, const void* msg, int channel)
+{
+    // logged before the card sees it, so no result can be logged ahead of
+    // the inputs it depends on
+    logWrite(addr, size, msg);
+    return m_live->write(addr, size, msg, channel);
+}
+
+int64_t RecordingTransport::read(uint64_t addr, uint64_t size, void* msg, int channel)
+{
+    int64_t ret = m_live->read(addr, size, msg, channel);
+    if (ret != (int64_t)size) { return ret; }
+
+    if (addr == CHIMERA_REG_CAPS) {
+        // the drained count is not part of what the card was built with
+        std::lock_guard<std::mutex> lock(m_logMTX);
+        if (m_caps.m_magic != CHIMERA_CAPS_MAGIC && size >= sizeof(ChimeraCaps)) {
+            std::memcpy(&m_caps, msg, sizeof(ChimeraCaps));
+            m_caps.m_consumed = 0;
+        }
+    } else {
+        logRead(msg, size);
+    }
+    return ret;
+}
+
+void RecordingTransport::submitWrite(uint64_t addr, uint64_t size, const void* msg, int channel, uint64_t tag)
+{
+    logWrite(addr, size, msg);
+    m_live->submitWrite(addr, size, msg, channel, tag);
+}
+
+// logged buffer by buffer, as a replay without the scatter-gather path
+// writes them
+void RecordingTransport::logWritev(uint64_t addr, const iovec* iov, int iovcnt)
+{
+    for (int i = 0; i < iovcnt; addr += iov[i].iov_len, ++i) { logWrite(addr, iov[i].iov_len, iov[i].iov_base); }
+}
+
+int64_t RecordingTransport::writev(uint64_t addr, const iovec* iov, int iovcnt, int channel)
+{
+    logWritev(addr, iov, iovcnt);
+    return m_live->writev(addr, iov, iovcnt, channel);
+}
+
+void RecordingTransport::submitWritev(uint64_t addr, const iovec* iov, int iovcnt, int channel, uint64_t tag)
+{
+    logWritev(addr, iov, iovcnt);
+    m_live->submitWritev(addr, iov, iovcnt, channel, tag);
+}
+
+void RecordingTransport::flush(int channel)
+{
+    m_live->flush(channel);
+}
+
+int RecordingTransport::reap(int channel, std::vector<DMACompletion>& done, unsigned min_complete)
+{
+    return m_live->reap(channel, done, min_complete);
+}
+
+void RecordingTransport::registerBuffer(void* base, uint64_t size)
+{
+    m_live->registerBuffer(base, size);
+}
+
+ReplayTransport::ReplayTransport(Transport* live, const std::string& path, uint64_t session, int channel_num) :
+    EmulatedTransport("", channel_num), m_live(live), m_path(path), m_session(session), m_log(nullptr), m_logSize(0),
+    m_records(nullptr), m_next(0), m_offset(0), m_diverged(false), m_isLive(false), m_consumed(0), m_discard(0),
+    m_liveCredits(false), m_liveIssued(0), m_liveConsumed(0), m_liveBatch(1), m_holding(false)
+{
+    for (int i = 0; i < 128; ++i) { m_tableMap[i] = i; }
+}
+
+ReplayTransport::~ReplayTransport()
+{
+    close();
+    delete m_live;
+}
+
+bool ReplayTransport::mapLog()
+{
+    int fd = ::open(m_path.c_str(), O_RDONLY);
+    if (fd < 0) { return false; }
+
+    struct stat st;
+    void*       region = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && (uint64_t)st.st_size >= sizeof(ReplayLogHeader)) {
+        region = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    ::close(fd);
+    if (region == MAP_FAILED) { return false; }
+
+    m_log     = static_cast<const ReplayLogHeader*>(region);
+    m_logSize = st.st_size;
+    m_records = reinterpret_cast<const ReplayRecord*>(m_log + 1);
+    if (std::memcmp(m_log->m_magic, REPLAY_LOG_MAGIC, sizeof(m_log->m_magic)) != 0
+        || m_log->m_session != m_session
+        || sizeof(ReplayLogHeader) + m_log->m_records * sizeof(ReplayRecord) > m_logSize) {
+        munmap(const_cast<ReplayLogHeader*>(m_log), m_logSize);
+        m_log = nullptr;
+        return false;
+    }
+    return true;
+}
+
+void ReplayTransport::open()
+{
+    EmulatedTransport::open();
+
+    if (!mapLog()) {
+        warn("chimera: no usable response log at %s, running on the %s transport\n", m_path, m_live->name());
+        m_live->open();
+        m_isLive.store(true, std::memory_order_release);
+        return;
+    }
+    DPRINTF(FPGAEngine, "SUCCESS: replay %lu records from %s\n", m_log->m_records, m_path);
+    releaseResults();
+}
+
+void ReplayTransport::close()
+{
+    EmulatedTransport::close();
+    if (m_log) {
+        inform("chimera: replayed %lu of %lu records from %s%s\n", m_next, m_log->m_records, m_path,
+               m_diverged ? " before going live" : "");
+        munmap(const_cast<ReplayLogHeader*>(m_log), m_logSize);
+        m_log = nullptr;
+    }
+    if (m_isLive.load(std::memory_order_acquire)) { m_live->close(); }
+}
+
+void ReplayTransport::releaseResults()
+{
+    while (m_next < m_log->m_records && m_records[m_next].m_kind == ReplayRecord::RESULT) {
+        const ReplayRecord& record = m_records[m_next++];
+
+        PCIeResult result;
+        result.m_valid        = record.m_basic;
+        result.m_tableID      = record.m_tableID >= 0 ? m_tableMap[record.m_tableID] : record.m_tableID;
+        result.m_executedTime = record.m_word;
+        std::memcpy(result.m_content, record.m_content, RESULT_DATA_SIZE);
+        pushResult(result);
+    }
+}
+
+void ReplayTransport::ipCaps(ChimeraCaps& caps)
+{
+    // the card of the log, so batches are sized as they were recorded; its
+    // input buffer never fills since the log takes every input at once
+    EmulatedTransport::ipCaps(caps);
+    uint64_t consumed = caps.m_consumed;
+    caps              = m_log->m_caps;
+    caps.m_consumed   = consumed;
+}
+
+void ReplayTransport::diverge(const char* what)
+{
+    m_diverged = true;
+    warn("chimera: %s differs from response log %s at record %lu, going on with the %s transport\n", what, m_path,
+         m_next, m_live->name());
+}
+
+void ReplayTransport::ipTask(const PCIeCtrlTask& task)
+{
+    if (m_diverged) { return; }
+
+    const ReplayRecord* record = m_next < m_log->m_records ? &m_records[m_next] : nullptr;
+    if (!record || record->m_kind != ReplayRecord::TASK || record->m_basic != task.m_basic
+        || std::memcmp(record->m_content, task.m_content, TASK_CTRL_DATA_SIZE) != 0) {
+        diverge("task");
+        return;
+    }
+    if (record->m_tableID >= 0 && task.m_tableID >= 0) { m_tableMap[record->m_tableID] = task.m_tableID; }
+
+    m_next++;
+    releaseResults();
+}
+
+void ReplayTransport::ipData(uint64_t addr, const uint8_t* beat)
+{
+    if (m_diverged) { return; }
+
+    const ReplayRecord* record = m_next < m_log->m_records ? &m_records[m_next] : nullptr;
+    if (!record || record->m_kind != ReplayRecord::DATA || record->m_word + m_offset != addr
+        || std::memcmp(record->m_content + m_offset, beat, 8) != 0) {
+        diverge("data");
+        return;
+    }
+
+    m_offset += 8;
+    if (m_offset >= record->m_size) {
+        m_offset = 0;
+        m_next++;
+        releaseResults();
+    }
+}
+
+/**
+ * Write to the live card once its input buffer has room for slots more
+ * inputs. The drained count is only read again when the last one read
+ * leaves no room.
+ */
+void ReplayTransport::sendLive(uint64_t addr, uint64_t size, const void* msg, uint64_t slots, int channel)
+{
+    while (m_liveCredits && m_liveIssued + slots - m_liveConsumed > m_log->m_caps.m_ibufferDepth) {
+        ChimeraCaps caps;
+        m_live->read(CHIMERA_REG_CAPS, sizeof(caps), &caps, channel);
+        if (caps.m_consumed > m_liveConsumed) {
+            m_liveConsumed = caps.m_consumed;
+        } else {
+            drainLive(channel);
+        }
+    }
+
+    if (m_live->write(addr, size, msg, channel) != (int64_t)size) {
+        panic("*** ERROR: failed to bring the %s transport up to date after diverging from %s\n", m_live->name(),
+              m_path);
+    }
+    m_liveIssued += slots;
+}
+
+// take what results the live card has; those the simulation read from the
+// log are dropped, the rest are held for it
+void ReplayTransport::drainLive(int channel)
+{
+    PCIeRespPkt pkt(m_liveBatch);
+    if (m_live->read(CHIMERA_REQ_WINDOW, pkt.m_size, &pkt, channel) != (int64_t)pkt.m_size || !(pkt.m_valid & 0x1)) {
+        sched_yield();
+        return;
+    }
+
+    uint64_t drop = std::min<uint64_t>(m_discard, pkt.m_batch);
+    m_discard -= drop;
+    for (uint64_t i = drop; i < pkt.m_batch; ++i) { m_held.push_back(pkt.m_results[i]); }
+}
+
+// send the inputs of the log from one position to another again, tasks
+// gathered into request packets and contiguous data into one write, each
+// no larger than the input buffer of the card
+void ReplayTransport::resend(LogPosition from, LogPosition to, int channel)
+{
+    uint64_t limit    = m_liveCredits ? m_log->m_caps.m_ibufferDepth : UINT64_MAX;
+    int      maxBatch = std::min<uint64_t>(MAX_BATCH_THRESHOLD, limit);
+    if (m_liveCredits && m_log->m_caps.m_maxBatch > 0) { maxBatch = std::min<int>(maxBatch, m_log->m_caps.m_maxBatch); }
+
+    std::vector<uint8_t> tasks;
+    std::vector<uint8_t> data;
+    uint64_t             dataAddr = 0;
+
+    auto flush = [&] {
+        if (!tasks.empty()) {
+            sendLive(CHIMERA_REQ_WINDOW, tasks.size(), tasks.data(), tasks[1], channel);
+            tasks.clear();
+        }
+        if (!data.empty()) {
+            sendLive(dataAddr, data.size(), data.data(), data.size() / CHIMERA_DATA_BEAT_SIZE, channel);
+            data.clear();
+        }
+    };
+
+    // a data record the diverging write had started on is cut at to
+    uint64_t end = std::min(m_log->m_records, to.m_offset > 0 ? to.m_record + 1 : to.m_record);
+    for (uint64_t i = from.m_record; i < end; ++i) {
+        const ReplayRecord& record = m_records[i];
+        if (record.m_kind == ReplayRecord::TASK) {
+            if (!data.empty() || (!tasks.empty() && tasks[1] == maxBatch)) { flush(); }
+            if (tasks.empty()) { tasks = {0x1, 0x0}; }
+
+            PCIeCtrlTask task;
+            std::memset(&task, 0, sizeof(task));
+            task.m_basic   = record.m_basic;
+            task.m_tableID = record.m_tableID >= 0 ? m_tableMap[record.m_tableID] : record.m_tableID;
+            std::memcpy(task.m_content, record.m_content, TASK_CTRL_DATA_SIZE);
+            const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&task);
+            tasks.insert(tasks.end(), bytes, bytes + sizeof(task));
+            tasks[1]++;
+        } else if (record.m_kind == ReplayRecord::DATA) {
+            uint64_t first = i == from.m_record ? from.m_offset : 0;
+            uint64_t last  = i == to.m_record ? to.m_offset : record.m_size;
+            if (!tasks.empty() || (!data.empty() && dataAddr + data.size() != record.m_word + first)
+                || (data.size() + last - first) / CHIMERA_DATA_BEAT_SIZE > limit) {
+                flush();
+            }
+            if (data.empty()) { dataAddr = record.m_word + first; }
+            data.insert(data.end(), record.m_content + first, record.m_content + last);
+        }
+    }
+    flush();
+}
+
+/**
+ * Bring the live card to where the log left off: the inputs of the log up
+ * to end, where the write that diverged started, with the register writes
+ * in between, then that write. A reset clears what the card has drained.
+ */
+void ReplayTransport::goLive(LogPosition end, uint64_t addr, uint64_t size, const void* msg, int channel)
+{
+    // a reader waiting for a replayed result gives up; the read side of the
+    // live card is ours until it is done
+    EmulatedTransport::write(CHIMERA_REG_STOP, 0, nullptr, 0);
+    std::lock_guard<std::mutex> lock(m_replayMTX);
+
+    // the card returns every result of the run; those already read are dropped
+    m_discard = m_consumed;
+
+    m_live->open();
+    m_liveCredits = m_log->m_caps.m_magic == CHIMERA_CAPS_MAGIC;
+    if (m_liveCredits) {
+        ChimeraCaps caps;
+        m_live->read(CHIMERA_REG_CAPS, sizeof(caps), &caps, channel);
+        m_liveIssued   = caps.m_consumed;
+        m_liveConsumed = caps.m_consumed;
+    }
+
+    LogPosition at = {0, 0};
+    for (const RegisterWrite& reg : m_registers) {
+        resend(at, reg.m_position, channel);
+        at = reg.m_position;
+        sendLive(reg.m_addr, reg.m_bytes.size(), reg.m_bytes.data(), 0, channel);
+        if (reg.m_addr == CHIMERA_REG_RESET) {
+            m_liveIssued   = 0;
+            m_liveConsumed = 0;
+        } else if (reg.m_addr == CHIMERA_REG_BATCH && !reg.m_bytes.empty()) {
+            m_liveBatch = std::max<int>(std::min<int>(reg.m_bytes[0], MAX_BATCH_THRESHOLD), 1);
+        }
+    }
+    resend(at, end, channel);
+    uint64_t slots = 0;
+    if (addr == CHIMERA_REQ_WINDOW) {
+        slots = static_cast<const uint8_t*>(msg)[1];
+    } else if (addr >= CHIMERA_DATA_PLANE_BASE) {
+        slots = size / CHIMERA_DATA_BEAT_SIZE;
+    }
+    sendLive(addr, size, msg, slots, channel);
+    DPRINTF(FPGAEngine, "SUCCESS: sent %lu records and %lu register writes to the %s transport again\n", end.m_record,
+            m_registers.size(), m_live->name());
+    m_registers.clear();
+    m_registers.shrink_to_fit();
+
+    m_holding.store(!m_held.empty(), std::memory_order_relaxed);
+    m_isLive.store(true, std::memory_order_release);
+}
+
+int64_t ReplayTransport::write(uint64_t addr, uint64_t size, const void* msg, int channel)
+{
+    if (!m_isLive.load(std::memory_order_acquire)) {
+        std::lock_guard<std::mutex> lock(m_inputMTX);
+        if (!m_isLive.load(std::memory_order_relaxed)) {
+            LogPosition start = {m_next, m_offset};
+            if (addr != CHIMERA_REQ_WINDOW && addr < CHIMERA_DATA_PLANE_BASE) {
+                const uint8_t* bytes = static_cast<const uint8_t*>(msg);
+                m_registers.push_back({start, addr, std::vector<uint8_t>(bytes, bytes + size)});
+            }
+
+            int64_t ret = EmulatedTransport::write(addr, size, msg, channel);
+            if (m_diverged) { goLive(start, addr, size, msg, channel); }
+            return ret;
+        }
+    }
+    return m_live->write(addr, size, msg, channel);
+}
+
+int64_t ReplayTransport::read(uint64_t addr, uint64_t size, void* msg, int channel)
+{
+    uint8_t* bytes = static_cast<uint8_t*>(msg);
+
+    if (!m_isLive.load(std::memory_order_acquire)) {
+        std::lock_guard<std::mutex> lock(m_replayMTX);
+        if (!m_isLive.load(std::memory_order_relaxed)) {
+            int64_t ret = EmulatedTransport::read(addr, size, msg, channel);
+            if (addr != CHIMERA_REG_CAPS && size >= 2 && (bytes[0] & 0x1)) { m_consumed += bytes[1]; }
+            return ret;
+        }
+    }
+
+    if (m_holding.load(std::memory_order_acquire) && addr == CHIMERA_REQ_WINDOW && size >= 2) {
+        // results read from the card while it was brought up to date
+        std::lock_guard<std::mutex> lock(m_replayMTX);
+        if (!m_held.empty()) {
+            uint64_t batch = std::min<uint64_t>(m_held.size(), (size - 2) / sizeof(PCIeResult));
+            std::memset(bytes, 0, size);
+            for (uint64_t i = 0; i < batch; ++i) {
+                std::memcpy(bytes + 2 + i * sizeof(PCIeResult), &m_held.front(), sizeof(PCIeResult));
+                m_held.pop_front();
+            }
+            bytes[0] = batch > 0 ? 0x1 : 0x0;
+            bytes[1] = batch;
+            m_holding.store(!m_held.empty(), std::memory_order_relaxed);
+            return size;
+        }
+    }
+
+    int64_t ret = m_live->read(addr, size, msg, channel);
+    if (ret == (int64_t)size && addr != CHIMERA_REG_CAPS && size >= 2 && (bytes[0] & 0x1)) {
+        std::lock_guard<std::mutex> lock(m_replayMTX);
+        if (m_discard > 0) {
+            uint64_t batch = bytes[1];
+            uint64_t drop  = std::min(m_discard, batch);
+            std::memmove(bytes + 2, bytes + 2 + drop * sizeof(PCIeResult), (batch - drop) * sizeof(PCIeResult));
+            m_discard -= drop;
+            bytes[1] = batch - drop;
+            if (bytes[1] == 0) { bytes[0] = 0x0; }
+        }
+    }
+    return ret;
+}
+
+void ReplayTransport::registerBuffer(void* base, uint64_t size)
+{
+    m_live->registerBuffer(base, size);
+}
+
+bool ReplayTransport::waitEvent(int channel, uint64_t timeout_ns)
+{
+    if (m_isLive.load(std::memory_order_acquire)) {
+        return m_live->hasEvents() && m_live->waitEvent(channel, timeout_ns);
+    }
+    return EmulatedTransport::waitEvent(channel, timeout_ns);
+}
+
+} // namespace fpga
+} // namespace gem5
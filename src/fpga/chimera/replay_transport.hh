@@ -0,0 +1,216 @@
+#ifndef __FPGA_CHIMERA_REPLAY_TRANSPORT_HH__
+#define __FPGA_CHIMERA_REPLAY_TRANSPORT_HH__
+
+#include <stdio.h>
+
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "fpga/chimera/emulated_transport.hh"
+
+namespace gem5
+{
+namespace fpga
+{
+
+#define REPLAY_LOG_MAGIC "CHIMREC2"
+
+/**
+ * A response log is a header followed by fixed-size records, in the order
+ * the host saw them: the inputs of the card (control tasks and data-plane
+ * bytes) as they were written, and its results as they were read back.
+ * Every result was read after the inputs it depends on were written, so it
+ * can be given back as soon as the inputs before it have been seen again.
+ * The header keeps the capability block of the card the log was recorded
+ * on (no magic if it had none), so a replay sizes its transfers the same.
+ */
+struct ReplayLogHeader {
+    char        m_magic[8];
+    uint64_t    m_session;
+    uint64_t    m_records;
+    ChimeraCaps m_caps;
+};
+
+struct ReplayRecord {
+    enum Kind : uint8_t { TASK, DATA, RESULT };
+
+    uint8_t  m_kind;
+    uint8_t  m_basic;     // task: m_basic; result: m_valid
+    int8_t   m_tableID;
+    uint8_t  m_size;      // data: bytes in m_content
+    uint32_t m_reserved;
+    uint64_t m_word;      // data: address; result: m_executedTime
+    uint8_t  m_content[RESULT_DATA_SIZE];
+};
+
+// the log of one device session: the hash of the session key (bitstream,
+// workload, ...) and of the live transport names the file in dir
+std::string replayLogPath(const std::string& dir, const std::string& session, const std::string& transport);
+uint64_t    replaySessionHash(const std::string& session, const std::string& transport);
+
+/**
+ * Passes every transfer through to the live transport and logs the inputs
+ * and results of the card to a response log. Results are logged from any
+ * read that returns them, so the poll path and CDMA readback are covered
+ * alike; register writes are not logged. If writing the log fails, the
+ * run goes on and the log is closed with no records, so it is replayed
+ * live.
+ */
+class RecordingTransport : public Transport
+{
+  private:
+    Transport*  m_live;
+    std::string m_path;
+    uint64_t    m_session;
+    FILE*       m_file;
+    uint64_t    m_records;
+    bool        m_failed; // a write to the log failed, it keeps no records
+    ChimeraCaps m_caps;
+    std::mutex  m_logMTX;
+
+    void logRecord(const ReplayRecord& record);
+    void logWrite(uint64_t addr, uint64_t size, const void* msg);
+    void logWritev(uint64_t addr, const iovec* iov, int iovcnt);
+    void logRead(const void* msg, uint64_t size);
+
+  public:
+    RecordingTransport(Transport* live, const std::string& path, uint64_t session);
+    ~RecordingTransport();
+
+    void    open() override;
+    void    close() override;
+    int64_t write(uint64_t addr, uint64_t size, const void* msg, int channel) override;
+    int64_t read(uint64_t addr, uint64_t size, void* msg, int channel) override;
+
+    int64_t writev(uint64_t addr, const iovec* iov, int iovcnt, int channel) override;
+
+    void submitWrite(uint64_t addr, uint64_t size, const void* msg, int channel, uint64_t tag) override;
+    void submitWritev(uint64_t addr, const iovec* iov, int iovcnt, int channel, uint64_t tag) override;
+    void flush(int channel) override;
+    int  reap(int channel, std::vector<DMACompletion>& done, unsigned min_complete) override;
+    void registerBuffer(void* base, uint64_t size) override;
+
+    bool hasEvents() const override
+    {
+        return m_live->hasEvents();
+    }
+
+    bool waitEvent(int channel, uint64_t timeout_ns) override
+    {
+        return m_live->waitEvent(channel, timeout_ns);
+    }
+
+    std::string name() const override
+    {
+        return m_live->name();
+    }
+};
+
+/**
+ * Emulated card whose IP is a response log, mapped read-only. Every input
+ * is checked against the next one in the log, ignoring the table ID and
+ * the insert time; the results that follow it are given back, with their
+ * table IDs moved to the entries the tasks hold in this run.
+ *
+ * Once an input differs, or the log runs out, the run goes on with the
+ * live transport: it is opened and handed every input of the run again so
+ * the card reaches the same state. The inputs matched so far are sent from
+ * the log, with the register writes the log does not hold put back where
+ * they fell, and the write that differed follows; each waits for room in
+ * the input buffer of the card, if the log's card had credits. The results
+ * the simulation has already read are dropped from what the card returns.
+ * Inputs are compared in the order they are written, which can change from
+ * run to run with several channels.
+ */
+class ReplayTransport : public EmulatedTransport
+{
+  private:
+    // how far the inputs of the log are matched: up to record m_record,
+    // and m_offset bytes into it
+    struct LogPosition {
+        uint64_t m_record;
+        uint64_t m_offset;
+    };
+
+    struct RegisterWrite {
+        LogPosition          m_position;
+        uint64_t             m_addr;
+        std::vector<uint8_t> m_bytes;
+    };
+
+    Transport*  m_live;
+    std::string m_path;
+    uint64_t    m_session;
+
+    const ReplayLogHeader* m_log;
+    uint64_t               m_logSize;
+    const ReplayRecord*    m_records;
+    uint64_t               m_next;
+    uint64_t               m_offset;
+    int8_t                 m_tableMap[128];
+
+    // the writes while the log is replayed, which the emulated card takes
+    // one at a time anyway; the register writes are few (reset, batch
+    // size, read mode, stop), so keeping them stays cheap
+    std::mutex                 m_inputMTX;
+    std::vector<RegisterWrite> m_registers;
+    bool                       m_diverged;
+    std::atomic<bool>          m_isLive;
+    std::mutex                 m_replayMTX;
+    uint64_t                   m_consumed;
+    uint64_t                   m_discard;
+
+    // input-buffer slots sent to the live card while bringing it up to
+    // date, checked against what it reports drained. Results it returns
+    // meanwhile are read so its output buffer does not hold it up; those
+    // the simulation has not read yet are held for it
+    bool                   m_liveCredits;
+    uint64_t               m_liveIssued;
+    uint64_t               m_liveConsumed;
+    int                    m_liveBatch;
+    std::deque<PCIeResult> m_held;
+    std::atomic<bool>      m_holding;
+
+    bool mapLog();
+    void releaseResults();
+    void diverge(const char* what);
+    void goLive(LogPosition end, uint64_t addr, uint64_t size, const void* msg, int channel);
+    void resend(LogPosition from, LogPosition to, int channel);
+    void sendLive(uint64_t addr, uint64_t size, const void* msg, uint64_t slots, int channel);
+    void drainLive(int channel);
+
+  protected:
+    void ipCaps(ChimeraCaps& caps) override;
+    void ipTask(const PCIeCtrlTask& task) override;
+    void ipData(uint64_t addr, const uint8_t* beat) override;
+
+  public:
+    ReplayTransport(Transport* live, const std::string& path, uint64_t session, int channel_num = 1);
+    ~ReplayTransport();
+
+    void    open() override;
+    void    close() override;
+    int64_t write(uint64_t addr, uint64_t size, const void* msg, int channel) override;
+    int64_t read(uint64_t addr, uint64_t size, void* msg, int channel) override;
+    void    registerBuffer(void* base, uint64_t size) override;
+
+    bool hasEvents() const override
+    {
+        return m_isLive.load(std::memory_order_acquire) ? m_live->hasEvents() : EmulatedTransport::hasEvents();
+    }
+
+    bool waitEvent(int channel, uint64_t timeout_ns) override;
+
+    std::string name() const override
+    {
+        return "replay";
+    }
+};
+
+} // namespace fpga
+} // namespace gem5
+
+#endif
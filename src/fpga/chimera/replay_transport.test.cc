@@ -0,0 +1,209 @@
+#include <gtest/gtest.h>
+
+#include <signal.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+
+#include "base/gtest/cur_tick_fake.hh"
+#include "fpga/chimera/replay_transport.hh"
+
+using namespace gem5::fpga;
+
+// the transports trace, which reads the tick
+gem5::GTestTickHandler tickHandler;
+
+#define RESULT_WINDOW (2 + MAX_BATCH_THRESHOLD * sizeof(PCIeResult))
+
+// the emulated card, counting what it is given
+class CountingTransport : public EmulatedTransport
+{
+  public:
+    int* m_writes;
+
+    CountingTransport(int* writes) : EmulatedTransport(""), m_writes(writes)
+    {
+    }
+
+    int64_t write(uint64_t addr, uint64_t size, const void* msg, int channel) override
+    {
+        (*m_writes)++;
+        return EmulatedTransport::write(addr, size, msg, channel);
+    }
+};
+
+static void writeRegister(Transport& transport, uint64_t addr, uint8_t value)
+{
+    uint8_t msg[CHIMERA_REG_MSG_SIZE] = {value};
+    ASSERT_EQ(transport.write(addr, sizeof(msg), msg, 0), sizeof(msg));
+}
+
+// a request packet of tasks that ask for a response, task i carrying value
+// first + i and table ID i
+static void writeTasks(Transport& transport, int count, uint64_t first)
+{
+    std::vector<uint8_t> pkt(2 + count * sizeof(PCIeCtrlTask), 0);
+    pkt[0] = 0x1;
+    pkt[1] = count;
+    for (int i = 0; i < count; ++i) {
+        PCIeCtrlTask task;
+        std::memset(&task, 0, sizeof(task));
+        task.m_basic   = 0x7;
+        task.m_tableID = i;
+        uint64_t addr  = 0x8;
+        uint64_t value = first + i;
+        std::memcpy(&task.m_content[0], &addr, sizeof(uint64_t));
+        std::memcpy(&task.m_content[8], &value, sizeof(uint64_t));
+        std::memcpy(&pkt[2 + i * sizeof(PCIeCtrlTask)], &task, sizeof(task));
+    }
+    ASSERT_EQ(transport.write(CHIMERA_REQ_WINDOW, pkt.size(), pkt.data(), 0), pkt.size());
+}
+
+// enough data plane for the loopback IP to fold into one result
+static void writeData(Transport& transport, uint8_t fill)
+{
+    std::vector<uint8_t> data(RESULT_DATA_SIZE * EMULATED_OUTPUT_RATIO, fill);
+    ASSERT_EQ(transport.write(CHIMERA_DATA_PLANE_BASE, data.size(), data.data(), 0), data.size());
+}
+
+static std::vector<PCIeResult> readResults(Transport& transport, int count)
+{
+    std::vector<PCIeResult> results;
+    std::vector<uint8_t>    pkt(RESULT_WINDOW);
+    for (int tries = 0; tries < 1000 && results.size() < count; ++tries) {
+        transport.read(CHIMERA_REQ_WINDOW, pkt.size(), pkt.data(), 0);
+        if (!(pkt[0] & 0x1)) { continue; }
+        for (int i = 0; i < pkt[1]; ++i) {
+            PCIeResult result;
+            std::memcpy(&result, &pkt[2 + i * sizeof(PCIeResult)], sizeof(result));
+            results.push_back(result);
+        }
+    }
+    return results;
+}
+
+static uint64_t valueOf(const PCIeResult& result)
+{
+    uint64_t value;
+    std::memcpy(&value, &result.m_content[8], sizeof(uint64_t));
+    return value;
+}
+
+/**
+ * The session every test runs: four tasks, a fold of the data plane, then
+ * two more tasks with values from last_first. Returns the results read.
+ */
+static std::vector<PCIeResult> runSession(Transport& transport, uint64_t last_first = 100)
+{
+    transport.open();
+    ChimeraCaps caps;
+    transport.read(CHIMERA_REG_CAPS, sizeof(caps), &caps, 0);
+    writeRegister(transport, CHIMERA_REG_READ_MODE, 1);
+    writeRegister(transport, CHIMERA_REG_BATCH, MAX_BATCH_THRESHOLD);
+
+    std::vector<PCIeResult> results;
+    writeTasks(transport, 4, 10);
+    for (const PCIeResult& result : readResults(transport, 4)) { results.push_back(result); }
+    writeData(transport, 0x5a);
+    for (const PCIeResult& result : readResults(transport, 1)) { results.push_back(result); }
+    writeTasks(transport, 2, last_first);
+    for (const PCIeResult& result : readResults(transport, 2)) { results.push_back(result); }
+    transport.close();
+    return results;
+}
+
+class ChimeraReplayTest : public testing::Test
+{
+  protected:
+    std::string m_path;
+    int         m_recordWrites = 0;
+    int         m_liveWrites   = 0;
+
+    void SetUp() override
+    {
+        m_path = testing::TempDir() + "chimera-replay-" + std::to_string(getpid()) + ".rec";
+    }
+
+    void TearDown() override
+    {
+        unlink(m_path.c_str());
+    }
+
+    std::vector<PCIeResult> record()
+    {
+        RecordingTransport recorder(new CountingTransport(&m_recordWrites), m_path, 1);
+        return runSession(recorder);
+    }
+
+    std::vector<PCIeResult> replay(uint64_t last_first = 100)
+    {
+        ReplayTransport replayer(new CountingTransport(&m_liveWrites), m_path, 1);
+        return runSession(replayer, last_first);
+    }
+};
+
+TEST_F(ChimeraReplayTest, ReplayGivesBackTheRecordedResults)
+{
+    std::vector<PCIeResult> recorded = record();
+    ASSERT_EQ(recorded.size(), 7);
+    EXPECT_EQ(valueOf(recorded[0]), 10);
+    EXPECT_EQ(valueOf(recorded[6]), 101);
+
+    std::vector<PCIeResult> replayed = replay();
+    ASSERT_EQ(replayed.size(), recorded.size());
+    for (int i = 0; i < recorded.size(); ++i) {
+        EXPECT_EQ(replayed[i].m_tableID, recorded[i].m_tableID);
+        EXPECT_EQ(std::memcmp(replayed[i].m_content, recorded[i].m_content, RESULT_DATA_SIZE), 0);
+    }
+    // the live card is never touched
+    EXPECT_EQ(m_liveWrites, 0);
+}
+
+TEST_F(ChimeraReplayTest, DivergingGoesLiveWithoutRepeatingResults)
+{
+    std::vector<PCIeResult> recorded = record();
+    ASSERT_EQ(recorded.size(), 7);
+
+    // the last two tasks differ from the log
+    std::vector<PCIeResult> replayed = replay(200);
+    ASSERT_EQ(replayed.size(), 7);
+    for (int i = 0; i < 5; ++i) {
+        EXPECT_EQ(std::memcmp(replayed[i].m_content, recorded[i].m_content, RESULT_DATA_SIZE), 0);
+    }
+    // the results come from the live card, which was given the run again
+    EXPECT_EQ(valueOf(replayed[5]), 200);
+    EXPECT_EQ(valueOf(replayed[6]), 201);
+    EXPECT_GT(m_liveWrites, 0);
+}
+
+TEST_F(ChimeraReplayTest, SessionMismatchRunsLive)
+{
+    record();
+
+    ReplayTransport         replayer(new CountingTransport(&m_liveWrites), m_path, 2);
+    std::vector<PCIeResult> results = runSession(replayer);
+    EXPECT_EQ(results.size(), 7);
+    EXPECT_GT(m_liveWrites, 0);
+}
+
+TEST_F(ChimeraReplayTest, FailedLogWriteKeepsNoRecords)
+{
+    // the header fits, the records do not
+    struct rlimit limit;
+    getrlimit(RLIMIT_FSIZE, &limit);
+    struct rlimit small = {sizeof(ReplayLogHeader), limit.rlim_max};
+    sighandler_t  old   = signal(SIGXFSZ, SIG_IGN);
+    setrlimit(RLIMIT_FSIZE, &small);
+    std::vector<PCIeResult> recorded = record();
+    setrlimit(RLIMIT_FSIZE, &limit);
+    signal(SIGXFSZ, old);
+    ASSERT_EQ(recorded.size(), 7);
+
+    // nothing to match, so the replay runs on the live card
+    std::vector<PCIeResult> replayed = replay();
+    ASSERT_EQ(replayed.size(), 7);
+    EXPECT_EQ(valueOf(replayed[6]), 101);
+    EXPECT_GT(m_liveWrites, 0);
+}
@@ -1,6 +1,10 @@
 #ifndef __FPGA_CHIMERA_RINGBUFFER_HH__
 #define __FPGA_CHIMERA_RINGBUFFER_HH__
 
+#include <assert.h>
+#include <stdint.h>
+
+#include <atomic>
 #include <vector>
 
 namespace gem5
@@ -8,22 +12,45 @@ namespace gem5
 namespace fpga
 {
 
+#define CHIMERA_CACHE_LINE_SIZE 64
+
+static inline uint64_t ringSlots(uint64_t depth)
+{
+    uint64_t slots = 1;
+    while (slots < depth) { slots <<= 1; }
+    return slots;
+}
+
+/**
+ * Bounded single-producer/single-consumer ring. Head and tail live on
+ * their own cache lines and are published with release/acquire ordering,
+ * so one thread may enqueue while another dequeues without a lock. Each
+ * side keeps a private copy of the other side's index and only reloads it
+ * when the ring looks full (or empty) to it.
+ *
+ * isEmpty()/peek()/dequeue() belong to the consumer, isFull()/enqueue() to
+ * the producer; size() is only a snapshot when called from elsewhere.
+ */
 template <typename T>
 class RingBuffer
 {
   private:
-    int            m_depth;
-    std::vector<T> m_queue;
+    alignas(CHIMERA_CACHE_LINE_SIZE) std::atomic<uint64_t> m_head;
+    uint64_t m_cachedTail;
+
+    alignas(CHIMERA_CACHE_LINE_SIZE) std::atomic<uint64_t> m_tail;
+    uint64_t m_cachedHead;
 
-    int m_cons_head;
-    int m_cons_tail;
-    int m_prod_head;
-    int m_prod_tail;
+    alignas(CHIMERA_CACHE_LINE_SIZE) uint64_t m_depth;
+    uint64_t       m_mask;
+    std::vector<T> m_queue;
 
   public:
-    RingBuffer(int depth) : m_depth(depth + 1), m_cons_head(0), m_cons_tail(0), m_prod_head(0), m_prod_tail(0)
+    RingBuffer(int depth) : m_head(0), m_cachedTail(0), m_tail(0), m_cachedHead(0), m_depth(depth)
     {
-        m_queue.resize(m_depth + 1);
+        assert(depth > 0);
+        m_mask = ringSlots(depth) - 1;
+        m_queue.resize(m_mask + 1);
     }
     ~RingBuffer()
     {
@@ -31,50 +58,143 @@ class RingBuffer
 
     bool isFull()
     {
-        return ((m_prod_head + 1) % m_depth == m_cons_tail ? true : false);
+        uint64_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail - m_cachedHead < m_depth) { return false; }
+        m_cachedHead = m_head.load(std::memory_order_acquire);
+        return tail - m_cachedHead >= m_depth;
     }
 
     bool isEmpty()
     {
-        return (m_cons_head == m_prod_tail ? true : false);
+        uint64_t head = m_head.load(std::memory_order_relaxed);
+        if (head != m_cachedTail) { return false; }
+        m_cachedTail = m_tail.load(std::memory_order_acquire);
+        return head == m_cachedTail;
     }
 
-    bool enqueue(T obj)
+    bool enqueue(const T& obj)
     {
-        if (!isFull()) {
-            int local_prod_head = m_prod_head;
-            int local_prod_next = (local_prod_head + 1) % m_depth;
-
-            m_prod_head                 = local_prod_next;
-            m_queue.at(local_prod_head) = obj;
-            m_prod_tail                 = m_prod_head;
-            return true;
-        } else {
-            return false;
-        }
+        if (isFull()) { return false; }
+        uint64_t tail          = m_tail.load(std::memory_order_relaxed);
+        m_queue[tail & m_mask] = obj;
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
     }
 
     T dequeue()
     {
-        int local_cons_head = m_cons_head;
-        int local_cons_next = (local_cons_head + 1) % m_depth;
-
-        m_cons_head = local_cons_next;
-        T result    = m_queue.at(local_cons_head);
-        m_cons_tail = m_cons_head;
+        assert(!isEmpty());
+        uint64_t head   = m_head.load(std::memory_order_relaxed);
+        T        result = m_queue[head & m_mask];
+        m_head.store(head + 1, std::memory_order_release);
         return result;
     }
 
+    bool tryDequeue(T& obj)
+    {
+        if (isEmpty()) { return false; }
+        uint64_t head = m_head.load(std::memory_order_relaxed);
+        obj           = m_queue[head & m_mask];
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
     T peek()
     {
-        int local_cons_head = m_cons_head;
-        T   result          = m_queue.at(local_cons_head);
+        assert(!isEmpty());
+        return m_queue[m_head.load(std::memory_order_relaxed) & m_mask];
+    }
+
+    int size()
+    {
+        return m_tail.load(std::memory_order_acquire) - m_head.load(std::memory_order_acquire);
+    }
+};
+
+/**
+ * Bounded multi-producer/single-consumer ring. Every slot carries a
+ * sequence number (Vyukov's scheme): producers claim a slot with a CAS on
+ * the tail and publish it by bumping the slot sequence, the single
+ * consumer reads slots in order without any read-modify-write.
+ */
+template <typename T>
+class MPSCRingBuffer
+{
+  private:
+    struct alignas(CHIMERA_CACHE_LINE_SIZE) Slot {
+        std::atomic<uint64_t> m_seq;
+        T                     m_obj;
+    };
+
+    alignas(CHIMERA_CACHE_LINE_SIZE) std::atomic<uint64_t> m_head;
+    alignas(CHIMERA_CACHE_LINE_SIZE) std::atomic<uint64_t> m_tail;
+
+    alignas(CHIMERA_CACHE_LINE_SIZE) uint64_t m_depth;
+    uint64_t          m_mask;
+    std::vector<Slot> m_queue;
+
+  public:
+    MPSCRingBuffer(int depth) : m_head(0), m_tail(0), m_depth(depth), m_queue(ringSlots(depth))
+    {
+        assert(depth > 0);
+        m_mask = m_queue.size() - 1;
+        for (uint64_t i = 0; i < m_queue.size(); ++i) { m_queue[i].m_seq.store(i, std::memory_order_relaxed); }
+    }
+    ~MPSCRingBuffer()
+    {
+    }
+
+    bool enqueue(const T& obj)
+    {
+        uint64_t tail = m_tail.load(std::memory_order_relaxed);
+        while (true) {
+            if ((int64_t)(tail - m_head.load(std::memory_order_acquire)) >= (int64_t)m_depth) { return false; }
+            Slot&    slot = m_queue[tail & m_mask];
+            uint64_t seq  = slot.m_seq.load(std::memory_order_acquire);
+            if (seq == tail) {
+                if (m_tail.compare_exchange_weak(tail, tail + 1, std::memory_order_relaxed)) {
+                    slot.m_obj = obj;
+                    slot.m_seq.store(tail + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (seq < tail) {
+                // the consumer has not released this slot yet
+                return false;
+            } else {
+                tail = m_tail.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool isEmpty()
+    {
+        uint64_t head = m_head.load(std::memory_order_relaxed);
+        return m_queue[head & m_mask].m_seq.load(std::memory_order_acquire) != head + 1;
+    }
+
+    bool tryDequeue(T& obj)
+    {
+        uint64_t head = m_head.load(std::memory_order_relaxed);
+        Slot&    slot = m_queue[head & m_mask];
+        if (slot.m_seq.load(std::memory_order_acquire) != head + 1) { return false; }
+        obj = slot.m_obj;
+        slot.m_seq.store(head + m_mask + 1, std::memory_order_release);
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    T dequeue()
+    {
+        T    result;
+        bool success = tryDequeue(result);
+        assert(success);
+        (void)success;
         return result;
     }
 
     int size()
     {
-        return (m_prod_tail - m_cons_head) >= 0 ? (m_prod_tail - m_cons_head) : (m_prod_tail - m_cons_head + m_depth);
+        return m_tail.load(std::memory_order_acquire) - m_head.load(std::memory_order_acquire);
     }
 };
 
@@ -82,4 +202,4 @@ class RingBuffer
 } // namespace gem5
 
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,131 @@
+#include <gtest/gtest.h>
+
+#include <thread>
+#include <vector>
+
+#include "fpga/chimera/ringBuffer.hh"
+#include "fpga/chimera/wait_policy.hh"
+
+using namespace gem5::fpga;
+
+TEST(ChimeraRingBufferTest, FifoOrderAndCapacity)
+{
+    RingBuffer<int> ring(3);
+
+    EXPECT_TRUE(ring.isEmpty());
+    EXPECT_TRUE(ring.enqueue(1));
+    EXPECT_TRUE(ring.enqueue(2));
+    EXPECT_TRUE(ring.enqueue(3));
+    EXPECT_TRUE(ring.isFull());
+    EXPECT_FALSE(ring.enqueue(4));
+    EXPECT_EQ(ring.size(), 3);
+
+    EXPECT_EQ(ring.peek(), 1);
+    EXPECT_EQ(ring.dequeue(), 1);
+    EXPECT_TRUE(ring.enqueue(4));
+    EXPECT_EQ(ring.dequeue(), 2);
+    EXPECT_EQ(ring.dequeue(), 3);
+    EXPECT_EQ(ring.dequeue(), 4);
+    EXPECT_TRUE(ring.isEmpty());
+}
+
+TEST(ChimeraRingBufferTest, WrapsAround)
+{
+    RingBuffer<int> ring(5);
+    for (int i = 0; i < 1000; ++i) {
+        ASSERT_TRUE(ring.enqueue(i));
+        ASSERT_TRUE(ring.enqueue(i + 1));
+        ASSERT_EQ(ring.dequeue(), i);
+        ASSERT_EQ(ring.dequeue(), i + 1);
+    }
+    EXPECT_TRUE(ring.isEmpty());
+}
+
+TEST(ChimeraRingBufferTest, SpscAcrossThreads)
+{
+    const int       count = 20000;
+    RingBuffer<int> ring(16);
+    AdaptiveWaiter  waiter(64, 4);
+
+    std::thread producer([&] {
+        for (int i = 0; i < count; ++i) {
+            while (!ring.enqueue(i)) { sched_yield(); }
+            waiter.notify();
+        }
+    });
+
+    for (int i = 0; i < count; ++i) {
+        waiter.wait([&] { return !ring.isEmpty(); });
+        ASSERT_EQ(ring.dequeue(), i);
+    }
+    producer.join();
+    EXPECT_TRUE(ring.isEmpty());
+}
+
+TEST(ChimeraRingBufferTest, MpscCapacity)
+{
+    MPSCRingBuffer<int> ring(3);
+
+    EXPECT_TRUE(ring.isEmpty());
+    EXPECT_TRUE(ring.enqueue(7));
+    EXPECT_TRUE(ring.enqueue(8));
+    EXPECT_TRUE(ring.enqueue(9));
+    EXPECT_FALSE(ring.enqueue(10));
+    EXPECT_EQ(ring.dequeue(), 7);
+    EXPECT_TRUE(ring.enqueue(10));
+    EXPECT_EQ(ring.dequeue(), 8);
+    EXPECT_EQ(ring.dequeue(), 9);
+    EXPECT_EQ(ring.dequeue(), 10);
+    EXPECT_TRUE(ring.isEmpty());
+}
+
+TEST(ChimeraRingBufferTest, MpscAcrossThreads)
+{
+    const int           producers = 3;
+    const int           count     = 5000;
+    MPSCRingBuffer<int> ring(32);
+
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; ++p) {
+        threads.emplace_back([&ring, p] {
+            for (int i = 0; i < count; ++i) {
+                while (!ring.enqueue(p * count + i)) { sched_yield(); }
+            }
+        });
+    }
+
+    // every producer's items arrive, and in that producer's order
+    std::vector<int> next(producers, 0);
+    for (int received = 0; received < producers * count;) {
+        int value;
+        if (!ring.tryDequeue(value)) {
+            sched_yield();
+            continue;
+        }
+        int p = value / count;
+        ASSERT_EQ(value % count, next[p]);
+        next[p]++;
+        received++;
+    }
+    for (auto& thread : threads) { thread.join(); }
+    EXPECT_TRUE(ring.isEmpty());
+}
+
+TEST(ChimeraRingBufferTest, PollBackoffDoublesUpToCap)
+{
+    PollBackoff backoff(5 * CHIMERA_BACKOFF_MIN_NS);
+
+    for (int i = 0; i < CHIMERA_BACKOFF_RETRY_COUNT; ++i) { EXPECT_EQ(backoff.next(), 0); }
+    EXPECT_EQ(backoff.next(), CHIMERA_BACKOFF_MIN_NS);
+    EXPECT_EQ(backoff.next(), 2 * CHIMERA_BACKOFF_MIN_NS);
+    EXPECT_EQ(backoff.next(), 4 * CHIMERA_BACKOFF_MIN_NS);
+    EXPECT_EQ(backoff.next(), 5 * CHIMERA_BACKOFF_MIN_NS);
+    EXPECT_EQ(backoff.next(), 5 * CHIMERA_BACKOFF_MIN_NS);
+
+    backoff.reset();
+    EXPECT_EQ(backoff.next(), 0);
+
+    // a cap of 0 polls flat out
+    PollBackoff poll(0);
+    for (int i = 0; i < 4 * CHIMERA_BACKOFF_RETRY_COUNT; ++i) { EXPECT_EQ(poll.next(), 0); }
+}
@@ -0,0 +1,115 @@
+#include "fpga/chimera/thread_placement.hh"
+
+#include <sched.h>
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+#include "base/logging.hh"
+#include "base/trace.hh"
+#include "debug/Chimera.hh"
+
+namespace gem5
+{
+namespace fpga
+{
+
+// one CPU number, digits only and small enough for a cpu_set_t
+static bool parseCpu(const std::string& text, int& cpu)
+{
+    if (text.empty() || text.find_first_not_of("0123456789") != std::string::npos) { return false; }
+    errno      = 0;
+    long value = std::strtol(text.c_str(), nullptr, 10);
+    if (errno == ERANGE || value >= CPU_SETSIZE) { return false; }
+    cpu = value;
+    return true;
+}
+
+bool parseCpuList(const std::string& list, std::vector<int>& cpus)
+{
+    std::stringstream ss(list);
+    std::string       entry;
+    while (std::getline(ss, entry, ',')) {
+        // "N" or "N-M", blanks around it are fine
+        size_t      begin = entry.find_first_not_of(" \t\n");
+        size_t      end   = entry.find_last_not_of(" \t\n");
+        std::string range = begin == std::string::npos ? "" : entry.substr(begin, end - begin + 1);
+        size_t      dash  = range.find('-');
+        int         first = 0, last = 0;
+        if (!parseCpu(range.substr(0, dash), first) ||
+            !parseCpu(dash == std::string::npos ? range : range.substr(dash + 1), last) || first > last) {
+            warn("chimera: malformed entry '%s' in CPU list '%s'\n", entry, list);
+            return false;
+        }
+        for (int cpu = first; cpu <= last; ++cpu) { cpus.push_back(cpu); }
+    }
+    return !cpus.empty();
+}
+
+int deviceNumaNode(const std::string& device)
+{
+    // /dev/xdma0 -> /sys/class/xdma/xdma0_h2c_0/device is the PCIe function
+    std::string   name = device.substr(device.find_last_of('/') + 1);
+    std::ifstream file("/sys/class/xdma/" + name + "_h2c_0/device/numa_node");
+    int           node = -1;
+    if (!(file >> node)) { return -1; }
+    return node;
+}
+
+std::vector<int> nodeCpus(int node)
+{
+    std::vector<int> cpus;
+    if (node < 0) { return cpus; }
+
+    std::ifstream file("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+    std::string   list;
+    if (!std::getline(file, list) || !parseCpuList(list, cpus)) { cpus.clear(); }
+    return cpus;
+}
+
+ThreadPlacement::ThreadPlacement(const std::string& spec, int numa_node, int priority, int first, int count) :
+    m_spec(spec), m_spread(false), m_priority(priority), m_first(first)
+{
+    if (spec == "auto") {
+        m_cpus = nodeCpus(numa_node);
+    } else if (!spec.empty()) {
+        if (!parseCpuList(spec, m_cpus)) { fatal("chimera: malformed CPU list '%s'\n", spec); }
+        if ((int)m_cpus.size() < first + count) {
+            fatal("chimera: CPU list '%s' has %d CPUs for at least %d threads\n", spec, m_cpus.size(), first + count);
+        }
+        m_spread = true;
+    }
+}
+
+void ThreadPlacement::apply(const char* role, int index) const
+{
+    if (!m_cpus.empty()) {
+        cpu_set_t cpuset;
+        CPU_ZERO(&cpuset);
+        if (m_spread) {
+            CPU_SET(m_cpus[m_first + index], &cpuset);
+        } else {
+            for (int cpu : m_cpus) { CPU_SET(cpu, &cpuset); }
+        }
+        if (sched_setaffinity(0, sizeof(cpu_set_t), &cpuset) != 0) {
+            warn("chimera: failed to place the %s thread on CPUs '%s': %s\n", role, m_spec, std::strerror(errno));
+        } else {
+            DPRINTF(Chimera, "%s thread %d placed on CPUs '%s'\n", role, index,
+                    m_spread ? std::to_string(m_cpus[m_first + index]) : m_spec);
+        }
+    }
+
+    if (m_priority > 0) {
+        sched_param param;
+        param.sched_priority = m_priority;
+        if (sched_setscheduler(0, SCHED_FIFO, &param) != 0) {
+            warn_once("chimera: failed to switch worker threads to SCHED_FIFO (needs CAP_SYS_NICE)\n");
+        }
+    }
+}
+
+} // namespace fpga
+} // namespace gem5
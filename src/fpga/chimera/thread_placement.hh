@@ -0,0 +1,59 @@
+#ifndef __FPGA_CHIMERA_THREAD_PLACEMENT_HH__
+#define __FPGA_CHIMERA_THREAD_PLACEMENT_HH__
+
+#include <string>
+#include <vector>
+
+namespace gem5
+{
+namespace fpga
+{
+
+// parse a CPU list in the sysfs cpulist format ("0-3,8,10-11"); returns
+// false, with a warning naming the entry, on a malformed list
+bool parseCpuList(const std::string& list, std::vector<int>& cpus);
+
+// NUMA node the XDMA endpoint behind the device prefix sits on, -1 if the
+// host does not say (no device, or a single-node machine)
+int deviceNumaNode(const std::string& device);
+
+// CPUs of a NUMA node, empty if the node is unknown
+std::vector<int> nodeCpus(int node);
+
+/**
+ * Where one kind of Chimera thread runs. The placement is given as a CPU
+ * list, "auto" for the CPUs of the card's NUMA node, or empty to leave
+ * the threads to the scheduler.
+ *
+ * The count threads of that kind take the CPUs of an explicit list from
+ * position first on, so kinds given the same list do not share a CPU;
+ * the list must have a CPU for each of them. With "auto" they all share
+ * the node and the scheduler balances them within it, so co-simulations
+ * on one host spread over the node instead of piling onto the same cores.
+ *
+ * apply() places the calling thread, the index-th of its kind. A non-zero
+ * priority also switches the thread to SCHED_FIFO.
+ */
+class ThreadPlacement
+{
+  private:
+    std::string      m_spec;
+    std::vector<int> m_cpus;
+    bool             m_spread;
+    int              m_priority;
+    int              m_first;
+
+  public:
+    ThreadPlacement() : m_spread(false), m_priority(0), m_first(0)
+    {
+    }
+
+    ThreadPlacement(const std::string& spec, int numa_node, int priority = 0, int first = 0, int count = 1);
+
+    void apply(const char* role, int index = 0) const;
+};
+
+} // namespace fpga
+} // namespace gem5
+
+#endif
@@ -0,0 +1,56 @@
+#include <gtest/gtest.h>
+
+#include <sched.h>
+
+#include <string>
+#include <vector>
+
+#include "fpga/chimera/thread_placement.hh"
+
+using namespace gem5::fpga;
+
+static std::vector<int> parse(const std::string& list, bool expect_ok = true)
+{
+    std::vector<int> cpus;
+    EXPECT_EQ(parseCpuList(list, cpus), expect_ok) << "'" << list << "'";
+    return cpus;
+}
+
+TEST(ChimeraCpuListTest, ParsesSingleCpusAndRanges)
+{
+    EXPECT_EQ(parse("3"), std::vector<int>({3}));
+    EXPECT_EQ(parse("0-3,8,10-11"), std::vector<int>({0, 1, 2, 3, 8, 10, 11}));
+    EXPECT_EQ(parse("5-5"), std::vector<int>({5}));
+}
+
+TEST(ChimeraCpuListTest, AcceptsTheSysfsFormat)
+{
+    // cpulist ends in a newline, and blanks around an entry are harmless
+    EXPECT_EQ(parse("0-1,4\n"), std::vector<int>({0, 1, 4}));
+    EXPECT_EQ(parse(" 2 , 6-7 "), std::vector<int>({2, 6, 7}));
+}
+
+TEST(ChimeraCpuListTest, RejectsTrailingText)
+{
+    parse("3-", false);
+    parse("1-2-3", false);
+    parse("1-2x", false);
+    parse("2 3", false);
+}
+
+TEST(ChimeraCpuListTest, RejectsMalformedEntries)
+{
+    parse("", false);
+    parse("-3", false);
+    parse("a", false);
+    parse("0,,1", false);
+    parse("+1", false);
+    parse("4-2", false);
+}
+
+TEST(ChimeraCpuListTest, RejectsCpusACpuSetCannotHold)
+{
+    parse(std::to_string(CPU_SETSIZE - 1));
+    parse(std::to_string(CPU_SETSIZE), false);
+    parse("0-99999999999999999999", false);
+}
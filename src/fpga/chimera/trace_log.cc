@@ -0,0 +1,89 @@
+#include "fpga/chimera/trace_log.hh"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include "base/logging.hh"
+#include "fpga/chimera/utils.hh"
+
+namespace gem5
+{
+namespace fpga
+{
+
+ChimeraTraceLog::ChimeraTraceLog(const std::string& path, int capacity) :
+    m_file(nullptr), m_ring(capacity), m_threshold(std::max(capacity / 4, 1)), m_done(false), m_dropped(0),
+    m_waiter(0, 0), m_base(get_system_time_nanosecond()), m_first(true)
+{
+    m_file = std::fopen(path.c_str(), "w");
+    if (!m_file) { fatal("chimera: cannot open trace file %s: %s\n", path, std::strerror(errno)); }
+    std::fprintf(m_file, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+
+    m_writer = std::thread(&ChimeraTraceLog::writerFunc, this);
+}
+
+ChimeraTraceLog::~ChimeraTraceLog()
+{
+    close();
+}
+
+void ChimeraTraceLog::writerFunc()
+{
+    while (true) {
+        m_waiter.wait([this] { return m_ring.size() >= m_threshold || m_done.load(std::memory_order_acquire); });
+
+        TaskTraceRecord record;
+        while (m_ring.tryDequeue(record)) { write(record); }
+
+        if (m_done.load(std::memory_order_acquire) && m_ring.isEmpty()) { break; }
+    }
+}
+
+void ChimeraTraceLog::close()
+{
+    if (!m_file) { return; }
+
+    m_done.store(true, std::memory_order_release);
+    m_waiter.notify();
+    m_writer.join();
+
+    std::fprintf(m_file, "\n]}\n");
+    std::fclose(m_file);
+    m_file = nullptr;
+
+    if (dropped() > 0) {
+        warn("chimera: %d tasks were not traced, the trace buffer was full (raise traceBufferSize)\n", dropped());
+    }
+}
+
+void ChimeraTraceLog::write(const TaskTraceRecord& record)
+{
+    const LifeCycle& life = record.m_life;
+    writeSlice("queue", life.m_recvTime, life.m_pre_submitTime, record);
+    writeSlice("pcie submit", life.m_pre_submitTime, life.m_post_submitTime, record);
+    if (life.m_needResp) {
+        writeSlice("card", life.m_post_submitTime, life.m_pre_collectTime, record);
+        writeSlice("pcie collect", life.m_pre_collectTime, life.m_post_collectTime, record);
+        writeSlice("response", life.m_post_collectTime, life.m_respTime, record);
+    }
+}
+
+void ChimeraTraceLog::writeSlice(const char* stage, uint64_t start, uint64_t end, const TaskTraceRecord& record)
+{
+    // tasks are logged as they finish, not as they arrive; the base is taken
+    // before the engine takes any, so no slice starts before it
+    start = std::max(start, m_base);
+    end   = std::max(end, start);
+
+    std::fprintf(m_file,
+                 "%s{\"name\":\"%s\",\"cat\":\"chimera\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":%d,"
+                 "\"tid\":%d,\"args\":{\"task\":%lu,\"channel\":%d,\"hwCycles\":%lu}}",
+                 m_first ? "" : ",\n", stage, (start - m_base) / 1000.0, (end - start) / 1000.0, record.m_device,
+                 record.m_tableID, record.m_uid, record.m_channel,
+                 record.m_life.m_post_hwTime - record.m_life.m_pre_hwTime);
+    m_first = false;
+}
+
+} // namespace fpga
+} // namespace gem5
@@ -0,0 +1,80 @@
+#ifndef __FPGA_CHIMERA_TRACE_LOG_HH__
+#define __FPGA_CHIMERA_TRACE_LOG_HH__
+
+#include <atomic>
+#include <cstdio>
+#include <string>
+#include <thread>
+
+#include "fpga/chimera/common.hh"
+#include "fpga/chimera/ringBuffer.hh"
+#include "fpga/chimera/wait_policy.hh"
+
+namespace gem5
+{
+namespace fpga
+{
+
+// the life of one task, as handed to the trace log
+struct TaskTraceRecord {
+    uint64_t  m_uid;
+    int       m_tableID;
+    int       m_device;
+    int       m_channel;
+    LifeCycle m_life;
+};
+
+/**
+ * Per-task event log in Chrome trace JSON, which chrome://tracing and the
+ * Perfetto UI open as they are. Every task becomes one row per table
+ * entry with a slice per stage of its life, from the gem5 thread handing
+ * it over to its result being back.
+ *
+ * Records go into a preallocated ring; a writer thread of its own formats
+ * them once the ring is a quarter full, so logging a task costs a copy.
+ * Records that find the ring full are dropped and counted. Only one thread
+ * may log at a time.
+ */
+class ChimeraTraceLog
+{
+  private:
+    FILE*                       m_file;
+    RingBuffer<TaskTraceRecord> m_ring;
+    int                         m_threshold;
+    std::atomic<bool>           m_done;
+    std::atomic<uint64_t>       m_dropped;
+    AdaptiveWaiter              m_waiter;
+    std::thread                 m_writer;
+    uint64_t                    m_base; // host time the trace starts at
+    bool                        m_first;
+
+    void writerFunc();
+    void write(const TaskTraceRecord& record);
+    void writeSlice(const char* stage, uint64_t start, uint64_t end, const TaskTraceRecord& record);
+
+  public:
+    ChimeraTraceLog(const std::string& path, int capacity);
+    ~ChimeraTraceLog();
+
+    void log(const TaskTraceRecord& record)
+    {
+        if (!m_ring.enqueue(record)) {
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+        } else if (m_ring.size() == m_threshold) {
+            m_waiter.notify();
+        }
+    }
+
+    // writes what is left and closes the file
+    void close();
+
+    uint64_t dropped() const
+    {
+        return m_dropped.load(std::memory_order_relaxed);
+    }
+};
+
+} // namespace fpga
+} // namespace gem5
+
+#endif
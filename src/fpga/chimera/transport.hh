@@ -0,0 +1,134 @@
+#ifndef __FPGA_CHIMERA_TRANSPORT_HH__
+#define __FPGA_CHIMERA_TRANSPORT_HH__
+
+#include <stdint.h>
+#include <sys/uio.h>
+#include <string>
+#include <vector>
+
+#include "fpga/chimera/uring_engine.hh"
+
+namespace gem5
+{
+namespace fpga
+{
+
+// H2C/C2H channel pairs an XDMA endpoint can be built with
+#define XDMA_MAX_CHANNELS 4
+
+/**
+ * Backend used by FPGAEngine to move bytes to and from the card. Addresses
+ * follow the card's register/response map (see common.hh): 0x0 is the
+ * request/response window, 0x1000/0x1008/0x1010/0x2000 are control
+ * registers and everything above CHIMERA_DATA_PLANE_BASE is data plane.
+ *
+ * Transfers go over one of channelNum() DMA channels. Different channels
+ * may be driven concurrently from different threads; one channel is only
+ * ever used by one thread at a time.
+ *
+ * write()/read() return the number of bytes transferred, or -1 on error.
+ *
+ * submitWrite() queues a write that completes later and reap() collects
+ * the finished writes of a channel, waiting for at least min_complete of
+ * them; writes on one channel complete in submission order and the buffer
+ * must stay untouched until its tag is reaped. The default carries the
+ * write out at once through write(), so a backend without an asynchronous
+ * path behaves exactly like the blocking one. A backend may hold queued
+ * writes back to hand several to the driver at once; flush() passes on
+ * what a channel holds, and reap() flushes the channel before it waits.
+ * A caller about to wait for anything the card does with its writes
+ * flushes first. registerBuffer() announces
+ * memory that transfers will be issued from, for backends that can pin it
+ * once instead of per transfer.
+ *
+ * writev()/submitWritev() write iovcnt buffers to consecutive addresses
+ * from addr as one transfer, for backends that can hand the driver a
+ * scatter-gather list; the iovec array must stay untouched as long as the
+ * buffers. The default writes the buffers one after the other.
+ *
+ * Backends that can tell when the card has results (an XDMA user
+ * interrupt, an eventfd) report hasEvents(); waitEvent() then blocks until
+ * the card signals or timeout_ns passes and returns whether it signalled.
+ * A signal only says a read is worth trying, it may be spurious.
+ */
+class Transport
+{
+  protected:
+    int m_channelNum;
+
+    // writes submitWrite() finished synchronously, waiting to be reaped
+    std::vector<std::vector<DMACompletion>> m_completed;
+
+  public:
+    Transport(int channel_num) : m_channelNum(channel_num), m_completed(channel_num)
+    {
+    }
+
+    virtual ~Transport()
+    {
+    }
+
+    int channelNum() const
+    {
+        return m_channelNum;
+    }
+
+    virtual void    open()  = 0;
+    virtual void    close() = 0;
+    virtual int64_t write(uint64_t addr, uint64_t size, const void* msg, int channel) = 0;
+    virtual int64_t read(uint64_t addr, uint64_t size, void* msg, int channel) = 0;
+
+    virtual void submitWrite(uint64_t addr, uint64_t size, const void* msg, int channel, uint64_t tag)
+    {
+        m_completed[channel].push_back({tag, write(addr, size, msg, channel)});
+    }
+
+    virtual int64_t writev(uint64_t addr, const iovec* iov, int iovcnt, int channel)
+    {
+        int64_t total = 0;
+        for (int i = 0; i < iovcnt; ++i) {
+            int64_t ret = write(addr + total, iov[i].iov_len, iov[i].iov_base, channel);
+            if (ret != (int64_t)iov[i].iov_len) { return ret < 0 ? ret : total + ret; }
+            total += ret;
+        }
+        return total;
+    }
+
+    virtual void submitWritev(uint64_t addr, const iovec* iov, int iovcnt, int channel, uint64_t tag)
+    {
+        m_completed[channel].push_back({tag, writev(addr, iov, iovcnt, channel)});
+    }
+
+    virtual void flush(int channel)
+    {
+    }
+
+    virtual int reap(int channel, std::vector<DMACompletion>& done, unsigned min_complete)
+    {
+        int num = m_completed[channel].size();
+        done.insert(done.end(), m_completed[channel].begin(), m_completed[channel].end());
+        m_completed[channel].clear();
+        return num;
+    }
+
+    virtual void registerBuffer(void* base, uint64_t size)
+    {
+    }
+
+    virtual bool hasEvents() const
+    {
+        return false;
+    }
+
+    virtual bool waitEvent(int channel, uint64_t timeout_ns)
+    {
+        return false;
+    }
+
+    virtual std::string name() const = 0;
+};
+
+} // namespace fpga
+} // namespace gem5
+
+#endif
@@ -0,0 +1,296 @@
+#include "fpga/chimera/uring_engine.hh"
+
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cstdlib>
+#include <cstring>
+
+#include "config/have_io_uring.hh"
+
+#if HAVE_IO_URING
+#include <linux/io_uring.h>
+#endif
+
+namespace gem5
+{
+namespace fpga
+{
+
+UringEngine::UringEngine() :
+    m_ringFd(-1), m_sqRing(MAP_FAILED), m_sqRingSize(0), m_cqRing(MAP_FAILED), m_cqRingSize(0), m_sqesSize(0),
+    m_pending(0), m_inflight(0), m_linkable(false), m_filesRegistered(false)
+{
+    m_sqes = nullptr;
+    m_cqes = nullptr;
+}
+
+UringEngine::~UringEngine()
+{
+    exit();
+}
+
+#if HAVE_IO_URING
+
+static int uringSetup(unsigned entries, io_uring_params* params)
+{
+    return syscall(__NR_io_uring_setup, entries, params);
+}
+
+static int uringEnter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags)
+{
+    return syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, nullptr, 0);
+}
+
+static int uringRegister(int fd, unsigned opcode, const void* arg, unsigned nr_args)
+{
+    return syscall(__NR_io_uring_register, fd, opcode, arg, nr_args);
+}
+
+bool UringEngine::init(unsigned entries)
+{
+    io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+    int fd = uringSetup(entries, &params);
+    if (fd < 0) { return false; }
+    m_ringFd = fd;
+
+    m_sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    m_cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    m_sqesSize   = params.sq_entries * sizeof(io_uring_sqe);
+
+    m_sqRing = mmap(nullptr, m_sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    m_cqRing = mmap(nullptr, m_cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+    void* sqes = mmap(nullptr, m_sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+    if (m_sqRing == MAP_FAILED || m_cqRing == MAP_FAILED || sqes == MAP_FAILED) {
+        if (sqes != MAP_FAILED) { munmap(sqes, m_sqesSize); }
+        exit();
+        return false;
+    }
+
+    uint8_t* sq = static_cast<uint8_t*>(m_sqRing);
+    m_sqHead    = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+    m_sqTail    = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    m_sqArray   = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+    m_sqMask    = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    m_sqEntries = params.sq_entries;
+    m_sqes      = static_cast<io_uring_sqe*>(sqes);
+
+    uint8_t* cq = static_cast<uint8_t*>(m_cqRing);
+    m_cqHead    = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    m_cqTail    = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    m_cqMask    = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    m_cqEntries = params.cq_entries;
+    m_cqes      = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+
+    // plain READ/WRITE with an offset need 5.6; older kernels fall back
+    uint64_t        probeSize = sizeof(io_uring_probe) + 256 * sizeof(io_uring_probe_op);
+    io_uring_probe* probe     = static_cast<io_uring_probe*>(std::calloc(1, probeSize));
+    bool            supported = uringRegister(fd, IORING_REGISTER_PROBE, probe, 256) >= 0
+                     && probe->ops_len > IORING_OP_WRITE
+                     && (probe->ops[IORING_OP_WRITE].flags & IO_URING_OP_SUPPORTED)
+                     && (probe->ops[IORING_OP_READ].flags & IO_URING_OP_SUPPORTED);
+    std::free(probe);
+    if (!supported) {
+        exit();
+        return false;
+    }
+    return true;
+}
+
+void UringEngine::exit()
+{
+    if (m_sqes) { munmap(m_sqes, m_sqesSize); }
+    if (m_sqRing != MAP_FAILED) { munmap(m_sqRing, m_sqRingSize); }
+    if (m_cqRing != MAP_FAILED) { munmap(m_cqRing, m_cqRingSize); }
+    if (m_ringFd >= 0) { ::close(m_ringFd); }
+    m_sqes            = nullptr;
+    m_cqes            = nullptr;
+    m_sqRing          = MAP_FAILED;
+    m_cqRing          = MAP_FAILED;
+    m_ringFd          = -1;
+    m_pending         = 0;
+    m_inflight        = 0;
+    m_linkable        = false;
+    m_filesRegistered = false;
+    m_buffers.clear();
+}
+
+bool UringEngine::registerFiles(const std::vector<int>& fds)
+{
+    if (uringRegister(m_ringFd, IORING_REGISTER_FILES, fds.data(), fds.size()) < 0) { return false; }
+    m_filesRegistered = true;
+    return true;
+}
+
+bool UringEngine::registerBuffer(void* base, uint64_t size)
+{
+    // the table can only be registered as a whole, so replace it
+    if (!m_buffers.empty()) { uringRegister(m_ringFd, IORING_UNREGISTER_BUFFERS, nullptr, 0); }
+    m_buffers.push_back({base, size});
+    if (uringRegister(m_ringFd, IORING_REGISTER_BUFFERS, m_buffers.data(), m_buffers.size()) < 0) {
+        m_buffers.clear();
+        return false;
+    }
+    return true;
+}
+
+bool UringEngine::prep(uint8_t opcode, uint8_t fixed_opcode, int file, const void* buf, uint64_t size,
+                       uint64_t offset, uint64_t tag, bool ordered)
+{
+    unsigned tail = *m_sqTail;
+    unsigned head = __atomic_load_n(m_sqHead, __ATOMIC_ACQUIRE);
+    // never let more requests out than the completion ring can hold
+    if (tail - head >= m_sqEntries || inflight() >= m_cqEntries) { return false; }
+
+    unsigned      index = tail & m_sqMask;
+    io_uring_sqe* sqe   = &m_sqes[index];
+    std::memset(sqe, 0, sizeof(*sqe));
+
+    int bufIndex = opcode == fixed_opcode ? -1 : findBuffer(buf, size);
+    sqe->opcode  = bufIndex >= 0 ? fixed_opcode : opcode;
+    sqe->fd      = file;
+    sqe->addr    = reinterpret_cast<uint64_t>(buf);
+    sqe->len     = size;
+    sqe->off     = offset;
+    sqe->user_data = tag;
+    if (bufIndex >= 0) { sqe->buf_index = bufIndex; }
+    if (m_filesRegistered) { sqe->flags |= IOSQE_FIXED_FILE; }
+    if (ordered) {
+        if (m_linkable) {
+            // not submitted yet, so the previous entry can still be chained to this one
+            m_sqes[(tail - 1) & m_sqMask].flags |= IOSQE_IO_LINK;
+        } else if (inflight() > 0) {
+            sqe->flags |= IOSQE_IO_DRAIN;
+        }
+    }
+    m_linkable = ordered;
+
+    m_sqArray[index] = index;
+    __atomic_store_n(m_sqTail, tail + 1, __ATOMIC_RELEASE);
+    m_pending++;
+    return true;
+}
+
+bool UringEngine::prepWrite(int file, const void* buf, uint64_t size, uint64_t offset, uint64_t tag, bool ordered)
+{
+    return prep(IORING_OP_WRITE, IORING_OP_WRITE_FIXED, file, buf, size, offset, tag, ordered);
+}
+
+bool UringEngine::prepRead(int file, void* buf, uint64_t size, uint64_t offset, uint64_t tag, bool ordered)
+{
+    return prep(IORING_OP_READ, IORING_OP_READ_FIXED, file, buf, size, offset, tag, ordered);
+}
+
+bool UringEngine::prepWritev(int file, const iovec* iov, int iovcnt, uint64_t offset, uint64_t tag, bool ordered)
+{
+    // the entry takes the iovec array and its length in place of a buffer
+    return prep(IORING_OP_WRITEV, IORING_OP_WRITEV, file, iov, iovcnt, offset, tag, ordered);
+}
+
+int UringEngine::submit()
+{
+    // a chain ends with the submission, later requests drain behind it
+    m_linkable = false;
+    while (m_pending > 0) {
+        int ret = uringEnter(m_ringFd, m_pending, 0, 0);
+        if (ret < 0) {
+            if (errno == EINTR || errno == EAGAIN || errno == EBUSY) { continue; }
+            return -errno;
+        }
+        m_pending -= ret;
+        m_inflight += ret;
+    }
+    return 0;
+}
+
+int UringEngine::reap(std::vector<DMACompletion>& done, unsigned min_complete)
+{
+    int ret = submit();
+    if (ret < 0) { return ret; }
+
+    unsigned head  = *m_cqHead;
+    unsigned ready = __atomic_load_n(m_cqTail, __ATOMIC_ACQUIRE) - head;
+    while (ready < min_complete && ready < m_inflight) {
+        ret = uringEnter(m_ringFd, 0, min_complete - ready, IORING_ENTER_GETEVENTS);
+        if (ret < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY) { return -errno; }
+        ready = __atomic_load_n(m_cqTail, __ATOMIC_ACQUIRE) - head;
+    }
+
+    for (unsigned i = 0; i < ready; ++i) {
+        io_uring_cqe* cqe = &m_cqes[(head + i) & m_cqMask];
+        done.push_back({cqe->user_data, cqe->res});
+    }
+    __atomic_store_n(m_cqHead, head + ready, __ATOMIC_RELEASE);
+    m_inflight -= ready;
+    return ready;
+}
+
+#else
+
+bool UringEngine::init(unsigned entries)
+{
+    return false;
+}
+
+void UringEngine::exit()
+{
+}
+
+bool UringEngine::registerFiles(const std::vector<int>& fds)
+{
+    return false;
+}
+
+bool UringEngine::registerBuffer(void* base, uint64_t size)
+{
+    return false;
+}
+
+bool UringEngine::prep(uint8_t opcode, uint8_t fixed_opcode, int file, const void* buf, uint64_t size,
+                       uint64_t offset, uint64_t tag, bool ordered)
+{
+    return false;
+}
+
+bool UringEngine::prepWrite(int file, const void* buf, uint64_t size, uint64_t offset, uint64_t tag, bool ordered)
+{
+    return false;
+}
+
+bool UringEngine::prepRead(int file, void* buf, uint64_t size, uint64_t offset, uint64_t tag, bool ordered)
+{
+    return false;
+}
+
+bool UringEngine::prepWritev(int file, const iovec* iov, int iovcnt, uint64_t offset, uint64_t tag, bool ordered)
+{
+    return false;
+}
+
+int UringEngine::submit()
+{
+    return -ENOSYS;
+}
+
+int UringEngine::reap(std::vector<DMACompletion>& done, unsigned min_complete)
+{
+    return -ENOSYS;
+}
+
+#endif
+
+int UringEngine::findBuffer(const void* buf, uint64_t size)
+{
+    const uint8_t* start = static_cast<const uint8_t*>(buf);
+    for (int i = 0; i < m_buffers.size(); ++i) {
+        const uint8_t* base = static_cast<const uint8_t*>(m_buffers[i].iov_base);
+        if (start >= base && start + size <= base + m_buffers[i].iov_len) { return i; }
+    }
+    return -1;
+}
+
+} // namespace fpga
+} // namespace gem5
@@ -0,0 +1,109 @@
+#ifndef __FPGA_CHIMERA_URING_ENGINE_HH__
+#define __FPGA_CHIMERA_URING_ENGINE_HH__
+
+#include <stdint.h>
+#include <sys/uio.h>
+
+#include <vector>
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+
+namespace gem5
+{
+namespace fpga
+{
+
+struct DMACompletion {
+    uint64_t m_tag;
+    int64_t  m_result; // bytes transferred, or -errno
+};
+
+/**
+ * Minimal io_uring submission/completion queue pair, driven with the raw
+ * syscalls so it needs nothing beyond the kernel headers. It is meant for
+ * one thread: prepWrite()/prepRead() queue a transfer with an explicit
+ * offset, submit() hands queued transfers to the kernel in one call and
+ * reap() collects finished ones in batches, entering the kernel only when
+ * it has to wait.
+ *
+ * Registered files are addressed by their index in registerFiles(); a
+ * transfer whose buffer lies inside a registerBuffer() region is issued as
+ * a fixed-buffer transfer. Vectored writes never are, the kernel has no
+ * fixed-buffer form of them. An ordered transfer starts only after the
+ * ones queued before it have completed, which keeps a stream in order even
+ * when the kernel runs the requests on worker threads. Ordered transfers
+ * queued back to back are linked (IOSQE_IO_LINK), so the kernel starts
+ * each as soon as the previous one is done; only the first of a chain
+ * waits for what is already in flight (IOSQE_IO_DRAIN). Queue a stream's
+ * transfers before calling submit() to keep the chain long.
+ *
+ * init() fails, and callers fall back to blocking I/O, if the kernel or
+ * the build has no io_uring.
+ */
+class UringEngine
+{
+  private:
+    int m_ringFd;
+
+    unsigned*     m_sqHead;
+    unsigned*     m_sqTail;
+    unsigned*     m_sqArray;
+    unsigned      m_sqMask;
+    unsigned      m_sqEntries;
+    io_uring_sqe* m_sqes;
+
+    unsigned*     m_cqHead;
+    unsigned*     m_cqTail;
+    unsigned      m_cqMask;
+    unsigned      m_cqEntries;
+    io_uring_cqe* m_cqes;
+
+    void*    m_sqRing;
+    uint64_t m_sqRingSize;
+    void*    m_cqRing;
+    uint64_t m_cqRingSize;
+    uint64_t m_sqesSize;
+
+    unsigned m_pending;  // queued, not yet submitted
+    unsigned m_inflight; // submitted, not yet reaped
+    bool     m_linkable; // the last queued request is ordered and not yet submitted
+
+    bool               m_filesRegistered;
+    std::vector<iovec> m_buffers;
+
+    int  findBuffer(const void* buf, uint64_t size);
+    bool prep(uint8_t opcode, uint8_t fixed_opcode, int file, const void* buf, uint64_t size, uint64_t offset,
+              uint64_t tag, bool ordered);
+
+  public:
+    UringEngine();
+    ~UringEngine();
+
+    bool init(unsigned entries);
+    void exit();
+
+    bool registerFiles(const std::vector<int>& fds);
+    bool registerBuffer(void* base, uint64_t size);
+
+    bool prepWrite(int file, const void* buf, uint64_t size, uint64_t offset, uint64_t tag, bool ordered);
+    bool prepRead(int file, void* buf, uint64_t size, uint64_t offset, uint64_t tag, bool ordered);
+    bool prepWritev(int file, const iovec* iov, int iovcnt, uint64_t offset, uint64_t tag, bool ordered);
+    int  submit();
+    int  reap(std::vector<DMACompletion>& done, unsigned min_complete);
+
+    bool isReady()
+    {
+        return m_ringFd >= 0;
+    }
+
+    unsigned inflight()
+    {
+        return m_pending + m_inflight;
+    }
+};
+
+} // namespace fpga
+} // namespace gem5
+
+#endif
@@ -14,6 +14,15 @@ long get_system_time_nanosecond()
         return 0;
 }
 
+long get_thread_cpu_time_nanosecond()
+{
+    struct timespec timestamp = {};
+    if (0 == clock_gettime(CLOCK_THREAD_CPUTIME_ID, &timestamp))
+        return timestamp.tv_sec * 1000000000 + timestamp.tv_nsec;
+    else
+        return 0;
+}
+
 long get_system_time_microsecond()
 {
     struct timeval timestamp = {};
@@ -18,6 +18,9 @@ long get_system_time_microsecond();
 long get_system_time_millisecond();
 long get_system_time_second();     
 
+// CPU time consumed by the calling thread
+long get_thread_cpu_time_nanosecond();
+
 } // namespace fpga
 } // namespace gem5
 
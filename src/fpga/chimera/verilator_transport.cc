@@ -0,0 +1,135 @@
+#include "fpga/chimera/verilator_transport.hh"
+
+#include "base/trace.hh"
+#include "debug/FPGAEngine.hh"
+
+namespace gem5
+{
+namespace fpga
+{
+
+VerilatorTransport::VerilatorTransport(bool dump_wave, int channel_num) :
+    EmulatedTransport("", channel_num), m_wrapper(nullptr), m_dumpWave(dump_wave), m_workerDone(false)
+{
+}
+
+VerilatorTransport::~VerilatorTransport()
+{
+    close();
+}
+
+void VerilatorTransport::open()
+{
+    EmulatedTransport::open();
+
+    // the wrapper exits the process from its destructor, so it lives as
+    // long as the simulation does
+    if (!m_wrapper) { m_wrapper = new Wrapper_mpeg2(m_dumpWave, "chimera_mpeg2_trace.vcd"); }
+
+    m_workerDone = false;
+    m_worker     = std::thread(&VerilatorTransport::workerFunc, this);
+}
+
+void VerilatorTransport::close()
+{
+    if (m_worker.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(m_inputMTX);
+            m_workerDone = true;
+        }
+        m_inputCV.notify_one();
+        m_worker.join();
+    }
+    EmulatedTransport::close();
+}
+
+void VerilatorTransport::enqueue(const inputMPEG2& input)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_inputMTX);
+        m_inputs.push_back(input);
+    }
+    m_inputCV.notify_one();
+}
+
+void VerilatorTransport::ipReset()
+{
+    m_regs      = inputMPEG2();
+    m_regs.rstn = 0;
+    enqueue(m_regs);
+}
+
+void VerilatorTransport::ipTask(const PCIeCtrlTask& task)
+{
+    uint64_t addr  = 0;
+    uint64_t value = 0;
+    std::memcpy(&addr, &(task.m_content[0]), sizeof(uint64_t));
+    std::memcpy(&value, &(task.m_content[8]), sizeof(uint64_t));
+
+    if (addr >= CHIMERA_DATA_PLANE_BASE) {
+        ipData(addr, &(task.m_content[8]));
+    } else if (addr == 0x0) {
+        m_regs.rstn         = value & 0x1;
+        inputMPEG2 input    = m_regs;
+        input.sequence_stop = (value & 0x2) ? 1 : 0;
+        enqueue(input);
+    } else if (addr == 0x8) {
+        m_regs.xsize16 = static_cast<uint32_t>(value >> 32);
+        m_regs.ysize16 = static_cast<uint32_t>(value);
+        enqueue(m_regs);
+    }
+}
+
+void VerilatorTransport::ipData(uint64_t addr, const uint8_t* beat)
+{
+    inputMPEG2 input = m_regs;
+    input.i_en       = 1;
+    input.i_Y0       = beat[0];
+    input.i_U0       = beat[1];
+    input.i_Y1       = beat[2];
+    input.i_V0       = beat[3];
+    input.i_Y2       = beat[4];
+    input.i_U2       = beat[5];
+    input.i_Y3       = beat[6];
+    input.i_V2       = beat[7];
+    enqueue(input);
+}
+
+void VerilatorTransport::workerFunc()
+{
+    inputMPEG2 idle;
+    uint64_t   idleCycles = 0;
+
+    while (true) {
+        inputMPEG2 input;
+        bool       hasInput = false;
+        {
+            std::unique_lock<std::mutex> lock(m_inputMTX);
+            if (m_inputs.empty() && idleCycles >= VERILATOR_DRAIN_CYCLES) {
+                DPRINTF(FPGAEngine, "verilator worker idle, ready to sleep\n");
+                m_inputCV.wait(lock, [this] { return !m_inputs.empty() || m_workerDone; });
+                idleCycles = 0;
+            }
+            if (m_workerDone) { break; }
+            if (!m_inputs.empty()) {
+                input    = m_inputs.front();
+                hasInput = true;
+                m_inputs.pop_front();
+                // registers hold their value while no input arrives
+                idle               = input;
+                idle.i_en          = 0;
+                idle.sequence_stop = 0;
+            }
+        }
+
+        outputMPEG2 output = m_wrapper->tick(hasInput ? input : idle);
+
+        if (output.o_en) { pushData(output.o_data, sizeof(output.o_data)); }
+        if (output.o_last) { pushFinish(); }
+
+        idleCycles = (hasInput || output.o_en) ? 0 : idleCycles + 1;
+    }
+}
+
+} // namespace fpga
+} // namespace gem5
@@ -0,0 +1,64 @@
+#ifndef __FPGA_CHIMERA_VERILATOR_TRANSPORT_HH__
+#define __FPGA_CHIMERA_VERILATOR_TRANSPORT_HH__
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#include "fpga/chimera/emulated_transport.hh"
+#include "fpga/mpeg2/rtl/wrapper_mpeg2.hh"
+
+namespace gem5
+{
+namespace fpga
+{
+
+// idle RTL cycles after the last input before the worker goes to sleep
+#define VERILATOR_DRAIN_CYCLES 100000
+
+/**
+ * Emulated card whose IP is the Verilated Wrapper_mpeg2 model, decoded the
+ * same way ModuleIFS_Mpeg2.v does on the board; like the board, control
+ * tasks are not answered. The model is ticked on its own thread; decoded
+ * inputs are handed over through a queue and outputs are pushed into the
+ * emulated output buffer as they appear.
+ */
+class VerilatorTransport : public EmulatedTransport
+{
+  private:
+    Wrapper_mpeg2* m_wrapper;
+    bool           m_dumpWave;
+
+    inputMPEG2              m_regs;
+    std::deque<inputMPEG2>  m_inputs;
+    std::mutex              m_inputMTX;
+    std::condition_variable m_inputCV;
+    std::thread             m_worker;
+    bool                    m_workerDone;
+
+    void enqueue(const inputMPEG2& input);
+    void workerFunc();
+
+  protected:
+    void ipReset() override;
+    void ipTask(const PCIeCtrlTask& task) override;
+    void ipData(uint64_t addr, const uint8_t* beat) override;
+
+  public:
+    VerilatorTransport(bool dump_wave, int channel_num = 1);
+    ~VerilatorTransport();
+
+    void open() override;
+    void close() override;
+
+    std::string name() const override
+    {
+        return "verilator";
+    }
+};
+
+} // namespace fpga
+} // namespace gem5
+
+#endif
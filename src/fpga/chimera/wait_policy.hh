@@ -0,0 +1,140 @@
+#ifndef __FPGA_CHIMERA_WAIT_POLICY_HH__
+#define __FPGA_CHIMERA_WAIT_POLICY_HH__
+
+#include <sched.h>
+#include <stdint.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace gem5
+{
+namespace fpga
+{
+
+#define CHIMERA_DEFAULT_SPIN_COUNT  4096
+#define CHIMERA_DEFAULT_YIELD_COUNT 64
+#define CHIMERA_PARK_TIMEOUT_US     1000
+#define CHIMERA_BACKOFF_RETRY_COUNT 16
+#define CHIMERA_BACKOFF_MIN_NS      1000
+
+static inline void cpuRelax()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield" ::: "memory");
+#else
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+#endif
+}
+
+/**
+ * Spin-then-park wait used by the consumer side of a lock-free queue. The
+ * waiter first spins on its predicate, then yields, and only then parks on
+ * a condition variable. Producers call notify() after publishing; it costs
+ * a fence and a load unless somebody is actually parked, so a busy
+ * pipeline never touches the mutex.
+ */
+class AdaptiveWaiter
+{
+  private:
+    std::atomic<int>        m_sleepers;
+    std::mutex              m_mtx;
+    std::condition_variable m_cv;
+    unsigned                m_spinCount;
+    unsigned                m_yieldCount;
+
+  public:
+    AdaptiveWaiter(unsigned spin_count = CHIMERA_DEFAULT_SPIN_COUNT,
+                   unsigned yield_count = CHIMERA_DEFAULT_YIELD_COUNT) :
+        m_sleepers(0), m_spinCount(0), m_yieldCount(yield_count)
+    {
+        setSpinCount(spin_count);
+    }
+
+    void setSpinCount(unsigned spin_count)
+    {
+        // spinning only helps if the thread we wait for runs on another CPU
+        m_spinCount = std::thread::hardware_concurrency() > 1 ? spin_count : 0;
+    }
+
+    template <typename Pred>
+    void wait(Pred pred)
+    {
+        for (unsigned i = 0; i < m_spinCount; ++i) {
+            if (pred()) { return; }
+            cpuRelax();
+        }
+        for (unsigned i = 0; i < m_yieldCount; ++i) {
+            if (pred()) { return; }
+            sched_yield();
+        }
+        while (true) {
+            std::unique_lock<std::mutex> lock(m_mtx);
+            m_sleepers.fetch_add(1, std::memory_order_seq_cst);
+            if (pred()) {
+                m_sleepers.fetch_sub(1, std::memory_order_relaxed);
+                return;
+            }
+            // the timeout only bounds the damage of a predicate that is
+            // changed without a notify(), e.g. by a plain flag store
+            m_cv.wait_for(lock, std::chrono::microseconds(CHIMERA_PARK_TIMEOUT_US));
+            m_sleepers.fetch_sub(1, std::memory_order_relaxed);
+            if (pred()) { return; }
+        }
+    }
+
+    void notify()
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (m_sleepers.load(std::memory_order_relaxed) > 0) {
+            std::lock_guard<std::mutex> lock(m_mtx);
+            m_cv.notify_all();
+        }
+    }
+};
+
+/**
+ * Pacing for a thread that polls the card for results. After a few
+ * immediate retries, every empty poll doubles the pause before the next
+ * one, from CHIMERA_BACKOFF_MIN_NS up to the cap; a poll that returned
+ * something calls reset(). An idle card then costs a handful of reads per
+ * cap period rather than a core and a stream of PCIe reads. A cap of 0
+ * disables the backoff.
+ */
+class PollBackoff
+{
+  private:
+    uint64_t m_maxNs;
+    uint64_t m_periodNs;
+    unsigned m_retries;
+
+  public:
+    PollBackoff(uint64_t max_ns = 0) : m_maxNs(max_ns), m_periodNs(0), m_retries(0)
+    {
+    }
+
+    void reset()
+    {
+        m_periodNs = 0;
+        m_retries  = 0;
+    }
+
+    // ns to pause before the next poll, 0 to poll again right away
+    uint64_t next()
+    {
+        if (m_maxNs == 0 || m_retries++ < CHIMERA_BACKOFF_RETRY_COUNT) { return 0; }
+        m_periodNs = std::min<uint64_t>(m_periodNs ? 2 * m_periodNs : CHIMERA_BACKOFF_MIN_NS, m_maxNs);
+        return m_periodNs;
+    }
+};
+
+} // namespace fpga
+} // namespace gem5
+
+#endif
@@ -0,0 +1,186 @@
+#include "fpga/chimera/xdma_transport.hh"
+
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+#include "base/logging.hh"
+#include "base/trace.hh"
+#include "debug/FPGAEngine.hh"
+
+namespace gem5
+{
+namespace fpga
+{
+
+XDMATransport::XDMATransport(const std::string& device, int channel_num, bool use_uring, unsigned queue_depth,
+                             bool use_events) :
+    Transport(channel_num), m_device(device), m_writeEngineDevice(channel_num, -1),
+    m_readEngineDevice(channel_num, -1), m_useUring(use_uring), m_queueDepth(queue_depth), m_useEvents(use_events),
+    m_eventDevice(-1)
+{
+    assert(channel_num > 0 && channel_num <= XDMA_MAX_CHANNELS);
+}
+
+XDMATransport::~XDMATransport()
+{
+    close();
+}
+
+void XDMATransport::open()
+{
+    for (int i = 0; i < m_channelNum; ++i) {
+        std::string wstr       = m_device + "_h2c_" + std::to_string(i);
+        m_writeEngineDevice[i] = ::open(wstr.c_str(), O_RDWR);
+        if (m_writeEngineDevice[i] < 0) {
+            panic("*** ERROR: failed to open device %s\n", wstr);
+        } else {
+            DPRINTF(FPGAEngine, "SUCCESS: open write engine device %s\n", wstr);
+        }
+
+        std::string rstr      = m_device + "_c2h_" + std::to_string(i);
+        m_readEngineDevice[i] = ::open(rstr.c_str(), O_RDWR);
+        if (m_readEngineDevice[i] < 0) {
+            panic("*** ERROR: failed to open device %s\n", rstr);
+        } else {
+            DPRINTF(FPGAEngine, "SUCCESS: open read engine device %s\n", rstr);
+        }
+    }
+
+    if (m_useUring) { setupRings(); }
+    if (m_useEvents) { setupEvents(); }
+}
+
+void XDMATransport::setupEvents()
+{
+    std::string estr = m_device + "_events_0";
+    m_eventDevice    = ::open(estr.c_str(), O_RDONLY);
+    if (m_eventDevice < 0) {
+        warn("xdma: failed to open %s, falling back to polling for results\n", estr);
+    } else {
+        DPRINTF(FPGAEngine, "SUCCESS: open event device %s\n", estr);
+    }
+}
+
+void XDMATransport::setupRings()
+{
+    for (int i = 0; i < m_channelNum; ++i) {
+        UringEngine* ring = new UringEngine();
+        m_rings.push_back(ring);
+        if (!ring->init(m_queueDepth) || !ring->registerFiles({m_writeEngineDevice[i]})) {
+            warn("xdma: io_uring is unavailable, falling back to blocking transfers\n");
+            for (UringEngine* r : m_rings) { delete r; }
+            m_rings.clear();
+            return;
+        }
+    }
+    DPRINTF(FPGAEngine, "SUCCESS: io_uring set up on %d channels, queue depth %d\n", m_channelNum, m_queueDepth);
+}
+
+void XDMATransport::close()
+{
+    for (UringEngine* ring : m_rings) {
+        // the rings may still be writing from buffers we are about to free
+        std::vector<DMACompletion> done;
+        while (ring->inflight() > 0 && ring->reap(done, ring->inflight()) >= 0) {}
+        delete ring;
+    }
+    m_rings.clear();
+
+    if (m_eventDevice >= 0) {
+        ::close(m_eventDevice);
+        m_eventDevice = -1;
+    }
+
+    for (int i = 0; i < m_channelNum; ++i) {
+        if (m_writeEngineDevice[i] >= 0) {
+            ::close(m_writeEngineDevice[i]);
+            m_writeEngineDevice[i] = -1;
+        }
+        if (m_readEngineDevice[i] >= 0) {
+            ::close(m_readEngineDevice[i]);
+            m_readEngineDevice[i] = -1;
+        }
+    }
+}
+
+int64_t XDMATransport::write(uint64_t addr, uint64_t size, const void* msg, int channel)
+{
+    // pwrite keeps the seek and the transfer in one call, so the channels'
+    // file offsets never matter
+    return ::pwrite(m_writeEngineDevice[channel], msg, size, addr);
+}
+
+int64_t XDMATransport::read(uint64_t addr, uint64_t size, void* msg, int channel)
+{
+    return ::pread(m_readEngineDevice[channel], msg, size, addr);
+}
+
+int64_t XDMATransport::writev(uint64_t addr, const iovec* iov, int iovcnt, int channel)
+{
+    return ::pwritev(m_writeEngineDevice[channel], iov, iovcnt, addr);
+}
+
+void XDMATransport::submitWrite(uint64_t addr, uint64_t size, const void* msg, int channel, uint64_t tag)
+{
+    if (m_rings.empty()) { return Transport::submitWrite(addr, size, msg, channel, tag); }
+
+    UringEngine* ring = m_rings[channel];
+    while (!ring->prepWrite(0, msg, size, addr, tag, true)) {
+        // the ring is full, make room by waiting for the oldest write
+        if (ring->reap(m_completed[channel], 1) < 0) { panic("*** ERROR: io_uring failed on channel %d\n", channel); }
+    }
+}
+
+void XDMATransport::submitWritev(uint64_t addr, const iovec* iov, int iovcnt, int channel, uint64_t tag)
+{
+    if (m_rings.empty()) { return Transport::submitWritev(addr, iov, iovcnt, channel, tag); }
+
+    UringEngine* ring = m_rings[channel];
+    while (!ring->prepWritev(0, iov, iovcnt, addr, tag, true)) {
+        if (ring->reap(m_completed[channel], 1) < 0) { panic("*** ERROR: io_uring failed on channel %d\n", channel); }
+    }
+}
+
+void XDMATransport::flush(int channel)
+{
+    if (m_rings.empty()) { return; }
+    if (m_rings[channel]->submit() < 0) { panic("*** ERROR: io_uring submission failed on channel %d\n", channel); }
+}
+
+int XDMATransport::reap(int channel, std::vector<DMACompletion>& done, unsigned min_complete)
+{
+    int num = Transport::reap(channel, done, 0);
+    if (m_rings.empty()) { return num; }
+
+    int ret = m_rings[channel]->reap(done, num >= min_complete ? 0 : min_complete - num);
+    if (ret < 0) { panic("*** ERROR: io_uring failed on channel %d\n", channel); }
+    return num + ret;
+}
+
+bool XDMATransport::waitEvent(int channel, uint64_t timeout_ns)
+{
+    // the read blocks if another channel consumed the interrupt between our
+    // poll and read, so only one channel waits on it at a time
+    std::lock_guard<std::mutex> lock(m_eventMTX);
+
+    pollfd          pfd     = {m_eventDevice, POLLIN, 0};
+    struct timespec timeout = {(time_t)(timeout_ns / 1000000000), (long)(timeout_ns % 1000000000)};
+    if (ppoll(&pfd, 1, &timeout, nullptr) <= 0) { return false; }
+
+    // reading acknowledges the interrupt and returns how many were raised
+    uint32_t events = 0;
+    return ::read(m_eventDevice, &events, sizeof(events)) == sizeof(events) && events > 0;
+}
+
+void XDMATransport::registerBuffer(void* base, uint64_t size)
+{
+    for (UringEngine* ring : m_rings) {
+        if (!ring->registerBuffer(base, size)) {
+            warn_once("xdma: failed to register DMA buffers with io_uring (RLIMIT_MEMLOCK?)\n");
+        }
+    }
+}
+
+} // namespace fpga
+} // namespace gem5
@@ -0,0 +1,89 @@
+#ifndef __FPGA_CHIMERA_XDMA_TRANSPORT_HH__
+#define __FPGA_CHIMERA_XDMA_TRANSPORT_HH__
+
+#include <mutex>
+#include <vector>
+
+#include "fpga/chimera/transport.hh"
+
+namespace gem5
+{
+namespace fpga
+{
+
+/**
+ * Real board behind the Xilinx XDMA driver: one blocking pwrite on the H2C
+ * node and pread on the C2H node of the channel per transfer. A vectored
+ * write is one pwritev, which the driver maps into a single scatter-gather
+ * descriptor list.
+ *
+ * With io_uring enabled every channel also gets a submission ring with its
+ * H2C node and the registered buffers pinned in it, and submitWrite() keeps
+ * up to queue_depth writes in flight per channel. Writes queued between
+ * two flushes go to the kernel as one linked chain, so they stay in order
+ * without each waiting for the ring to drain. If the ring can't be set up
+ * the transport warns and stays on the blocking path.
+ *
+ * With events enabled it also opens the node of user interrupt 0
+ * (<device>_events_0), which the card raises while it holds results, and
+ * waitEvent() blocks on it. Results are not tied to a channel, so all
+ * channels share the one interrupt and take turns waiting on it.
+ */
+class XDMATransport : public Transport
+{
+  private:
+    std::string      m_device;
+    std::vector<int> m_writeEngineDevice;
+    std::vector<int> m_readEngineDevice;
+
+    bool                      m_useUring;
+    unsigned                  m_queueDepth;
+    std::vector<UringEngine*> m_rings;
+
+    bool       m_useEvents;
+    int        m_eventDevice;
+    std::mutex m_eventMTX;
+
+    void setupRings();
+    void setupEvents();
+
+  public:
+    XDMATransport(const std::string& device, int channel_num = 1, bool use_uring = false, unsigned queue_depth = 1,
+                  bool use_events = false);
+    ~XDMATransport();
+
+    void    open() override;
+    void    close() override;
+    int64_t write(uint64_t addr, uint64_t size, const void* msg, int channel) override;
+    int64_t read(uint64_t addr, uint64_t size, void* msg, int channel) override;
+
+    int64_t writev(uint64_t addr, const iovec* iov, int iovcnt, int channel) override;
+
+    void submitWrite(uint64_t addr, uint64_t size, const void* msg, int channel, uint64_t tag) override;
+    void submitWritev(uint64_t addr, const iovec* iov, int iovcnt, int channel, uint64_t tag) override;
+    void flush(int channel) override;
+    int  reap(int channel, std::vector<DMACompletion>& done, unsigned min_complete) override;
+    void registerBuffer(void* base, uint64_t size) override;
+
+    bool hasEvents() const override
+    {
+        return m_eventDevice >= 0;
+    }
+
+    bool waitEvent(int channel, uint64_t timeout_ns) override;
+
+    bool isAsync() const
+    {
+        return !m_rings.empty();
+    }
+
+    std::string name() const override
+    {
+        return "xdma";
+    }
+};
+
+} // namespace fpga
+} // namespace gem5
+
+#endif
@@ -1,38 +1,46 @@
 #include "fpga/mpeg2/mpeg2_encoder.hh"
 
+#include "sim/system.hh"
+
 namespace gem5
 {
 namespace fpga
 {
 
-Mpeg2Encoder::Mpeg2Encoder(const Mpeg2EncoderParams& p) : ClockedObject(p), m_chimera(p.chimera), m_enable_verilator(p.enable_verilator)
+Mpeg2Encoder::Mpeg2Encoder(const Mpeg2EncoderParams& p) :
+    ChimeraDevice(p), m_beatOffset(0), m_rtlClockRatio(p.rtl_clock_ratio), m_rtlCyclesPerEvent(p.rtl_cycles_per_event),
+    m_rtlQuantum(p.rtl_quantum), m_rtl(nullptr), m_waveWorkItem(p.wave_work_item),
+    m_enable_verilator(p.enable_verilator)
 {
-    m_cpu_side_port      = new Mpeg2EncoderCpuSidePort("Mpeg2Encoder.cpu_side_port", this);
-    m_wakeupEvent        = new EventFunctionWrapper([this] { wakeup(); }, "Wakeup Event");
-    m_retryCallbackEvent = new EventFunctionWrapper([this] { submit(); }, "RetryCallback Event");
-
-    m_local_data = 1;
-
-    m_local_node_ptr  = 0;
-    m_local_node_addr = 0;
-    m_local_node      = new uint8_t[TASK_DATA_SIZE];
+    fatal_if(m_rtlClockRatio == 0 || m_rtlCyclesPerEvent == 0 || m_rtlQuantum == 0,
+             "%s: RTL clock ratio, cycles per event and quantum must be positive\n", name());
 
-    m_stalling_packet = nullptr;
+    addRegister(0x0, 0x1, 0x2);
+    addRegister(0x8);
 
     if (m_enable_verilator) {
-        wr               = new Wrapper_mpeg2(p.dump_wave, "mpeg2_trace.vcd");
+        wr               = new Wrapper_mpeg2(p.dump_wave, waveConfig(p));
         m_buffer         = new uint8_t[0x200000];
         m_wptr           = 0;
         m_rptr           = 0;
         m_last_signal    = false;
         m_stop_verilator = false;
+        m_rtlCycles      = 0;
         m_VwakeupEvent   = new EventFunctionWrapper([this] { Vwakeup(); }, "Vwakeup Event");
-        schedule(m_VwakeupEvent, nextCycle());
+        if (p.rtl_thread) {
+            m_rtl         = new Mpeg2RtlThread(wr, m_rtlQuantum);
+            m_VsyncEvent  = new EventFunctionWrapper([this] { Vsync(); }, "Vsync Event");
+            m_syncing     = false;
+            m_rtlHorizon  = 0;
+            m_rtlLastPost = 0;
+        } else {
+            schedule(m_VwakeupEvent, nextCycle());
+        }
     } else {
         wr = nullptr;
+        fatal_if(!m_chimera, "%s: needs either a chimera engine or enable_verilator\n", name());
     }
 
-    m_enable_dataPlane_opt = p.enable_dataPlane_opt;
     if (m_enable_dataPlane_opt) {
         assert(!m_enable_verilator);
     }
@@ -40,257 +48,219 @@ Mpeg2Encoder::Mpeg2Encoder(const Mpeg2EncoderParams& p) : ClockedObject(p), m_ch
 
 Mpeg2Encoder::~Mpeg2Encoder()
 {
+    delete m_rtl;
 }
 
-Port& Mpeg2Encoder::getPort(const std::string& if_name, PortID idx)
+WaveConfig Mpeg2Encoder::waveConfig(const Mpeg2EncoderParams& p)
 {
-    if (if_name == "cpu_side_port")
-        return *m_cpu_side_port;
-    else
-        assert(false);
+    WaveConfig wave;
+    wave.m_file        = p.wave_file;
+    wave.m_depth       = p.wave_depth;
+    wave.m_postTrigger = p.wave_post_trigger;
+    wave.m_preTrigger  = p.wave_pre_trigger;
+    wave.m_external    = p.wave_work_item >= 0;
+
+    for (const std::string& spec : p.wave_scopes) {
+        std::pair<std::string, int> scope;
+        fatal_if(!WaveConfig::parseScope(spec, scope), "%s: malformed wave scope '%s', expected scope:depth\n",
+                 name(), spec);
+        wave.m_scopes.push_back(scope);
+    }
+    for (const std::string& spec : p.wave_windows) {
+        std::pair<uint64_t, uint64_t> window;
+        fatal_if(!WaveConfig::parseWindow(spec, window), "%s: malformed wave window '%s', expected start:end\n",
+                 name(), spec);
+        wave.m_windows.push_back(window);
+    }
+    fatal_if(!p.wave_trigger.empty() && !WaveTrigger::parse(p.wave_trigger, wave.m_trigger),
+             "%s: malformed wave trigger '%s', expected signal or signal=value\n", name(), p.wave_trigger);
+
+    return wave;
 }
-void Mpeg2Encoder::init()
+
+void Mpeg2Encoder::regProbeListeners()
 {
-    if (!m_cpu_side_port->isConnected()) fatal("Both ports of a bridge must be connected.\n");
+    if (!wr || m_waveWorkItem < 0) { return; }
+    ProbeManager* pm = m_system->getProbeManager();
+    m_listeners.emplace_back(new WorkItemListener(this, pm, "WorkItemBegin", true));
+    m_listeners.emplace_back(new WorkItemListener(this, pm, "WorkItemEnd", false));
+}
 
-    m_cpu_side_port->sendRangeChange();
+void Mpeg2Encoder::workItem(uint32_t workid, bool begin)
+{
+    if (workid != (uint32_t)m_waveWorkItem) { return; }
+    DPRINTF(Mpeg2Encoder, "work item %d %s, wave capture %s\n", workid, begin ? "begins" : "ends",
+            begin ? "starts" : "stops");
+    wr->requestCapture(begin);
+}
 
-    if (m_chimera) { m_chimera->setParent("mpeg2encoder", this); }
+bool Mpeg2Encoder::isDrained() const
+{
+    // the RTL thread must be idle, so the model can be saved from here
+    return ChimeraDevice::isDrained() && !(m_rtl && m_syncing);
 }
 
-void Mpeg2Encoder::retryCallback()
+void Mpeg2Encoder::serialize(CheckpointOut& cp) const
 {
-    if (m_data_nodes.size() > 0 && m_stop_signal.isValid()) {
-        submit();
+    ChimeraDevice::serialize(cp);
+    if (!m_enable_verilator) { return; }
+
+    fatal_if(!Wrapper_mpeg2::savable(),
+             "%s: the MPEG2 model was verilated with VERILATOR_THREADS > 1 and cannot be checkpointed\n", name());
+
+    std::string rtl_file = name() + ".rtl";
+    wr->save(CheckpointIn::dir() + "/" + rtl_file);
+    SERIALIZE_SCALAR(rtl_file);
+
+    SERIALIZE_SCALAR(m_wptr);
+    SERIALIZE_SCALAR(m_rptr);
+    arrayParamOut(cp, "m_buffer", m_buffer, m_wptr);
+    SERIALIZE_SCALAR(m_last_signal);
+    SERIALIZE_SCALAR(m_stop_verilator);
+    SERIALIZE_SCALAR(m_rtlCycles);
+    if (m_rtl) {
+        SERIALIZE_SCALAR(m_rtlHorizon);
+        SERIALIZE_SCALAR(m_rtlLastPost);
     }
+
+    // the unthreaded model keeps its own event while it is busy
+    bool wakeup_scheduled = m_VwakeupEvent->scheduled();
+    Tick wakeup_when      = wakeup_scheduled ? m_VwakeupEvent->when() : 0;
+    SERIALIZE_SCALAR(wakeup_scheduled);
+    SERIALIZE_SCALAR(wakeup_when);
 }
 
-void Mpeg2Encoder::submit()
+void Mpeg2Encoder::unserialize(CheckpointIn& cp)
 {
-    while (m_data_nodes.size() > 0) {
-        PCIeTask task;
-        task.setValid();
-        task.setDataType();
-        if (!m_chimera->isFullAndMark()) {
-            uint64_t send_addr = m_data_nodes.front().first;
-            uint8_t* sent_data = m_data_nodes.front().second;
-            task.m_addr        = send_addr;
-            task.m_size        = TASK_DATA_SIZE;
-            std::memcpy(&(task.m_content[0]), sent_data, TASK_DATA_SIZE);
-            assert(m_chimera->recvTask(task) != -1);
-            delete[] sent_data;
-            m_data_nodes.pop_front();
-        } else {
-            break;
-        }
+    ChimeraDevice::unserialize(cp);
+    if (!m_enable_verilator) { return; }
+
+    fatal_if(!Wrapper_mpeg2::savable(),
+             "%s: the MPEG2 model was verilated with VERILATOR_THREADS > 1 and cannot be restored\n", name());
+
+    std::string rtl_file;
+    UNSERIALIZE_SCALAR(rtl_file);
+    wr->restore(cp.getCptDir() + "/" + rtl_file);
+
+    UNSERIALIZE_SCALAR(m_wptr);
+    UNSERIALIZE_SCALAR(m_rptr);
+    arrayParamIn(cp, "m_buffer", m_buffer, m_wptr);
+    UNSERIALIZE_SCALAR(m_last_signal);
+    UNSERIALIZE_SCALAR(m_stop_verilator);
+    UNSERIALIZE_SCALAR(m_rtlCycles);
+    if (m_rtl) {
+        UNSERIALIZE_SCALAR(m_rtlHorizon);
+        UNSERIALIZE_SCALAR(m_rtlLastPost);
     }
 
-    if (m_data_nodes.size() == 0 && m_stop_signal.isValid()) {
-        assert(m_chimera->recvTask(m_stop_signal) != -1);
-        m_stop_signal.unsetValid();
+    bool wakeup_scheduled;
+    Tick wakeup_when;
+    UNSERIALIZE_SCALAR(wakeup_scheduled);
+    UNSERIALIZE_SCALAR(wakeup_when);
+    if (wakeup_scheduled) {
+        reschedule(m_VwakeupEvent, wakeup_when, true);
+    } else if (m_VwakeupEvent->scheduled()) {
+        deschedule(m_VwakeupEvent);
     }
 }
 
-void Mpeg2Encoder::wakeup()
+void Mpeg2Encoder::requestWakeup()
 {
-    if (m_pending_packets.size() > 0 && m_stalling_packet == nullptr) {
-        PacketPtr pkt = m_pending_packets.front();
-        if (pkt->isRead()) {
-            uint64_t config_addr = pkt->getAddr() - MPEG2_BASE_ADDR;
-            if (config_addr == 0x000000010) {
-                uint64_t size = pkt->getSize();
-                assert(size == 8);
-                uint8_t* new_data = new uint8_t[pkt->getSize()];
-                uint64_t value    = 0;
-                value |= 0x1;
-                value |= ((!m_chimera->CDMAStatus()) << 2);
-                value |= (m_chimera->CDMARemain() << 32);
-                std::memcpy(new_data, &value, sizeof(uint64_t));
-                pkt->setData(new_data);
-                delete[] new_data;
-            } else if (config_addr >= 0x010000000) {
-                uint8_t* new_data = new uint8_t[pkt->getSize()];
-                m_chimera->CDMAFetchData(new_data, pkt->getSize());
-                pkt->setData(new_data);
-                delete[] new_data;
-            } else {
-                assert(false);
-            }
-        } else if (pkt->isWrite()) {
-            uint64_t config_addr = pkt->getAddr() - MPEG2_BASE_ADDR;
-
-            if (config_addr >= 0x1000000) {
-                if (m_enable_dataPlane_opt) {
-                    std::memcpy(m_local_node + m_local_node_ptr, pkt->getPtr<uint8_t>(), pkt->getSize());
-
-                    if (m_local_node_ptr == 0) { m_local_node_addr = config_addr; }
-
-                    m_local_node_ptr += pkt->getSize();
-                    if (m_local_node_ptr == TASK_DATA_SIZE) {
-                        m_data_nodes.push_back(std::make_pair(m_local_node_addr, m_local_node));
-                        m_local_node      = new uint8_t[TASK_DATA_SIZE];
-                        m_local_node_ptr  = 0;
-                        m_local_node_addr = 0;
-
-                        submit();
-
-                    } else if (m_local_node_ptr > TASK_DATA_SIZE) {
-                        assert(false);
-                    }
-                } else {
-                    PCIeTask task;
-                    task.setValid();
-                    task.setWriteType();
-                    std::memcpy(&(task.m_content[0]), &config_addr, sizeof(uint64_t));
-
-                    assert(pkt->getSize() == 8);
-                    
-                    std::memcpy(&(task.m_content[8]), pkt->getPtr<uint8_t>(), pkt->getSize());
-
-                    while (true) {
-                        if (m_chimera->recvTask(task) != -1) {
-                            break;
-                        }
-                    }
-                }
-            } else {
-                PCIeTask task;
-                task.setValid();
-                task.setWriteType();
-                std::memcpy(&(task.m_content[0]), &config_addr, sizeof(uint64_t));
-                std::memcpy(
-                    &(task.m_content[8]), pkt->getPtr<uint8_t>(), pkt->getSize());
-                if (config_addr == 0x0 && (task.m_content[8] & 0x2)) {
-                    m_stop_signal = task;
-                    if (m_local_node_ptr > 0) {
-                        m_data_nodes.push_back(std::make_pair(m_local_node_addr, m_local_node));
-                        m_local_node      = new uint8_t[TASK_DATA_SIZE];
-                        m_local_node_ptr  = 0;
-                        m_local_node_addr = 0;
-                    }
-
-                    submit();
-                } else {
-                    if (config_addr == 0x0 && (task.m_content[8] & 0x1)) { m_chimera->enableCDMA(0x10000000, 0); }
-                    assert(m_chimera->recvTask(task) != -1);
-                }
-            }
-        } else {
-            assert(false);
-        }
-        pkt->makeTimingResponse();
-        if (m_cpu_side_port->sendTimingResp(pkt)) {
-        } else {
-            m_stalling_packet = pkt;
-        }
-
-        m_pending_packets.pop_front();
-
-        if (m_pending_packets.size() > 0 && !m_wakeupEvent->scheduled()) { schedule(m_wakeupEvent, nextCycle()); }
-    }
+    if (!m_enable_verilator) { return ChimeraDevice::requestWakeup(); }
+    if (!m_VwakeupEvent->scheduled()) { schedule(m_VwakeupEvent, nextCycle()); }
 }
 
-void Mpeg2Encoder::Vwakeup()
+bool Mpeg2Encoder::Vaccess(PacketPtr pkt, inputMPEG2& input)
 {
-    inputMPEG2  input;
-    outputMPEG2 output;
-    if (m_pending_packets.size() > 0 && m_stalling_packet == nullptr) {
-        PacketPtr pkt = m_pending_packets.front();
-        if (pkt->isRead()) {
-            uint64_t config_addr = pkt->getAddr() - MPEG2_BASE_ADDR;
-            if (config_addr == 0x000000010) {
-                uint64_t size = pkt->getSize();
-                assert(size == 8);
-                uint8_t* new_data = new uint8_t[pkt->getSize()];
-                uint64_t value    = 0;
-                value |= 0x1;
-                value |= (m_last_signal << 2);
-                value |= ((m_wptr - m_rptr) << 32);
-                std::memcpy(new_data, &value, sizeof(uint64_t));
-                pkt->setData(new_data);
-                delete[] new_data;
-            } else if (config_addr >= 0x010000000) {
-                uint8_t* new_data = new uint8_t[pkt->getSize()];
-
-                if (pkt->getSize() <= (m_wptr - m_rptr)) {
-                    std::memcpy(new_data, m_buffer + m_rptr, pkt->getSize());
-                    m_rptr += pkt->getSize();
-                    if (m_wptr == m_rptr) {
-                        m_wptr = 0;
-                        m_rptr = 0;
-                    }
-                } else {
-                    std::memset(new_data, 0, pkt->getSize());
-                }
-                pkt->setData(new_data);
-                delete[] new_data;
+    if (pkt->isRead()) {
+        uint64_t config_addr = pkt->getAddr() - m_pioAddr;
+        if (config_addr == m_statusReg) {
+            uint64_t size = pkt->getSize();
+            assert(size == 8);
+            uint8_t* new_data = new uint8_t[pkt->getSize()];
+            uint64_t value    = 0;
+            value |= 0x1;
+            value |= (m_last_signal << 2);
+            value |= ((m_wptr - m_rptr) << 32);
+            std::memcpy(new_data, &value, sizeof(uint64_t));
+            pkt->setData(new_data);
+            delete[] new_data;
+        } else if (config_addr >= m_outOffset) {
+            uint8_t* new_data = new uint8_t[pkt->getSize()];
+
+            if (pkt->getSize() <= (m_wptr - m_rptr)) {
+                readOutput(new_data, pkt->getSize());
             } else {
-                assert(false);
-            }
-        } else if (pkt->isWrite()) {
-            uint64_t config_addr = pkt->getAddr() - MPEG2_BASE_ADDR;
-            if (config_addr >= 0x1000000) {
-                std::memcpy(m_local_node + m_local_node_ptr, pkt->getPtr<uint8_t>(), pkt->getSize());
-
-                if (m_local_node_ptr == 0) { m_local_node_addr = config_addr; }
-
-                m_local_node_ptr += pkt->getSize();
-
-                input_cnt++;
-                if (m_local_node_ptr == 8) {
-                    m_local_node_ptr  = 0;
-                    m_local_node_addr = 0;
-
-                    input.i_en = 1;
-                    input.i_Y0 = m_local_node[0];
-                    input.i_U0 = m_local_node[1];
-                    input.i_Y1 = m_local_node[2];
-                    input.i_V0 = m_local_node[3];
-                    input.i_Y2 = m_local_node[4];
-                    input.i_U2 = m_local_node[5];
-                    input.i_Y3 = m_local_node[6];
-                    input.i_V2 = m_local_node[7];
-
-                } else if (m_local_node_ptr > 8) {
-                    assert(false);
-                }
-            } else if (config_addr == 0x0) {
-                uint64_t value = 0;
-                std::memcpy(&value, pkt->getPtr<uint8_t>(), pkt->getSize());
-                input.rstn          = value & 0x1;
-                input.sequence_stop = value & 0x2;
-
-                if ((value & 0x1) == 0) {
-                    m_last_signal    = false;
-                    m_stop_verilator = false;
-                }
-                if (value & 0x4) { m_stop_verilator = true; }
-
-            } else if (config_addr == 0x8) {
-                uint64_t value = 0;
-                std::memcpy(&value, pkt->getPtr<uint8_t>(), pkt->getSize());
-                input.xsize16 = static_cast<uint32_t>(value >> 32);
-                input.ysize16 = static_cast<uint32_t>(value);
-            } else {
-                assert(false);
+                std::memset(new_data, 0, pkt->getSize());
             }
+            pkt->setData(new_data);
+            delete[] new_data;
+        } else if (isDmaRegister(config_addr)) {
+            dmaRead(pkt, config_addr);
         } else {
             assert(false);
         }
+    } else if (pkt->isWrite()) {
+        uint64_t config_addr = pkt->getAddr() - m_pioAddr;
+        if (config_addr >= m_dataOffset) {
+            // a write-combined line is taken one 8-byte beat per RTL cycle
+            uint64_t beat = std::min<uint64_t>(pkt->getSize() - m_beatOffset, 8 - m_local_node_ptr);
+            std::memcpy(m_local_node + m_local_node_ptr, pkt->getPtr<uint8_t>() + m_beatOffset, beat);
+
+            if (m_local_node_ptr == 0) { m_local_node_addr = config_addr + m_beatOffset; }
+
+            m_local_node_ptr += beat;
+            m_beatOffset += beat;
+
+            input_cnt++;
+            if (m_local_node_ptr == 8) {
+                m_local_node_ptr  = 0;
+                m_local_node_addr = 0;
+
+                input.i_en = 1;
+                input.i_Y0 = m_local_node[0];
+                input.i_U0 = m_local_node[1];
+                input.i_Y1 = m_local_node[2];
+                input.i_V0 = m_local_node[3];
+                input.i_Y2 = m_local_node[4];
+                input.i_U2 = m_local_node[5];
+                input.i_Y3 = m_local_node[6];
+                input.i_V2 = m_local_node[7];
 
-        pkt->makeTimingResponse();
-        if (m_cpu_side_port->sendTimingResp(pkt)) {
+            }
+
+            if (m_beatOffset < pkt->getSize()) { return false; }
+            m_beatOffset = 0;
+        } else if (config_addr == 0x0) {
+            uint64_t value = 0;
+            std::memcpy(&value, pkt->getPtr<uint8_t>(), pkt->getSize());
+            input.rstn          = value & 0x1;
+            input.sequence_stop = value & 0x2;
+
+            if ((value & 0x1) == 0) {
+                m_last_signal    = false;
+                m_stop_verilator = false;
+            }
+            if (value & 0x4) { m_stop_verilator = true; }
+
+        } else if (config_addr == 0x8) {
+            uint64_t value = 0;
+            std::memcpy(&value, pkt->getPtr<uint8_t>(), pkt->getSize());
+            input.xsize16 = static_cast<uint32_t>(value >> 32);
+            input.ysize16 = static_cast<uint32_t>(value);
+        } else if (isDmaRegister(config_addr)) {
+            dmaWrite(pkt, config_addr);
         } else {
-            m_stalling_packet = pkt;
+            assert(false);
         }
-
-        m_pending_packets.pop_front();
-
-        if (m_pending_packets.size() > 0 && !m_VwakeupEvent->scheduled()) { schedule(m_VwakeupEvent, nextCycle()); }
+    } else {
+        assert(false);
     }
+    return true;
+}
 
-    output = wr->tick(input);
-
+void Mpeg2Encoder::Voutput(const outputMPEG2& output)
+{
     if (output.o_en) {
         assert(sizeof(output.o_data) == 32);
         std::memcpy(m_buffer + m_wptr, &(output.o_data), sizeof(output.o_data));
@@ -300,71 +270,182 @@ void Mpeg2Encoder::Vwakeup()
     }
 
     if (output.o_last) { m_last_signal = true; }
-
-    if (!m_stop_verilator) {
-        if (!m_VwakeupEvent->scheduled()) { schedule(m_VwakeupEvent, nextCycle()); }
-    }
+    if (output.o_en || output.o_last) { kickDma(); }
 }
 
-
-Mpeg2Encoder::Mpeg2EncoderCpuSidePort::Mpeg2EncoderCpuSidePort(const std::string& _name, Mpeg2Encoder* parent) :
-    ResponsePort(_name), m_parent(parent)
+uint64_t Mpeg2Encoder::outputAvailable()
 {
-    ranges.push_back(RangeSize(0x100000000, 512 * 1024 * 1024));
+    if (!m_enable_verilator) { return ChimeraDevice::outputAvailable(); }
+    return m_wptr - m_rptr;
 }
 
-Mpeg2Encoder::Mpeg2EncoderCpuSidePort::~Mpeg2EncoderCpuSidePort()
+void Mpeg2Encoder::readOutput(uint8_t* data, uint64_t size)
 {
+    if (!m_enable_verilator) { return ChimeraDevice::readOutput(data, size); }
+
+    assert(size <= m_wptr - m_rptr);
+    std::memcpy(data, m_buffer + m_rptr, size);
+    m_rptr += size;
+    if (m_wptr == m_rptr) {
+        m_wptr = 0;
+        m_rptr = 0;
+    }
 }
 
-bool Mpeg2Encoder::Mpeg2EncoderCpuSidePort::recvTimingReq(PacketPtr pkt)
+void Mpeg2Encoder::peekOutput(uint8_t* data, uint64_t size)
 {
-    DPRINTF(Mpeg2Encoder, "received req\n");
-    m_parent->m_pending_packets.push_back(pkt);
-    if (m_parent->m_enable_verilator) {
-        if (!m_parent->m_VwakeupEvent->scheduled()) { m_parent->schedule(m_parent->m_VwakeupEvent, m_parent->nextCycle()); }
+    if (!m_enable_verilator) { return ChimeraDevice::peekOutput(data, size); }
+
+    if (size <= m_wptr - m_rptr) {
+        std::memcpy(data, m_buffer + m_rptr, size);
     } else {
-        if (!m_parent->m_wakeupEvent->scheduled()) { m_parent->schedule(m_parent->m_wakeupEvent, m_parent->nextCycle()); }
+        std::memset(data, 0, size);
     }
-    return true;
 }
 
-void Mpeg2Encoder::Mpeg2EncoderCpuSidePort::recvRespRetry()
+bool Mpeg2Encoder::outputEnded()
 {
-    assert(m_parent->m_stalling_packet);
-    if (sendTimingResp(m_parent->m_stalling_packet)) {
-        m_parent->m_stalling_packet = nullptr;
-        if (m_parent->m_pending_packets.size() > 0 && !m_parent->m_wakeupEvent->scheduled()) {
-            m_parent->schedule(m_parent->m_wakeupEvent, m_parent->nextCycle());
-        }
-    } else {
-    }
+    if (!m_enable_verilator) { return ChimeraDevice::outputEnded(); }
+    return m_last_signal;
 }
 
-Tick Mpeg2Encoder::Mpeg2EncoderCpuSidePort::recvAtomic(PacketPtr pkt)
+void Mpeg2Encoder::Vwakeup()
 {
-    panic("not implemented\n");
+    if (m_rtl) { return VwakeupThreaded(); }
+
+    // each RTL cycle takes at most one request; the model counts as idle
+    // when no request came in, nothing came out and no sequence is being
+    // encoded, and it is not ticked again until the next request
+    wr->skipTo(curCycle() / m_rtlClockRatio);
+    bool active = false;
+    for (unsigned cycle = 0; cycle < m_rtlCyclesPerEvent; ++cycle) {
+        inputMPEG2 input;
+        bool       request = m_pending_packets.size() > 0 && m_stalling_packet == nullptr;
+        if (request) {
+            PacketPtr pkt = m_pending_packets.front();
+            if (Vaccess(pkt, input)) { respond(pkt); }
+        }
+
+        outputMPEG2 output = wr->tick(input);
+        m_rtlCycles++;
+        Voutput(output);
+
+        active = request || output.o_en || output.sequence_busy;
+        // a stopped model only takes the requests still queued
+        if (m_stop_verilator) { break; }
+    }
+
+    if (m_pending_packets.empty() && (m_stop_verilator || !active)) {
+        DPRINTF(Mpeg2Encoder, "RTL model idle after %d cycles\n", m_rtlCycles);
+        if (m_VwakeupEvent->scheduled()) { deschedule(m_VwakeupEvent); }
+        return;
+    }
+    // respond() may have asked for the next cycle already
+    Cycles next = m_stop_verilator ? Cycles(1) : Cycles(m_rtlCyclesPerEvent * m_rtlClockRatio);
+    reschedule(m_VwakeupEvent, clockEdge(next), true);
 }
 
-Tick Mpeg2Encoder::Mpeg2EncoderCpuSidePort::recvAtomicBackdoor(PacketPtr pkt, MemBackdoorPtr& backdoor)
+void Mpeg2Encoder::VwakeupThreaded()
 {
-    panic("not implemented\n");
+    if (m_pending_packets.empty() || m_stalling_packet != nullptr) { return; }
+    // the RTL thread is a window behind with its inputs; Vsync() comes
+    // back once it has taken some
+    if (!m_rtl->canPost()) { return; }
+
+    PacketPtr  pkt = m_pending_packets.front();
+    inputMPEG2 input;
+    bool       done = Vaccess(pkt, input);
+
+    if (pkt->isWrite()) { Vpost(input); }
+
+    if (done) {
+        respond(pkt);
+    } else {
+        requestWakeup();
+    }
 }
 
-void Mpeg2Encoder::Mpeg2EncoderCpuSidePort::recvFunctional(PacketPtr pkt)
+void Mpeg2Encoder::Vpost(const inputMPEG2& input)
 {
-    panic("not implemented\n");
+    if (!m_syncing) {
+        // the thread skipped the idle time, so time starts over now
+        m_rtlHorizon = std::max<uint64_t>(m_rtlHorizon, curCycle() / m_rtlClockRatio);
+    }
+    // one input per RTL cycle, and never inside the window the thread
+    // may already be evaluating
+    uint64_t cycle = std::max(m_rtlHorizon, m_rtlLastPost + 1);
+    m_rtl->post(cycle, input);
+    m_rtlLastPost = cycle;
+
+    if (!m_syncing) {
+        m_syncing = true;
+        m_rtlHorizon += m_rtlQuantum;
+        m_rtl->advance(m_rtlHorizon);
+        schedule(m_VsyncEvent, clockEdge(Cycles(m_rtlQuantum * m_rtlClockRatio)));
+    }
 }
 
-void Mpeg2Encoder::Mpeg2EncoderCpuSidePort::recvMemBackdoorReq(const MemBackdoorReq& req, MemBackdoorPtr& backdoor)
+Tick Mpeg2Encoder::atomicAccess(PacketPtr pkt)
 {
-    panic("not implemented\n");
+    if (!m_enable_verilator) { return ChimeraDevice::atomicAccess(pkt); }
+    panic_if(!m_pending_packets.empty(), "%s: atomic request with timing requests queued\n", name());
+
+    // a write goes into the model at once, one beat per RTL cycle; reads
+    // only look at its state. The model then runs on by itself as it does
+    // in timing mode
+    inputMPEG2 input;
+    bool       done = false;
+    while (!done) {
+        done = Vaccess(pkt, input);
+        if (!pkt->isWrite()) { break; }
+
+        if (m_rtl) {
+            // the request cannot wait for Vsync(): windows are closed
+            // early until there is room for the input
+            while (!m_rtl->canPost()) {
+                m_rtlHorizon = std::min(m_rtlHorizon + m_rtlQuantum, std::max(m_rtlHorizon, m_rtlLastPost + 1));
+                m_rtl->advance(m_rtlHorizon);
+                m_rtl->waitFor(m_rtlHorizon);
+
+                TimedOutputMPEG2 output;
+                while (m_rtl->popOutput(output)) { Voutput(output.m_output); }
+            }
+            Vpost(input);
+        } else {
+            wr->skipTo(curCycle() / m_rtlClockRatio);
+            outputMPEG2 output = wr->tick(input);
+            m_rtlCycles++;
+            Voutput(output);
+        }
+        input = inputMPEG2();
+    }
+    if (pkt->isWrite() && !m_rtl) { requestWakeup(); }
+
+    pkt->makeAtomicResponse();
+    return m_pioDelay;
 }
 
-AddrRangeList Mpeg2Encoder::Mpeg2EncoderCpuSidePort::getAddrRanges() const
+void Mpeg2Encoder::Vsync()
 {
-    return ranges;
+    // results of the window that just ended become visible now
+    m_rtl->waitFor(m_rtlHorizon);
+
+    TimedOutputMPEG2 output;
+    while (m_rtl->popOutput(output)) { Voutput(output.m_output); }
+
+    if (m_rtl->idle() && m_rtlLastPost < m_rtlHorizon && m_pending_packets.empty()) {
+        DPRINTF(Mpeg2Encoder, "RTL thread idle at cycle %d\n", m_rtlHorizon);
+        m_syncing = false;
+        checkDrained();
+        return;
+    }
+
+    m_rtlHorizon = std::max<uint64_t>(m_rtlHorizon, curCycle() / m_rtlClockRatio) + m_rtlQuantum;
+    m_rtl->advance(m_rtlHorizon);
+    schedule(m_VsyncEvent, clockEdge(Cycles(m_rtlQuantum * m_rtlClockRatio)));
+
+    if (!m_pending_packets.empty()) { requestWakeup(); }
 }
 
 } // namespace fpga
-} // namespace gem5
\ No newline at end of file
+} // namespace gem5
@@ -1,81 +1,120 @@
 #ifndef __FPGA_EXAMPLE_MPEG2_ENCODER_HH__
 #define __FPGA_EXAMPLE_MPEG2_ENCODER_HH__
 
+#include <memory>
+#include <vector>
+
 #include "params/Mpeg2Encoder.hh"
-#include "sim/clocked_object.hh"
-#include "mem/packet.hh"
-#include "mem/port.hh"
 #include "debug/Mpeg2Encoder.hh"
 
-#include "fpga/chimera/chimera.hh"
-#include "fpga/mpeg2/rtl/wrapper_mpeg2.hh"
+#include "sim/probe/probe.hh"
 
-#define MPEG2_BASE_ADDR 0x100000000
+#include "fpga/chimera/chimera_device.hh"
+#include "fpga/mpeg2/mpeg2_rtl_thread.hh"
+#include "fpga/mpeg2/rtl/wrapper_mpeg2.hh"
 
 namespace gem5
 {
 namespace fpga
 {
 
-class Mpeg2Encoder : public ClockedObject
+/**
+ * The MPEG2 encoder. Register 0x0 controls the IP (bit 0 releases reset
+ * and starts readback of the encoded stream, bit 1 ends the sequence) and
+ * register 0x8 holds the frame size. With enable_verilator the RTL is
+ * simulated in-process instead, ticked once per cycle.
+ *
+ * With dump_wave, the wave of the in-process model is captured in cycle
+ * windows, while an m5 work item runs, after a port signal condition, or
+ * otherwise for the whole run.
+ *
+ * The output DMA of ChimeraDevice drains the output buffer of the
+ * in-process model as well; it is kicked as soon as the model outputs.
+ *
+ * Checkpoints hold the in-process model (in a file of its own next to the
+ * checkpoint) and the output buffer. The threaded model drains once it is
+ * idle; the other one is saved as it is, busy or not.
+ */
+class Mpeg2Encoder : public ChimeraDevice
 {
-  protected:
-    class Mpeg2EncoderCpuSidePort : public ResponsePort
+  private:
+    class WorkItemListener : public ProbeListenerArgBase<uint32_t>
     {
       private:
         Mpeg2Encoder* m_parent;
-        AddrRangeList ranges;
+        bool          m_begin;
 
       public:
-        Mpeg2EncoderCpuSidePort(const std::string& _name, Mpeg2Encoder* parent);
-        ~Mpeg2EncoderCpuSidePort();
-        bool          recvTimingReq(PacketPtr pkt) override;
-        void          recvRespRetry() override;
-        Tick          recvAtomic(PacketPtr pkt) override;
-        Tick          recvAtomicBackdoor(PacketPtr pkt, MemBackdoorPtr& backdoor) override;
-        void          recvFunctional(PacketPtr pkt) override;
-        void          recvMemBackdoorReq(const MemBackdoorReq& req, MemBackdoorPtr& backdoor) override;
-        AddrRangeList getAddrRanges() const override;
+        WorkItemListener(Mpeg2Encoder* parent, ProbeManager* pm, const std::string& point, bool begin) :
+            ProbeListenerArgBase<uint32_t>(pm, point), m_parent(parent), m_begin(begin)
+        {
+        }
+        void notify(const uint32_t& workid) override
+        {
+            m_parent->workItem(workid, m_begin);
+        }
     };
 
-  private:
-    Chimera*                 m_chimera;
-    Mpeg2EncoderCpuSidePort* m_cpu_side_port;
-    uint8_t                  m_local_data;
-
-    uint8_t*                                 m_local_node;
-    uint64_t                                 m_local_node_addr;
-    uint64_t                                 m_local_node_ptr;
-    std::list<std::pair<uint64_t, uint8_t*>> m_data_nodes;
-
-    PCIeTask m_stop_signal;
-
     Wrapper_mpeg2* wr;
     uint8_t*       m_buffer;
     uint64_t       m_wptr;
     uint64_t       m_rptr;
     bool           m_last_signal;
     bool           m_stop_verilator;
-    bool           m_enable_dataPlane_opt;
 
+    // bytes of the data-plane write at the head of the queue the model has
+    // taken so far; write-combined lines take one 8-byte beat per RTL cycle
+    uint64_t m_beatOffset;
+
+    // device clock cycles per RTL clock cycle, and RTL cycles evaluated
+    // per Vwakeup event
+    unsigned m_rtlClockRatio;
+    unsigned m_rtlCyclesPerEvent;
+    uint64_t m_rtlCycles;
+
+    // with rtl_thread, the model runs on m_rtl up to m_rtlHorizon and is
+    // synchronised with every rtl_quantum RTL cycles while it is busy
+    unsigned              m_rtlQuantum;
+    Mpeg2RtlThread*       m_rtl;
+    EventFunctionWrapper* m_VsyncEvent;
+    bool                  m_syncing;
+    uint64_t              m_rtlHorizon;
+    uint64_t              m_rtlLastPost;
+
+    // captures the wave while work item m_waveWorkItem runs on m_system
+    int                                         m_waveWorkItem;
+    std::vector<std::unique_ptr<ProbeListener>> m_listeners;
+
+    WaveConfig waveConfig(const Mpeg2EncoderParams& p);
+    void       workItem(uint32_t workid, bool begin);
+
+    uint64_t outputAvailable() override;
+    void     readOutput(uint8_t* data, uint64_t size) override;
+    void     peekOutput(uint8_t* data, uint64_t size) override;
+    bool     outputEnded() override;
+
+    // false while beats of the write are left
+    bool Vaccess(PacketPtr pkt, inputMPEG2& input);
+    void Voutput(const outputMPEG2& output);
+    void VwakeupThreaded();
+    void Vpost(const inputMPEG2& input);
+    void Vsync();
+
+    Tick atomicAccess(PacketPtr pkt) override;
 
   public:
     bool                  m_enable_verilator;
-    EventFunctionWrapper* m_wakeupEvent;
-    EventFunctionWrapper* m_retryCallbackEvent;
-    std::list<PacketPtr>  m_pending_packets;
-    PacketPtr             m_stalling_packet;
-
     EventFunctionWrapper* m_VwakeupEvent;
     void                  Vwakeup();
 
     Mpeg2Encoder(const Mpeg2EncoderParams& p);
     ~Mpeg2Encoder();
-    void  retryCallback();
-    void  wakeup();
-    void  init() override;
-    void  submit();
-    Port& getPort(const std::string& if_name, PortID idx = InvalidPortID) override;
+    void requestWakeup() override;
+    void regProbeListeners() override;
+
+    bool isDrained() const override;
+    void serialize(CheckpointOut& cp) const override;
+    void unserialize(CheckpointIn& cp) override;
 
     uint64_t input_cnt  = 0;
     uint64_t output_cnt = 0;
@@ -84,4 +123,4 @@ class Mpeg2Encoder : public ClockedObject
 } // namespace fpga
 } // namespace gem5
 
-#endif
\ No newline at end of file
+#endif
@@ -1,22 +1,37 @@
 from ast import Param
 from m5.params import *
 from m5.proxy import *
-from m5.objects.ClockedObject import ClockedObject
-from m5.objects.Chimera import Chimera
+from m5.objects.ChimeraDevice import ChimeraDevice
 
-# FPGAEngine need to be assgined address ranges.
-
-class Mpeg2Encoder(ClockedObject):
+class Mpeg2Encoder(ChimeraDevice):
     type = 'Mpeg2Encoder'
     cxx_header = "fpga/mpeg2/mpeg2_encoder.hh"
     cxx_class = 'gem5::fpga::Mpeg2Encoder'
 
-    chimera = Param.Chimera("pcie engine")
     enable_verilator = Param.Bool(False, "whether to enable verilator simulation")
     dump_wave = Param.Bool(False, "whether to dump wave from verilator")
-
-    cpu_side_port = ResponsePort(
-        "This port receives requests and sends responses"
-    )
-
-    enable_dataPlane_opt = Param.Bool(True, "")
\ No newline at end of file
+    wave_file = Param.String("mpeg2_trace.fst", "FST file the wave is "
+        "dumped to; windowed and triggered captures are numbered after it")
+    wave_depth = Param.Unsigned(99, "hierarchy levels dumped")
+    wave_scopes = VectorParam.String([], "hierarchy levels dumped below a "
+        "scope, as scope:depth")
+    wave_windows = VectorParam.String([], "RTL cycle windows captured, as "
+        "start:end")
+    wave_trigger = Param.String("", "port signal condition that starts a "
+        "capture, as signal or signal=value (e.g. o_last)")
+    wave_post_trigger = Param.UInt64(1000, "RTL cycles captured after the "
+        "trigger condition last held")
+    wave_pre_trigger = Param.UInt64(0, "RTL cycles kept from before each "
+        "capture starts; 0 keeps none")
+    wave_work_item = Param.Int(-1, "capture while the m5 work item with "
+        "this ID runs (m5_work_begin/m5_work_end); -1 for none")
+    rtl_clock_ratio = Param.Unsigned(1, "device clock cycles per RTL "
+        "clock cycle of the Verilator model")
+    rtl_cycles_per_event = Param.Unsigned(1, "RTL cycles the Verilator "
+        "model evaluates per simulator event; requests arriving in between "
+        "wait for the next event")
+    rtl_thread = Param.Bool(False, "run the Verilator model on a thread "
+        "of its own, a quantum ahead of the simulation")
+    rtl_quantum = Param.Unsigned(1000, "RTL cycles between synchronisations "
+        "with the RTL thread; writes take effect and outputs become visible "
+        "at quantum boundaries")
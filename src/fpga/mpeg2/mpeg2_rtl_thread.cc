@@ -0,0 +1,81 @@
+#include "fpga/mpeg2/mpeg2_rtl_thread.hh"
+
+namespace gem5
+{
+namespace fpga
+{
+
+Mpeg2RtlThread::Mpeg2RtlThread(Wrapper_mpeg2* wrapper, uint64_t window) :
+    m_wrapper(wrapper), m_inputs(2 * window + 1), m_outputs(2 * window + 1), m_horizon(0),
+    m_cycle(0), m_quiescent(true), m_done(false)
+{
+    m_worker = std::thread(&Mpeg2RtlThread::workerFunc, this);
+}
+
+Mpeg2RtlThread::~Mpeg2RtlThread()
+{
+    m_done.store(true, std::memory_order_release);
+    m_workWaiter.notify();
+    m_worker.join();
+}
+
+void Mpeg2RtlThread::post(uint64_t cycle, const inputMPEG2& input)
+{
+    assert(cycle >= m_horizon.load(std::memory_order_relaxed));
+    [[maybe_unused]] bool posted = m_inputs.enqueue({cycle, input});
+    assert(posted);
+}
+
+void Mpeg2RtlThread::advance(uint64_t horizon)
+{
+    assert(horizon >= m_horizon.load(std::memory_order_relaxed));
+    m_horizon.store(horizon, std::memory_order_release);
+    m_workWaiter.notify();
+}
+
+void Mpeg2RtlThread::waitFor(uint64_t cycle)
+{
+    m_syncWaiter.wait([this, cycle] { return m_cycle.load(std::memory_order_acquire) >= cycle; });
+}
+
+void Mpeg2RtlThread::workerFunc()
+{
+    uint64_t cycle = 0;
+
+    while (true) {
+        m_workWaiter.wait([this, &cycle] {
+            return m_horizon.load(std::memory_order_acquire) > cycle || m_done.load(std::memory_order_acquire);
+        });
+        if (m_done.load(std::memory_order_acquire)) { break; }
+
+        uint64_t horizon = m_horizon.load(std::memory_order_acquire);
+        while (cycle < horizon) {
+            TimedInputMPEG2 next;
+            bool            hasInput = !m_inputs.isEmpty() && m_inputs.peek().m_cycle == cycle;
+            if (hasInput) {
+                next = m_inputs.dequeue();
+            } else if (m_quiescent.load(std::memory_order_relaxed)) {
+                // nothing would change; jump to the next input or the horizon
+                cycle = m_inputs.isEmpty() ? horizon : std::min(m_inputs.peek().m_cycle, horizon);
+                m_wrapper->skipTo(cycle);
+                m_cycle.store(cycle, std::memory_order_release);
+                continue;
+            }
+
+            outputMPEG2 output = m_wrapper->tick(hasInput ? next.m_input : inputMPEG2());
+            if (output.o_en || output.o_last) {
+                // drained by the simulation thread before it opens the
+                // next window, so this only waits if it is behind
+                while (!m_outputs.enqueue({cycle, output})) { cpuRelax(); }
+            }
+            m_quiescent.store(!hasInput && !output.o_en && !output.sequence_busy, std::memory_order_relaxed);
+
+            cycle++;
+            m_cycle.store(cycle, std::memory_order_release);
+        }
+        m_syncWaiter.notify();
+    }
+}
+
+} // namespace fpga
+} // namespace gem5
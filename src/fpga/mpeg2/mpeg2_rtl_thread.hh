@@ -0,0 +1,86 @@
+#ifndef __FPGA_MPEG2_MPEG2_RTL_THREAD_HH__
+#define __FPGA_MPEG2_MPEG2_RTL_THREAD_HH__
+
+#include <atomic>
+#include <thread>
+
+#include "fpga/chimera/ringBuffer.hh"
+#include "fpga/chimera/wait_policy.hh"
+#include "fpga/mpeg2/rtl/wrapper_mpeg2.hh"
+
+namespace gem5
+{
+namespace fpga
+{
+
+struct TimedInputMPEG2 {
+    uint64_t   m_cycle;
+    inputMPEG2 m_input;
+};
+
+struct TimedOutputMPEG2 {
+    uint64_t    m_cycle;
+    outputMPEG2 m_output;
+};
+
+/**
+ * Runs the Verilated MPEG2 model on a thread of its own, a bounded window
+ * ahead of the simulation. The simulation thread posts inputs stamped with
+ * the RTL cycle they apply in and moves the horizon forward; the worker
+ * evaluates every cycle before the horizon and queues the outputs, stamped
+ * the same way. Inputs are always stamped at or past the horizon the
+ * worker has been given, so where the worker is never changes what it
+ * computes. Cycles with no input on a quiescent model (no output, no
+ * sequence being encoded) are skipped rather than evaluated.
+ *
+ * The queues are sized for two windows: the outputs of one window are
+ * drained before the next one is opened.
+ */
+class Mpeg2RtlThread
+{
+  private:
+    Wrapper_mpeg2* m_wrapper;
+
+    RingBuffer<TimedInputMPEG2>  m_inputs;
+    RingBuffer<TimedOutputMPEG2> m_outputs;
+
+    std::atomic<uint64_t> m_horizon;
+    std::atomic<uint64_t> m_cycle;
+    std::atomic<bool>     m_quiescent;
+    std::atomic<bool>     m_done;
+    AdaptiveWaiter        m_workWaiter;
+    AdaptiveWaiter        m_syncWaiter;
+    std::thread           m_worker;
+
+    void workerFunc();
+
+  public:
+    Mpeg2RtlThread(Wrapper_mpeg2* wrapper, uint64_t window);
+    ~Mpeg2RtlThread();
+
+    // simulation-thread side
+    bool canPost()
+    {
+        return !m_inputs.isFull();
+    }
+    void post(uint64_t cycle, const inputMPEG2& input);
+    void advance(uint64_t horizon);
+    void waitFor(uint64_t cycle);
+    bool popOutput(TimedOutputMPEG2& output)
+    {
+        return m_outputs.tryDequeue(output);
+    }
+
+    // the worker has evaluated everything it was given and the model is
+    // quiescent
+    bool idle()
+    {
+        return m_cycle.load(std::memory_order_acquire) >= m_horizon.load(std::memory_order_relaxed)
+            && m_quiescent.load(std::memory_order_acquire);
+    }
+};
+
+} // namespace fpga
+} // namespace gem5
+
+#endif
@@ -50,6 +50,7 @@ struct inputMPEG2 {
 struct outputMPEG2 {
     uint64_t o_en;
     uint64_t o_last;
+    uint64_t sequence_busy;
     uint32_t o_data[8];
 };
 
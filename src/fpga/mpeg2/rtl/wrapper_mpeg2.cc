@@ -1,18 +1,96 @@
 #include "wrapper_mpeg2.hh"
 
-Wrapper_mpeg2::Wrapper_mpeg2(bool traceOn, std::string name) : tickcount(0), fst(NULL), fstname(name), traceOn(traceOn)
+#include <cstdio>
+
+namespace
+{
+
+bool parseNumber(const std::string& text, uint64_t& value)
+{
+    if (text.empty()) { return false; }
+    char* end = nullptr;
+    value     = std::strtoull(text.c_str(), &end, 0);
+    return *end == '\0';
+}
+
+} // anonymous namespace
+
+bool WaveTrigger::parse(const std::string& spec, WaveTrigger& trigger)
+{
+    static const std::pair<const char*, Signal> signals[] = {
+        {"rstn", RSTN},
+        {"i_en", I_EN},
+        {"sequence_stop", SEQUENCE_STOP},
+        {"sequence_busy", SEQUENCE_BUSY},
+        {"o_en", O_EN},
+        {"o_last", O_LAST},
+    };
+
+    size_t      eq   = spec.find('=');
+    std::string name = spec.substr(0, eq);
+
+    trigger.m_signal = NONE;
+    for (const auto& signal : signals) {
+        if (name == signal.first) { trigger.m_signal = signal.second; }
+    }
+    if (trigger.m_signal == NONE) { return false; }
+
+    trigger.m_any = eq == std::string::npos;
+    return trigger.m_any || parseNumber(spec.substr(eq + 1), trigger.m_value);
+}
+
+bool WaveConfig::parseScope(const std::string& spec, std::pair<std::string, int>& scope)
+{
+    size_t   colon = spec.rfind(':');
+    uint64_t depth = 0;
+    if (colon == std::string::npos || colon == 0 || !parseNumber(spec.substr(colon + 1), depth)) { return false; }
+    scope = {spec.substr(0, colon), (int)depth};
+    return true;
+}
+
+bool WaveConfig::parseWindow(const std::string& spec, std::pair<uint64_t, uint64_t>& window)
+{
+    size_t colon = spec.find(':');
+    if (colon == std::string::npos) { return false; }
+    return parseNumber(spec.substr(0, colon), window.first) && parseNumber(spec.substr(colon + 1), window.second)
+           && window.first < window.second;
+}
+
+Wrapper_mpeg2::Wrapper_mpeg2(bool traceOn, std::string name) :
+    Wrapper_mpeg2(traceOn, [&name] {
+        WaveConfig wave;
+        wave.m_file = name;
+        return wave;
+    }())
+{
+}
+
+Wrapper_mpeg2::Wrapper_mpeg2(bool traceOn, const WaveConfig& wave) :
+    tickcount(0), fst(NULL), fstname(wave.m_file), traceOn(traceOn), wave(wave), capturing(false), captures(0),
+    triggerEnd(0), external(false), captureRequest(-1), segmentStart(0), segment(0)
 {
     top = new Vtop();
 
     if (traceOn) {
+#if VM_TRACE
         Verilated::traceEverOn(traceOn);
-        fst = new VerilatedVcdC();
+        fst = new VerilatedFstC();
         if (!fst) { return; }
 
-        top->trace(fst, 99);
+        for (const auto& scope : wave.m_scopes) { fst->dumpvars(scope.second, scope.first); }
+        top->trace(fst, wave.m_depth);
 
-        std::cout << fstname << std::endl;
-        fst->open(fstname.c_str());
+        if (captureAll()) {
+            openTrace(fstname);
+            capturing = true;
+        } else if (wave.m_preTrigger > 0) {
+            openTrace(captureName(".seg0"));
+        }
+#else
+        std::cerr << "warn: the MPEG2 model was verilated without tracing (build with VERILATOR_VARIANT=trace), "
+                  << fstname << " will not be written" << std::endl;
+        this->traceOn = false;
+#endif
     } else {
         fst = nullptr;
     }
@@ -20,11 +98,12 @@ Wrapper_mpeg2::Wrapper_mpeg2(bool traceOn, std::string name) : tickcount(0), fst
 
 Wrapper_mpeg2::~Wrapper_mpeg2()
 {
+#if VM_TRACE
     if (fst) {
-        fst->dump(tickcount);
-        fst->close();
+        closeTrace();
         delete fst;
     }
+#endif
 
     top->final();
     delete top;
@@ -32,6 +111,129 @@ Wrapper_mpeg2::~Wrapper_mpeg2()
     exit(EXIT_SUCCESS);
 }
 
+bool Wrapper_mpeg2::captureAll() const
+{
+    return wave.m_windows.empty() && wave.m_trigger.m_signal == WaveTrigger::NONE && !wave.m_external;
+}
+
+std::string Wrapper_mpeg2::captureName(const std::string& suffix) const
+{
+    // mpeg2_trace.fst -> mpeg2_trace<suffix>.fst
+    size_t dot = fstname.find_last_of('.');
+    if (dot == std::string::npos || fstname.find('/', dot) != std::string::npos) { return fstname + suffix; }
+    return fstname.substr(0, dot) + suffix + fstname.substr(dot);
+}
+
+void Wrapper_mpeg2::openTrace(const std::string& file)
+{
+#if VM_TRACE
+    fst->open(file.c_str());
+#endif
+}
+
+void Wrapper_mpeg2::closeTrace()
+{
+#if VM_TRACE
+    if (fst && fst->isOpen()) {
+        fst->dump(tickcount);
+        fst->close();
+    }
+#endif
+}
+
+void Wrapper_mpeg2::requestCapture(bool on)
+{
+    captureRequest.store(on, std::memory_order_release);
+}
+
+void Wrapper_mpeg2::updateCapture()
+{
+    if (!fst || !traceOn || captureAll()) { return; }
+
+    uint64_t cycle   = tickcount / 2;
+    int      request = captureRequest.exchange(-1, std::memory_order_acquire);
+    if (request >= 0) { external = request; }
+
+    bool want = external || cycle < triggerEnd;
+    for (const auto& window : wave.m_windows) { want = want || (cycle >= window.first && cycle < window.second); }
+
+    std::string number = "." + std::to_string(captures);
+    if (want && !capturing) {
+        if (wave.m_preTrigger > 0) {
+            // keep what led up to the capture
+            closeTrace();
+            std::rename(captureName(".seg" + std::to_string(segment ^ 1)).c_str(),
+                        captureName(number + ".pre0").c_str());
+            std::rename(captureName(".seg" + std::to_string(segment)).c_str(),
+                        captureName(number + ".pre1").c_str());
+        }
+        openTrace(captureName(number));
+        capturing = true;
+    } else if (!want && capturing) {
+        closeTrace();
+        capturing = false;
+        captures++;
+        if (wave.m_preTrigger > 0) {
+            segment      = 0;
+            segmentStart = cycle;
+            std::remove(captureName(".seg1").c_str());
+            openTrace(captureName(".seg0"));
+        }
+    } else if (!capturing && wave.m_preTrigger > 0 && cycle - segmentStart >= wave.m_preTrigger) {
+        // the older segment is overwritten
+        closeTrace();
+        segment ^= 1;
+        segmentStart = cycle;
+        openTrace(captureName(".seg" + std::to_string(segment)));
+    }
+}
+
+void Wrapper_mpeg2::checkTrigger()
+{
+    const WaveTrigger& trigger = wave.m_trigger;
+    if (!fst || !traceOn || trigger.m_signal == WaveTrigger::NONE) { return; }
+
+    uint64_t value = 0;
+    switch (trigger.m_signal) {
+        case WaveTrigger::RSTN: value = top->rstn; break;
+        case WaveTrigger::I_EN: value = top->i_en; break;
+        case WaveTrigger::SEQUENCE_STOP: value = top->sequence_stop; break;
+        case WaveTrigger::SEQUENCE_BUSY: value = top->sequence_busy; break;
+        case WaveTrigger::O_EN: value = top->o_en; break;
+        case WaveTrigger::O_LAST: value = top->o_last; break;
+        default: return;
+    }
+
+    if (trigger.m_any ? value != 0 : value == trigger.m_value) {
+        triggerEnd = tickcount / 2 + 1 + wave.m_postTrigger;
+    }
+}
+
+void Wrapper_mpeg2::save(const std::string& file)
+{
+#if VM_SAVABLE
+    VerilatedSave os;
+    os.open(file.c_str());
+    os << tickcount << *top;
+    os.close();
+#endif
+}
+
+void Wrapper_mpeg2::restore(const std::string& file)
+{
+#if VM_SAVABLE
+    VerilatedRestore os;
+    os.open(file.c_str());
+    os >> tickcount >> *top;
+    os.close();
+#endif
+}
+
+void Wrapper_mpeg2::skipTo(uint64_t cycle)
+{
+    if (2 * cycle > tickcount) { tickcount = 2 * cycle; }
+}
+
 void Wrapper_mpeg2::enableTracing()
 {
     traceOn = true;
@@ -40,12 +242,13 @@ void Wrapper_mpeg2::enableTracing()
 void Wrapper_mpeg2::disableTracing()
 {
     traceOn = false;
-    fst->dump(tickcount);
-    fst->close();
+    closeTrace();
 }
 
 void Wrapper_mpeg2::tick()
 {
+    updateCapture();
+
     top->clk = 1;
     top->eval();
 
@@ -54,11 +257,13 @@ void Wrapper_mpeg2::tick()
     top->clk = 0;
     top->eval();
 
+    checkTrigger();
     advanceTickCount();
 }
 
 outputMPEG2 Wrapper_mpeg2::tick(inputMPEG2 in)
 {
+    updateCapture();
     processInput(in);
 
     top->clk = 1;
@@ -69,6 +274,7 @@ outputMPEG2 Wrapper_mpeg2::tick(inputMPEG2 in)
     top->clk = 0;
     top->eval();
 
+    checkTrigger();
     advanceTickCount();
 
     return processOutput();
@@ -99,8 +305,9 @@ outputMPEG2 Wrapper_mpeg2::processOutput()
 {
     outputMPEG2 out;
 
-    out.o_en   = top->o_en;
-    out.o_last = top->o_last;
+    out.o_en          = top->o_en;
+    out.o_last        = top->o_last;
+    out.sequence_busy = top->sequence_busy;
 
     std::memcpy(out.o_data, top->o_data, sizeof(top->o_data));
 
@@ -109,7 +316,9 @@ outputMPEG2 Wrapper_mpeg2::processOutput()
 
 void Wrapper_mpeg2::advanceTickCount()
 {
-    if (fst and traceOn) { fst->dump(tickcount); }
+#if VM_TRACE
+    if (fst and traceOn and fst->isOpen()) { fst->dump(tickcount); }
+#endif
     tickcount++;
 }
 
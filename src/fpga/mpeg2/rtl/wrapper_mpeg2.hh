@@ -1,20 +1,78 @@
 #ifndef __FPGA_MPEG2_RTL_WRAPER_MPEG2_HH__
 #define __FPGA_MPEG2_RTL_WRAPER_MPEG2_HH__
 
+#include <atomic>
 #include <cstdlib>
 #include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
 
 #include "Vtop.h"
 
 #include "verilated.h"
-#include "verilated_vcd_c.h"
+#ifndef VM_SAVABLE
+#define VM_SAVABLE 0
+#endif
+#if VM_SAVABLE
+#include "verilated_save.h"
+#endif
+#if VM_TRACE
+#include "verilated_fst_c.h"
+#else
+// models verilated without --trace-fst cannot dump waveforms
+class VerilatedFstC;
+#endif
 
 #include "rtl_packet_mpeg2.hh"
 
+/**
+ * A port-level signal condition that starts a capture, e.g. "o_last" (the
+ * signal is set) or "sequence_busy=0".
+ */
+struct WaveTrigger {
+    enum Signal { NONE, RSTN, I_EN, SEQUENCE_STOP, SEQUENCE_BUSY, O_EN, O_LAST };
+
+    Signal   m_signal = NONE;
+    bool     m_any    = true;
+    uint64_t m_value  = 0;
+
+    static bool parse(const std::string& spec, WaveTrigger& trigger);
+};
+
+/**
+ * What the waveform captures. Times are RTL cycles. Without windows, a
+ * trigger or external control, the whole run is captured into m_file;
+ * otherwise every capture goes to a file of its own, numbered in order
+ * (mpeg2_trace.fst -> mpeg2_trace.0.fst, ...).
+ *
+ * With m_preTrigger, the cycles before a capture are traced too, into two
+ * alternating segment files of that many cycles each. When a capture
+ * starts, both are kept next to it (.pre0 the older, .pre1 the newer), so
+ * at least the last m_preTrigger cycles before the event are there.
+ */
+struct WaveConfig {
+    std::string m_file  = "mpeg2_trace.fst";
+    int         m_depth = 99;
+    // depth per scope, e.g. {"top.mpeg2encoder_i", 1}
+    std::vector<std::pair<std::string, int>> m_scopes;
+    // [start, end) windows
+    std::vector<std::pair<uint64_t, uint64_t>> m_windows;
+    WaveTrigger m_trigger;
+    uint64_t    m_postTrigger = 1000;
+    uint64_t    m_preTrigger  = 0;
+    // captures are started and stopped with requestCapture()
+    bool        m_external = false;
+
+    static bool parseScope(const std::string& spec, std::pair<std::string, int>& scope);
+    static bool parseWindow(const std::string& spec, std::pair<uint64_t, uint64_t>& window);
+};
+
 class Wrapper_mpeg2
 {
   public:
     Wrapper_mpeg2(bool traceOn, std::string name);
+    Wrapper_mpeg2(bool traceOn, const WaveConfig& wave);
     ~Wrapper_mpeg2();
 
     void        tick();
@@ -27,12 +85,46 @@ class Wrapper_mpeg2
     void        processInput(inputMPEG2 in);
     outputMPEG2 processOutput();
 
+    // the model was not ticked up to this RTL cycle because nothing
+    // changed; keeps the waveform time in RTL cycles
+    void skipTo(uint64_t cycle);
+
+    // starts or stops an externally controlled capture at the next cycle
+    // the model evaluates. Safe to call from a thread other than the one
+    // ticking the model
+    void requestCapture(bool on);
+
+    // the model state and cycle count, for checkpoints. Only models
+    // verilated with --savable (single-threaded ones) can be saved
+    static bool savable()
+    {
+        return VM_SAVABLE;
+    }
+    void save(const std::string& file);
+    void restore(const std::string& file);
+
   private:
     Vtop*          top;
     uint64_t       tickcount;
-    VerilatedVcdC* fst;
+    VerilatedFstC* fst;
     std::string    fstname;
     bool           traceOn;
+
+    WaveConfig       wave;
+    bool             capturing;
+    int              captures;
+    uint64_t         triggerEnd;
+    bool             external;
+    std::atomic<int> captureRequest;
+    uint64_t         segmentStart;
+    int              segment;
+
+    bool        captureAll() const;
+    std::string captureName(const std::string& suffix) const;
+    void        updateCapture();
+    void        checkTrigger();
+    void        openTrace(const std::string& file);
+    void        closeTrace();
 };
 
 #endif // !__FPGA_MPEG2_RTL_WRAPER_MPEG2_HH__
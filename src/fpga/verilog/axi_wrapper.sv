@@ -6,6 +6,7 @@ module axi_wrapper #(
     parameter TASK_SIZE           = 144,
     parameter RESULT_SIZE         = 88,
     parameter COUNTER_WIDTH       = 64,
+    parameter IBUFFER_DEPTH       = 20,
     parameter WBUFFER_WIDTH       = 16+TASK_SIZE*MAX_BATCH_THRESHOLD,
     parameter RBUFFER_WIDTH       = 16+RESULT_SIZE*MAX_BATCH_THRESHOLD,
     parameter MAX_RBEAT           = (RBUFFER_WIDTH-1)/AXI_DWIDTH+1
@@ -59,7 +60,8 @@ module axi_wrapper #(
     // user_rstn
     output wire user_rstn,
 
-    input [COUNTER_WIDTH-1 : 0] counter_in
+    input [COUNTER_WIDTH-1 : 0] counter_in,
+    input [63:0] ibuffer_consumed
     );
     
 // AXI WRITE state machine
@@ -236,6 +238,14 @@ parameter R_NOP = 2'b11;
 
 reg [1:0] rstate;
 
+// capability block read at 0x3000, laid out as ChimeraCaps on the host.
+// The batch field of a request is 4 bits wide, and the output buffer is as
+// deep as the input buffer
+localparam CAPS_MAX_BATCH = (MAX_BATCH_THRESHOLD > 15) ? 15 : MAX_BATCH_THRESHOLD;
+wire [255:0] caps_block = {ibuffer_consumed, 32'b0, 16'(RESULT_SIZE), 16'(TASK_SIZE), 32'(IBUFFER_DEPTH),
+                           32'(IBUFFER_DEPTH), 16'(CAPS_MAX_BATCH), 16'd1, 32'h43484d52};
+reg caps_read;
+
 reg [3:0] rid;
 reg [7:0] rcount;
 
@@ -266,6 +276,7 @@ always @(posedge clk or negedge rstn) begin
         read_counter <= 0;
         read_toal_len <= 0;
         test_pointer <= 0;
+        caps_read <= 1'b0;
     end else begin
         if (wstate == W_IDLE && s_axi_awvalid && s_axi_awaddr == 64'h1000) begin
             rstate  <= R_IDLE;
@@ -277,6 +288,7 @@ always @(posedge clk or negedge rstn) begin
             rbeat_ptr <= 0;
             read_counter <= 0;
             read_toal_len <= 0;
+            caps_read <= 1'b0;
         end
         
         case (rstate) 
@@ -290,7 +302,11 @@ always @(posedge clk or negedge rstn) begin
                     s_axi_rdata <= 0;
 
                     // note
-                    if (rbeat_ptr == 0) begin
+                    if (rbeat_ptr == 0 && s_axi_araddr == 64'h3000) begin
+                        rbuffer <= caps_block;
+                        caps_read <= 1'b1;
+                        rstate <= R_NOP;
+                    end else if (rbeat_ptr == 0) begin
                         rbuffer <= 0;
                         rbatch_ptr <= 0;
                         test_pointer <= 1;
@@ -345,13 +361,14 @@ always @(posedge clk or negedge rstn) begin
                         s_axi_rdata <= 'b0;
                         read_counter <= 1'b0;
 
-                        if (rbeat_ptr * AXI_DWIDTH >= RBUFFER_WIDTH) begin
+                        if (caps_read || rbeat_ptr * AXI_DWIDTH >= RBUFFER_WIDTH) begin
                             rbeat_ptr <= 0;
                             rbuffer <= 0;
+                            caps_read <= 1'b0;
                         end
                     end else begin
                         if (read_counter < read_toal_len) begin
-                            if (rcount == 8'd1)
+                            if (rcount == 8'd1 && !caps_read)
                                 s_axi_rdata <= rbuffer[rbeat_ptr * AXI_DWIDTH +: (RBUFFER_WIDTH-(MAX_RBEAT-1)*AXI_DWIDTH)];
                             else
                                 s_axi_rdata <= rbuffer[rbeat_ptr * AXI_DWIDTH +: AXI_DWIDTH];
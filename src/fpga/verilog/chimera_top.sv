@@ -42,7 +42,10 @@ module chimera_top #(
     output wire s_axi_rlast,
     output wire [AXI_DWIDTH - 1:0] s_axi_rdata,
     output wire [3:0]  s_axi_rid,
-    output wire [1:0]  s_axi_rresp
+    output wire [1:0]  s_axi_rresp,
+
+    // XDMA user interrupt 0, held while results wait in the output buffer
+    output wire usr_irq_req
     );
 
 wire [TASK_SIZE - 1 : 0]      axi2ibufferData;
@@ -60,15 +63,19 @@ wire                          module2obufferValid;
 wire [RESULT_SIZE - 1 : 0]    module2obufferData;
 
 wire [COUNTER_WIDTH - 1 : 0]  runtimeCount;
+wire [63 : 0]                 ibufferConsumed;
 
 wire user_rstn;
 
+assign usr_irq_req = obuffer2axiRemaining;
+
 axi_wrapper #(
     MAX_BATCH_THRESHOLD,
     AXI_DWIDTH,
     TASK_SIZE,
     RESULT_SIZE,
-    COUNTER_WIDTH
+    COUNTER_WIDTH,
+    IBUFFER_SIZE
 ) axi_wrapper_instance (
     .clk(clk),
     .rstn(rstn),
@@ -112,7 +119,8 @@ axi_wrapper #(
     
     .user_rstn(user_rstn),
 
-    .counter_in(runtimeCount)
+    .counter_in(runtimeCount),
+    .ibuffer_consumed(ibufferConsumed)
 );
 
 input_buffer #(
@@ -126,7 +134,8 @@ input_buffer #(
 
     .ready_in(module2ibufferReady),
     .valid_out(ibuffer2ModuleValid),
-    .data_out(ibuffer2ModuleData)
+    .data_out(ibuffer2ModuleData),
+    .consumed(ibufferConsumed)
 );
 
 output_buffer #(
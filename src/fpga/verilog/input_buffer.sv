@@ -11,7 +11,10 @@ module input_buffer#(
 
     input wire                     ready_in,
     output reg                     valid_out,
-    output wire [TASK_SIZE - 1 : 0] data_out
+    output wire [TASK_SIZE - 1 : 0] data_out,
+
+    // slots handed to the module since reset, reported to the host
+    output reg [63:0]              consumed
     );
 
 // input buffer
@@ -58,6 +61,7 @@ always @(posedge clk or negedge rstn) begin
         last_iread_ptr <= 5'b00000;
         iwrite_ptr <= 0;
         ibuffer_valid <= 'b0;
+        consumed <= 64'b0;
     end else begin
         if (valid_in) begin
             ibuffer_valid[iwrite_ptr +: 1] <= 1'b1;
@@ -89,6 +93,7 @@ always @(posedge clk or negedge rstn) begin
                 rstate <= R_IDLE;
                 valid_out <= 1'b0;
                 ibuffer_valid[iread_ptr] <= 1'b0;
+                consumed <= consumed + 64'b1;
                 iread_ptr = (iread_ptr == IBUFFER_DEPTH - 1) ? 5'b00000 : iread_ptr + 5'b1;
             end
             default: 
@@ -97,15 +97,13 @@ void EmulationPageTable::unmap(Addr vaddr, int64_t size)
 {
     assert(pageOffset(vaddr) == 0);
 
-    // modified for mpeg2 encoder
-    if (vaddr >= 0x100000000 && vaddr < 0x100000000 + 512 * 1024 * 1024) return;
-
     DPRINTF(MMU, "Unmapping page: %#x-%#x\n", vaddr, vaddr + size);
 
     while (size > 0) {
         auto it = pTable.find(vaddr);
         assert(it != pTable.end());
-        pTable.erase(it);
+        // device windows stay mapped for the life of the process
+        if (!(it->second.flags & Device)) pTable.erase(it);
         size -= _pageSize;
         vaddr += _pageSize;
     }
@@ -122,6 +120,14 @@ bool EmulationPageTable::isUnmapped(Addr vaddr, int64_t size)
     return true;
 }
 
+Request::FlagsType EmulationPageTable::requestFlags(uint64_t flags)
+{
+    Request::FlagsType req_flags = 0;
+    if (flags & Uncacheable) req_flags |= Request::UNCACHEABLE;
+    if (flags & StrictOrder) req_flags |= Request::STRICT_ORDER;
+    return req_flags;
+}
+
 const EmulationPageTable::Entry* EmulationPageTable::lookup(Addr vaddr)
 {
     Addr      page_addr = pageAlign(vaddr);
@@ -144,10 +150,16 @@ bool EmulationPageTable::translate(Addr vaddr, Addr& paddr)
 
 Fault EmulationPageTable::translate(const RequestPtr& req)
 {
-    Addr paddr;
     assert(pageAlign(req->getVaddr() + req->getSize() - 1) == pageAlign(req->getVaddr()));
-    if (!translate(req->getVaddr(), paddr)) return Fault(new GenericPageTableFault(req->getVaddr()));
+    const Entry* entry = lookup(req->getVaddr());
+    if (!entry) {
+        DPRINTF(MMU, "Couldn't Translate: %#x\n", req->getVaddr());
+        return Fault(new GenericPageTableFault(req->getVaddr()));
+    }
+    Addr paddr = pageOffset(req->getVaddr()) + entry->paddr;
+    DPRINTF(MMU, "Translating: %#x->%#x\n", req->getVaddr(), paddr);
     req->setPaddr(paddr);
+    req->setFlags(requestFlags(entry->flags));
     if ((paddr & (_pageSize - 1)) + req->getSize() > _pageSize) {
         panic("Request spans page boundaries!\n");
         return NoFault;
@@ -92,14 +92,25 @@ class EmulationPageTable : public Serializable
      * bit 0 - no-clobber | clobber
      * bit 2 - cacheable  | uncacheable
      * bit 3 - read-write | read-only
+     * bit 4 - reorderable | strictly ordered
+     * bit 5 - memory     | device window, left mapped by unmap()
      */
     enum MappingFlags : uint32_t
     {
         Clobber     = 1,
         Uncacheable = 4,
         ReadOnly    = 8,
+        StrictOrder = 16,
+        Device      = 32,
     };
 
+    /**
+     * The request flags the attributes of a mapping impose on the accesses
+     * to it.
+     * @param flags Mapping flags of a page table entry.
+     */
+    static Request::FlagsType requestFlags(uint64_t flags);
+
     // flag which marks the page table as shared among software threads
     bool shared;
 
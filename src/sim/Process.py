@@ -65,6 +65,9 @@ class Process(SimObject):
     cwd = Param.String(getcwd(), "current working directory")
     simpoint = Param.UInt64(0, "simulation point at which to start simulation")
     drivers = VectorParam.EmulatedDriver([], "Available emulated drivers")
+    device_windows = VectorParam.DeviceWindow(
+        [], "device windows mapped into the address space"
+    )
     release = Param.String("5.1.0", "Linux kernel uname release")
 
     @classmethod
@@ -78,3 +81,24 @@ class EmulatedDriver(SimObject):
     cxx_class = "gem5::EmulatedDriver"
     abstract = True
     filename = Param.String("device file name (under /dev)")
+
+
+class DeviceWindow(SimObject):
+    type = "DeviceWindow"
+    cxx_header = "sim/device_window.hh"
+    cxx_class = "gem5::DeviceWindow"
+    vaddr = Param.Addr("virtual address the window is mapped at")
+    paddr = Param.Addr(Self.vaddr, "physical address of the window")
+    size = Param.Addr("size of the window, a multiple of the page size")
+    uncacheable = Param.Bool(True, "accesses bypass the caches")
+    strictly_ordered = Param.Bool(
+        True,
+        "accesses have side effects and are never made "
+        "speculatively or out of order",
+    )
+    write_combine = Param.Bool(
+        False,
+        "stores may be merged before they reach the device; "
+        "the configuration gives the window's physical range to the "
+        "CPUs' write_combine_ranges",
+    )
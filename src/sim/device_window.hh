@@ -0,0 +1,55 @@
+#ifndef __SIM_DEVICE_WINDOW_HH__
+#define __SIM_DEVICE_WINDOW_HH__
+
+#include "base/logging.hh"
+#include "base/types.hh"
+#include "mem/page_table.hh"
+#include "params/DeviceWindow.hh"
+#include "sim/sim_object.hh"
+
+namespace gem5
+{
+
+/**
+ * A window of device registers or memory that an SE-mode process sees at
+ * a fixed virtual address, declared by the configuration. The process maps
+ * it into its page table when it is created; its attributes are kept in
+ * the page table entries, so translation applies them to every access with
+ * no lookup of its own, and munmap() of the window leaves it mapped.
+ */
+class DeviceWindow : public SimObject
+{
+  public:
+    const Addr vaddr;
+    const Addr paddr;
+    const Addr size;
+    const bool uncacheable;
+    const bool strictlyOrdered;
+    const bool writeCombine;
+
+    DeviceWindow(const DeviceWindowParams &p)
+        : SimObject(p), vaddr(p.vaddr), paddr(p.paddr), size(p.size),
+          uncacheable(p.uncacheable), strictlyOrdered(p.strictly_ordered),
+          writeCombine(p.write_combine)
+    {
+        fatal_if(strictlyOrdered && !uncacheable,
+                 "%s: a strictly ordered window must be uncacheable.",
+                 name());
+    }
+
+    /** The page table flags the window is mapped with. */
+    uint64_t
+    mappingFlags() const
+    {
+        uint64_t flags = EmulationPageTable::Device;
+        if (uncacheable)
+            flags |= EmulationPageTable::Uncacheable;
+        if (strictlyOrdered)
+            flags |= EmulationPageTable::StrictOrder;
+        return flags;
+    }
+};
+
+} // namespace gem5
+
+#endif // __SIM_DEVICE_WINDOW_HH__
@@ -80,9 +80,6 @@ void MemState::resetOwner(Process* owner)
 
 bool MemState::isUnmapped(Addr start_addr, Addr length)
 {
-    // modified for mpeg2 encoder
-    if (start_addr >= 0x100000000 && start_addr < 0x100000000 + 512 * 1024 * 1024) return true;
-
     Addr            end_addr = start_addr + length;
     const AddrRange range(start_addr, end_addr);
     for (const auto& vma : _vmaList) {
@@ -92,9 +89,12 @@ bool MemState::isUnmapped(Addr start_addr, Addr length)
     /**
      * In case someone skips the VMA interface and just directly maps memory
      * also consult the page tables to make sure that this memory isnt mapped.
+     * Device windows are mapped that way on purpose; the program may map
+     * them again to get at them.
      */
     for (auto start = start_addr; start < end_addr; start += _pageBytes) {
-        if (_ownerProcess->pTable->lookup(start) != nullptr) {
+        const EmulationPageTable::Entry* entry = _ownerProcess->pTable->lookup(start);
+        if (entry != nullptr && !(entry->flags & EmulationPageTable::Device)) {
             panic(
                 "Someone allocated physical memory at VA %p without "
                 "creating a VMA!\n",
@@ -59,6 +59,7 @@
 #include "mem/page_table.hh"
 #include "mem/se_translating_port_proxy.hh"
 #include "params/Process.hh"
+#include "sim/device_window.hh"
 #include "sim/emul_driver.hh"
 #include "sim/fd_array.hh"
 #include "sim/fd_entry.hh"
@@ -127,6 +128,7 @@ Process::Process(const ProcessParams& params, EmulationPageTable* pTable, loader
     _ppid(params.ppid),
     _pgid(params.pgid),
     drivers(params.drivers),
+    deviceWindows(params.device_windows),
     fds(std::make_shared<FDArray>(params.input, params.output, params.errout)),
     childClearTID(0),
     ADD_STAT(numSyscalls, statistics::units::Count::get(), "Number of system calls")
@@ -158,12 +160,12 @@ Process::Process(const ProcessParams& params, EmulationPageTable* pTable, loader
 
     if (loader::debugSymbolTable.empty()) loader::debugSymbolTable = objFile->symtab();
 
-    // used for mpeg2 encoder
-    Addr     vaddr = 0x100000000;
-    Addr     paddr = 0x100000000;
-    uint64_t size  = 512 * 1024 * 1024; // 512MB
-
-    pTable->map(vaddr, paddr, size, EmulationPageTable::Uncacheable);
+    for (const DeviceWindow* window : deviceWindows) {
+        fatal_if(pTable->pageOffset(window->vaddr) || pTable->pageOffset(window->paddr) ||
+                     pTable->pageOffset(window->size),
+                 "Device window %s is not page aligned.", window->name());
+        pTable->map(window->vaddr, window->paddr, window->size, window->mappingFlags());
+    }
 }
 
 void Process::clone(ThreadContext* otc, ThreadContext* ntc, Process* np, RegVal flags)
@@ -201,6 +203,8 @@ void Process::clone(ThreadContext* otc, ThreadContext* ntc, Process* np, RegVal
 
         for (auto map : mappings) {
             Addr paddr, vaddr = map.first;
+            // the new process has mapped its device windows itself
+            if (pTable->lookup(vaddr)->flags & EmulationPageTable::Device) continue;
             bool alloc_page = !(np->pTable->translate(vaddr, paddr));
             np->replicatePage(vaddr, paddr, otc, ntc, alloc_page);
         }
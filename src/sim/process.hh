@@ -56,6 +56,7 @@ class ObjectFile;
 
 struct ProcessParams;
 
+class DeviceWindow;
 class EmulatedDriver;
 class EmulationPageTable;
 class SEWorkload;
@@ -283,6 +284,9 @@ class Process : public SimObject
     // Emulated drivers available to this process
     std::vector<EmulatedDriver *> drivers;
 
+    // Device windows mapped into the address space
+    std::vector<DeviceWindow *> deviceWindows;
+
     std::shared_ptr<FDArray> fds;
 
     bool *exitGroup;
@@ -373,9 +373,20 @@ System::regStats()
     }
 }
 
+void
+System::regProbePoints()
+{
+    ppWorkItemBegin = new ProbePointArg<uint32_t>(getProbeManager(),
+                                                  "WorkItemBegin");
+    ppWorkItemEnd = new ProbePointArg<uint32_t>(getProbeManager(),
+                                                "WorkItemEnd");
+}
+
 void
 System::workItemEnd(uint32_t tid, uint32_t workid)
 {
+    ppWorkItemEnd->notify(workid);
+
     std::pair<uint32_t,uint32_t> p(tid, workid);
     if (!lastWorkItemStarted.count(p))
         return;
@@ -59,6 +59,7 @@
 #include "mem/port_proxy.hh"
 #include "params/System.hh"
 #include "sim/futex_map.hh"
+#include "sim/probe/probe.hh"
 #include "sim/redirect_path.hh"
 #include "sim/se_signal.hh"
 #include "sim/sim_object.hh"
@@ -546,10 +547,17 @@ class System : public SimObject, public PCEventScope
     {
         std::pair<uint32_t, uint32_t> p(tid, workid);
         lastWorkItemStarted[p] = curTick();
+        ppWorkItemBegin->notify(workid);
     }
 
     void workItemEnd(uint32_t tid, uint32_t workid);
 
+    /** Probe points notified with the work ID of m5 work items. */
+    ProbePointArg<uint32_t> *ppWorkItemBegin = nullptr;
+    ProbePointArg<uint32_t> *ppWorkItemEnd = nullptr;
+
+    void regProbePoints() override;
+
     /* Returns whether we successfully trapped into GDB. */
     bool trapToGdb(GDBSignal signal, ContextID ctx_id) const;
 
@@ -9,6 +9,10 @@
 #define MPEG2_RESET_AND_SEQUENCE_CONTROL 0x000000000
 #define MPEG2_VIDEO_FRAME_SIZE 0x000000008
 #define MPEG2_OUT_BUF_CONTROL 0x000000010
+#define MPEG2_DMA_ADDR 0x000000020
+#define MPEG2_DMA_SIZE 0x000000028
+#define MPEG2_DMA_STATUS_ADDR 0x000000030
+#define MPEG2_DMA_CONTROL 0x000000038
 #define MPEG2_BASE_IN_PIXELS 0x010000000
 #define MPEG2_BASE_OUT_BUF 0x010000000
 
@@ -79,12 +83,29 @@ void mpeg2encoder_get_outbuf(uint8_t* buffer, int* overflow, int* size)
     *size = local_ptr;
 }
 
+// has the device write the output into buffer and the status word into
+// memory, instead of reading it back 8 bytes at a time
+void mpeg2encoder_get_outbuf_dma(uint8_t* buffer, int* overflow, int* size)
+{
+    static volatile uint64_t status;
+    status = 0;
+    writeReg(MPEG2_DMA_ADDR, reinterpret_cast<uint64_t>(buffer));
+    writeReg(MPEG2_DMA_SIZE, OUT_BUF_SIZE);
+    writeReg(MPEG2_DMA_STATUS_ADDR, reinterpret_cast<uint64_t>(&status));
+    writeReg(MPEG2_DMA_CONTROL, 0x1);
+    while (!(status & 0x1)) {} // complete flag
+
+    *overflow = (status & 0x2) ? 1 : 0;
+    *size     = static_cast<int>(status >> 32);
+}
+
 int main(int argc, char* argv[])
 {
-    if (argc < 2) {
-        std::cerr << "Usage: " << argv[0] << " <string_argument>" << std::endl;
+    if (argc < 3) {
+        std::cerr << "Usage: " << argv[0] << " <in.raw> <out.m2v> [dma]" << std::endl;
         return 1;
     }
+    bool use_dma = argc > 3 && std::strcmp(argv[3], "dma") == 0;
 
     static uint8_t in_buffer[IN_BUF_SIZE];
     static uint8_t out_buffer[OUT_BUF_SIZE];
@@ -147,7 +168,11 @@ int main(int argc, char* argv[])
 
         if (feof(in_fp) || acc_read_file_size >= 0x600000) { mpeg2encoder_set_sequence_stop(); }
 
-        mpeg2encoder_get_outbuf(out_buffer, &out_overflow, &out_len);
+        if (use_dma) {
+            mpeg2encoder_get_outbuf_dma(out_buffer, &out_overflow, &out_len);
+        } else {
+            mpeg2encoder_get_outbuf(out_buffer, &out_overflow, &out_len);
+        }
 
         std::cout << "overflow var value: " << out_overflow << std::endl;
 
@@ -0,0 +1,213 @@
+/*
+ * Compares the ways Chimera can stream the data plane of a device into a
+ * credited card (src/fpga/chimera/chimera.cc). For each it reports the
+ * writes a transfer takes, the throughput and how often the host had to
+ * wait for credits:
+ *
+ *   tasks   - 64-byte data tasks, batched as collectBatch() does: at most
+ *             MAX_BATCH_THRESHOLD tasks and never more than the input
+ *             buffer per write.
+ *   fixed   - bulk chunks of half the input buffer, each waiting for its
+ *             credits (what issueBulk() did before the window).
+ *   window  - bulk chunks taking every slot free when they are issued, at
+ *             least half the buffer, with the drained count asked for
+ *             after each chunk (issueBulk() now).
+ *
+ * The card is a model: its input buffer of depth slots drains one
+ * CHIMERA_DATA_BEAT_SIZE beat at a time at the given rate while it holds
+ * data, and a credit refresh reads its drained count without a transfer.
+ * The writes go to a memfd (or a file given on the command line) standing
+ * in for the H2C node, one pwritev of 4 KiB segments per bulk chunk as the
+ * bulk pool hands them out.
+ *
+ * Build with "make" in this directory, run as
+ *   ./bulk_bench [path|memfd] [depth] [drain MB/s] [transfer size] [transfers]
+ */
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "fpga/chimera/common.hh"
+
+using Clock = std::chrono::steady_clock;
+
+#define BENCH_SEGMENT 4096
+
+static uint64_t nowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+}
+
+// input buffer of the card, drained at a fixed rate whenever it holds data
+struct CardModel {
+    uint64_t m_depth;
+    double   m_slotsPerNs;
+    uint64_t m_received = 0; // slots written to the card
+    double   m_drained  = 0;
+    uint64_t m_last     = 0;
+
+    void receive(uint64_t slots)
+    {
+        drain();
+        m_received += slots;
+        if (m_received - (uint64_t)m_drained > m_depth) {
+            std::fprintf(stderr, "the input buffer overflowed\n");
+            std::exit(1);
+        }
+    }
+
+    uint64_t drain()
+    {
+        uint64_t now = nowNs();
+        m_drained    = std::min<double>(m_received, m_drained + (now - m_last) * m_slotsPerNs);
+        m_last       = now;
+        return (uint64_t)m_drained;
+    }
+};
+
+// the host side of the credits, as Chimera keeps them
+struct Credits {
+    CardModel& m_card;
+    uint64_t   m_issued   = 0;
+    uint64_t   m_consumed = 0;
+    uint64_t   m_stalls   = 0;
+
+    uint64_t free()
+    {
+        return m_card.m_depth - (m_issued - m_consumed);
+    }
+
+    void take(uint64_t slots)
+    {
+        if (slots > free()) { m_stalls++; }
+        while (slots > free()) { m_consumed = m_card.drain(); }
+        m_issued += slots;
+    }
+};
+
+static void report(const char* mode, uint64_t count, uint64_t size, uint64_t writes, uint64_t stalls,
+                   uint64_t elapsed)
+{
+    std::printf("%-7s %8.1f writes/transfer %8.1f MB/s %8.1f credit stalls/transfer\n", mode, (double)writes / count,
+                (double)count * size * 1e3 / elapsed, (double)stalls / count);
+}
+
+static void writeOrDie(int fd, const iovec* iov, int iovcnt, uint64_t size, uint64_t off)
+{
+    if (pwritev(fd, iov, iovcnt, off) != (int64_t)size) {
+        std::perror("pwritev");
+        std::exit(1);
+    }
+}
+
+static void runTasks(int fd, uint8_t* buf, uint64_t depth, double rate, uint64_t count, uint64_t size)
+{
+    CardModel card{depth, rate};
+    Credits   credits{card};
+    uint64_t  taskSlots = TASK_DATA_SIZE / CHIMERA_DATA_BEAT_SIZE;
+    uint64_t  batch     = std::max<uint64_t>(std::min<uint64_t>(MAX_BATCH_THRESHOLD, depth / taskSlots), 1);
+    uint64_t  writes    = 0;
+
+    card.m_last    = nowNs();
+    uint64_t start = card.m_last;
+    for (uint64_t i = 0; i < count; ++i) {
+        for (uint64_t off = 0; off < size;) {
+            uint64_t bytes = std::min(batch * TASK_DATA_SIZE, size - off);
+            uint64_t slots = (bytes + CHIMERA_DATA_BEAT_SIZE - 1) / CHIMERA_DATA_BEAT_SIZE;
+            credits.take(slots);
+            iovec iov = {buf + off % BENCH_SEGMENT, bytes};
+            writeOrDie(fd, &iov, 1, bytes, off);
+            card.receive(slots);
+            off += bytes;
+            writes++;
+        }
+    }
+    report("tasks", count, size, writes, credits.m_stalls, nowNs() - start);
+}
+
+static void runBulk(int fd, uint8_t* buf, uint64_t depth, double rate, uint64_t count, uint64_t size, bool window)
+{
+    CardModel card{depth, rate};
+    Credits   credits{card};
+    uint64_t  half   = std::max<uint64_t>(depth / 2, 1);
+    uint64_t  writes = 0;
+
+    std::vector<iovec> iov;
+    card.m_last    = nowNs();
+    uint64_t start = card.m_last;
+    for (uint64_t i = 0; i < count; ++i) {
+        for (uint64_t off = 0; off < size;) {
+            uint64_t beats = window ? std::max(credits.free(), half) : half;
+            uint64_t bytes = std::min(beats * CHIMERA_DATA_BEAT_SIZE, size - off);
+
+            // the chunk as the bulk pool hands it out, in 4 KiB segments
+            iov.clear();
+            for (uint64_t done = 0; done < bytes;) {
+                uint64_t in  = (off + done) % BENCH_SEGMENT;
+                uint64_t len = std::min<uint64_t>(BENCH_SEGMENT - in, bytes - done);
+                iov.push_back({buf + in, len});
+                done += len;
+            }
+
+            uint64_t slots = bytes / CHIMERA_DATA_BEAT_SIZE;
+            credits.take(slots);
+            writeOrDie(fd, iov.data(), iov.size(), bytes, off);
+            card.receive(slots);
+            // the refresh the window asks for once the chunk is out
+            if (window) { credits.m_consumed = card.drain(); }
+            off += bytes;
+            writes++;
+        }
+    }
+    report(window ? "window" : "fixed", count, size, writes, credits.m_stalls, nowNs() - start);
+}
+
+int main(int argc, char** argv)
+{
+    std::string path  = argc > 1 ? argv[1] : "memfd";
+    uint64_t    depth = argc > 2 ? std::strtoull(argv[2], nullptr, 0) : 20;
+    double      mbps  = argc > 3 ? std::strtod(argv[3], nullptr) : 1000;
+    uint64_t    size  = argc > 4 ? std::strtoull(argv[4], nullptr, 0) : 1024 * 1024;
+    uint64_t    count = argc > 5 ? std::strtoull(argv[5], nullptr, 0) : 16;
+
+    size &= ~(uint64_t)(CHIMERA_DATA_BEAT_SIZE - 1);
+    if (depth == 0 || size == 0 || mbps <= 0) {
+        std::fprintf(stderr, "depth, drain rate and transfer size must be positive\n");
+        return 1;
+    }
+
+    int fd = path == "memfd" ? memfd_create("bulk_bench", 0) : open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+        std::perror(path.c_str());
+        return 1;
+    }
+    if (path == "memfd" && ftruncate(fd, size) < 0) {
+        std::perror("ftruncate");
+        return 1;
+    }
+
+    uint8_t* buf = static_cast<uint8_t*>(aligned_alloc(4096, BENCH_SEGMENT));
+    std::memset(buf, 0x5a, BENCH_SEGMENT);
+
+    // MB/s are bytes per microsecond
+    double rate = mbps / 1e3 / CHIMERA_DATA_BEAT_SIZE;
+    std::printf("%s: %lu transfers of %lu bytes, %lu slot input buffer draining %.0f MB/s\n", path.c_str(), count,
+                size, depth, mbps);
+    runTasks(fd, buf, depth, rate, count, size);
+    runBulk(fd, buf, depth, rate, count, size, false);
+    runBulk(fd, buf, depth, rate, count, size, true);
+
+    std::free(buf);
+    close(fd);
+    return 0;
+}
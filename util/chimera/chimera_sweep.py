@@ -0,0 +1,112 @@
+#!/usr/bin/env python3
+#
+# Sweeps the Chimera engine over task table sizes, batch sizes and payload
+# sizes with configs/example/chimera_bench.py, one gem5 run per point, and
+# prints one line per point:
+#
+#   tasks/s, MB/s  - from the ChimeraTrafficGen stats, in host time
+#   p50, p99       - latency of a task from the engine receiving it to its
+#                    response, or to its PCIe write without one, from the
+#                    taskLatency histogram the engine samples from the
+#                    LifeCycle of every task; within a bucket the latency
+#                    is interpolated, so they are as fine as the buckets
+#   tasks          - samples in that histogram
+#
+# Run from the top of the repository, e.g.
+#   util/chimera/chimera_sweep.py --gem5 build/ARM/gem5.opt \
+#       --tables 16,64 --batches 1,8 --payloads 8,64 -- --resp-percent=10
+# Arguments after "--" are handed to every run of chimera_bench.py.
+
+import argparse
+import os
+import re
+import subprocess
+import sys
+
+
+def int_list(text):
+    return [int(v) for v in text.split(",")]
+
+
+def read_stats(path):
+    stats = {}
+    with open(path) as f:
+        for line in f:
+            fields = line.split()
+            if len(fields) >= 2 and re.match(r"^[\w.]+$", fields[0]):
+                try:
+                    stats[fields[0]] = float(fields[1])
+                except ValueError:
+                    pass
+    return stats
+
+
+# buckets of every histogram named stat, as (low, high + 1, count); the
+# engines of a system are merged
+def read_histogram(path, stat):
+    bucket = re.compile(r"^[\w.]+\." + stat + r"::([0-9.e+]+)(?:-([0-9.e+]+))?$")
+    buckets = []
+    with open(path) as f:
+        for line in f:
+            fields = line.split()
+            match = bucket.match(fields[0]) if len(fields) >= 2 else None
+            if match:
+                low = float(match.group(1))
+                high = float(match.group(2) or match.group(1))
+                buckets.append((low, high + 1, float(fields[1])))
+    return sorted(buckets)
+
+
+def percentile(buckets, p):
+    total = sum(count for _, _, count in buckets)
+    if not total:
+        return float("nan")
+    rank = total * p / 100
+    for low, high, count in buckets:
+        if count and rank <= count:
+            return low + (high - low) * rank / count
+        rank -= count
+    return buckets[-1][1]
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--gem5", default="build/ARM/gem5.opt")
+    parser.add_argument("--config", default="configs/example/chimera_bench.py")
+    parser.add_argument("--outdir", default="m5out/chimera_sweep")
+    parser.add_argument("--tables", type=int_list, default=[16, 64, 128])
+    parser.add_argument("--batches", type=int_list, default=[1, 4, 15])
+    parser.add_argument("--payloads", type=int_list, default=[8, 32, 64])
+    parser.add_argument("bench_args", nargs="*")
+    args = parser.parse_args()
+
+    print("%6s %6s %8s %12s %10s %10s %10s %8s" % (
+        "tables", "batch", "payload", "tasks/s", "MB/s", "p50 us", "p99 us",
+        "tasks"))
+
+    for tables in args.tables:
+        for batch in args.batches:
+            for payload in args.payloads:
+                outdir = os.path.join(args.outdir, "t%d_b%d_p%d" % (
+                    tables, batch, payload))
+                cmd = [args.gem5, "-d", outdir, args.config,
+                       "--chimera-table-num=%d" % tables,
+                       "--chimera-batch-size=%d" % batch,
+                       "--payload-size=%d" % payload] + args.bench_args
+                if subprocess.run(cmd, stdout=subprocess.DEVNULL).returncode:
+                    sys.exit("run failed: %s" % " ".join(cmd))
+
+                path = os.path.join(outdir, "stats.txt")
+                stats = read_stats(path)
+                latencies = read_histogram(path, "taskLatency")
+                print("%6d %6d %8d %12.0f %10.1f %10.2f %10.2f %8d" % (
+                    tables, batch, payload,
+                    stats.get("system.tgen.tasksPerSecond", 0),
+                    stats.get("system.tgen.bytesPerSecond", 0) / 1e6,
+                    percentile(latencies, 50) / 1e3,
+                    percentile(latencies, 99) / 1e3,
+                    sum(count for _, _, count in latencies)))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,198 @@
+/*
+ * Microbenchmark for the hand-off queues used between the Chimera worker
+ * threads (src/fpga/chimera/ringBuffer.hh). It reports the cost of one
+ * hop in nanoseconds for:
+ *
+ *   pingpong  - one item bounced between two threads over two rings; the
+ *               round trip divided by two is the per-hop latency a single
+ *               outstanding task sees.
+ *   stream    - one producer, one consumer, many items in flight; the
+ *               time per item is the per-hop cost under load.
+ *   mpsc      - N producers into the MPSC ring used for idle table IDs.
+ *
+ * Each is run against the lock-free rings with the adaptive waiter and
+ * against the previous mutex + condition_variable hand-off.
+ *
+ * Build with "make" in this directory, run as
+ *   ./ring_bench [items] [producers]
+ */
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "fpga/chimera/ringBuffer.hh"
+#include "fpga/chimera/wait_policy.hh"
+
+using namespace gem5::fpga;
+using Clock = std::chrono::steady_clock;
+
+static double nsPer(Clock::time_point start, uint64_t count)
+{
+    return std::chrono::duration<double, std::nano>(Clock::now() - start).count() / count;
+}
+
+// the baseline: what Chimera used before, a queue guarded by a mutex and
+// a condition variable notified on every item
+template <typename T>
+class LockedQueue
+{
+  private:
+    std::deque<T>           m_queue;
+    std::mutex              m_mtx;
+    std::condition_variable m_cv;
+
+  public:
+    void push(const T& obj)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mtx);
+            m_queue.push_back(obj);
+        }
+        m_cv.notify_one();
+    }
+
+    T pop()
+    {
+        std::unique_lock<std::mutex> lock(m_mtx);
+        m_cv.wait(lock, [this] { return !m_queue.empty(); });
+        T obj = m_queue.front();
+        m_queue.pop_front();
+        return obj;
+    }
+};
+
+struct LockFreeChannel {
+    RingBuffer<uint64_t> m_ring;
+    AdaptiveWaiter       m_waiter;
+
+    LockFreeChannel(int depth) : m_ring(depth)
+    {
+    }
+
+    void push(uint64_t value)
+    {
+        while (!m_ring.enqueue(value)) { sched_yield(); }
+        m_waiter.notify();
+    }
+
+    uint64_t pop()
+    {
+        m_waiter.wait([this] { return !m_ring.isEmpty(); });
+        return m_ring.dequeue();
+    }
+};
+
+struct LockedChannel {
+    LockedQueue<uint64_t> m_queue;
+
+    LockedChannel(int depth)
+    {
+    }
+
+    void push(uint64_t value)
+    {
+        m_queue.push(value);
+    }
+
+    uint64_t pop()
+    {
+        return m_queue.pop();
+    }
+};
+
+template <typename Channel>
+static double pingpong(uint64_t count)
+{
+    Channel forward(64);
+    Channel backward(64);
+
+    std::thread echo([&] {
+        for (uint64_t i = 0; i < count; ++i) { backward.push(forward.pop()); }
+    });
+
+    auto start = Clock::now();
+    for (uint64_t i = 0; i < count; ++i) {
+        forward.push(i);
+        if (backward.pop() != i) { std::abort(); }
+    }
+    double result = nsPer(start, count * 2);
+    echo.join();
+    return result;
+}
+
+template <typename Channel>
+static double stream(uint64_t count)
+{
+    Channel channel(1024);
+
+    auto        start = Clock::now();
+    std::thread producer([&] {
+        for (uint64_t i = 0; i < count; ++i) { channel.push(i); }
+    });
+    for (uint64_t i = 0; i < count; ++i) {
+        if (channel.pop() != i) { std::abort(); }
+    }
+    double result = nsPer(start, count);
+    producer.join();
+    return result;
+}
+
+static double mpscLockFree(uint64_t count, int producers)
+{
+    MPSCRingBuffer<uint64_t> ring(1024);
+    AdaptiveWaiter           waiter;
+
+    auto                     start = Clock::now();
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; ++p) {
+        threads.emplace_back([&] {
+            for (uint64_t i = 0; i < count; ++i) {
+                while (!ring.enqueue(i)) { sched_yield(); }
+                waiter.notify();
+            }
+        });
+    }
+    for (uint64_t i = 0; i < count * producers; ++i) {
+        waiter.wait([&] { return !ring.isEmpty(); });
+        ring.dequeue();
+    }
+    double result = nsPer(start, count * producers);
+    for (auto& thread : threads) { thread.join(); }
+    return result;
+}
+
+static double mpscLocked(uint64_t count, int producers)
+{
+    LockedQueue<uint64_t> queue;
+
+    auto                     start = Clock::now();
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; ++p) {
+        threads.emplace_back([&] {
+            for (uint64_t i = 0; i < count; ++i) { queue.push(i); }
+        });
+    }
+    for (uint64_t i = 0; i < count * producers; ++i) { queue.pop(); }
+    double result = nsPer(start, count * producers);
+    for (auto& thread : threads) { thread.join(); }
+    return result;
+}
+
+int main(int argc, char* argv[])
+{
+    uint64_t count     = argc > 1 ? std::strtoull(argv[1], nullptr, 0) : 1000000;
+    int      producers = argc > 2 ? std::atoi(argv[2]) : 2;
+
+    std::printf("%-10s %14s %14s\n", "test", "lock-free(ns)", "mutex+cv(ns)");
+    std::printf("%-10s %14.1f %14.1f\n", "pingpong", pingpong<LockFreeChannel>(count),
+                pingpong<LockedChannel>(count));
+    std::printf("%-10s %14.1f %14.1f\n", "stream", stream<LockFreeChannel>(count), stream<LockedChannel>(count));
+    std::printf("%-10s %14.1f %14.1f\n", "mpsc", mpscLockFree(count, producers), mpscLocked(count, producers));
+    return 0;
+}
@@ -0,0 +1,147 @@
+/*
+ * Compares the blocking pwrite/pread path of the XDMA transport with the
+ * io_uring engine (src/fpga/chimera/uring_engine.hh) on one channel. For
+ * every mode it reports throughput and the mean time from issuing a
+ * transfer until its completion is seen:
+ *
+ *   blocking  - one pwrite (pread) per transfer, as XDMATransport does.
+ *   uring     - up to depth transfers in flight, ordered like a Chimera
+ *               channel (each starts after the previous one finished); the
+ *               transfers queued together go out as one linked chain.
+ *   unordered - the same without ordering, what the device could take if
+ *               the stream did not need to stay in order.
+ *
+ * Without a card it runs against a memfd (or a file given on the command
+ * line) standing in for the H2C/C2H node; pass /dev/xdma0_h2c_0 to measure
+ * the real driver.
+ *
+ * Build with "make" in this directory, run as
+ *   ./uring_bench [path|memfd] [transfers] [size] [depth]
+ */
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "fpga/chimera/uring_engine.hh"
+
+using namespace gem5::fpga;
+using Clock = std::chrono::steady_clock;
+
+// addresses wrap inside this window so the stand-in file stays small
+#define BENCH_WINDOW (64 * 1024 * 1024)
+
+static uint64_t nowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+}
+
+static void report(const char* mode, const char* dir, uint64_t count, uint64_t size, uint64_t elapsed,
+                   uint64_t latency)
+{
+    std::printf("%-10s %-5s %8.1f MB/s %10.0f ns/transfer %10.0f ns latency\n", mode, dir,
+                (double)count * size * 1e3 / elapsed, (double)elapsed / count, (double)latency / count);
+}
+
+static void runBlocking(int fd, uint8_t* buf, uint64_t count, uint64_t size, bool write)
+{
+    uint64_t start = nowNs();
+    for (uint64_t i = 0; i < count; ++i) {
+        uint64_t off = i * size % BENCH_WINDOW;
+        int64_t  ret = write ? pwrite(fd, buf, size, off) : pread(fd, buf, size, off);
+        if (ret != (int64_t)size) {
+            std::perror("blocking transfer");
+            std::exit(1);
+        }
+    }
+    uint64_t elapsed = nowNs() - start;
+    // a blocking transfer is complete when the call returns
+    report("blocking", write ? "write" : "read", count, size, elapsed, elapsed);
+}
+
+static void runUring(int fd, uint8_t* buf, uint64_t buf_size, uint64_t count, uint64_t size, unsigned depth,
+                     bool write, bool ordered)
+{
+    UringEngine ring;
+    if (!ring.init(depth)) {
+        std::printf("%-10s %-5s io_uring unavailable\n", ordered ? "uring" : "unordered", write ? "write" : "read");
+        return;
+    }
+    bool registered = ring.registerFiles({fd});
+    ring.registerBuffer(buf, buf_size);
+
+    std::vector<uint64_t>      issued(count);
+    std::vector<DMACompletion> done;
+    uint64_t                   submitted = 0, completed = 0, latency = 0;
+
+    uint64_t start = nowNs();
+    while (completed < count) {
+        while (submitted < count && submitted - completed < depth) {
+            uint64_t off  = submitted * size % BENCH_WINDOW;
+            // every in-flight transfer gets its own part of the buffer
+            uint8_t* data = buf + submitted % depth * size;
+            int      file = registered ? 0 : fd;
+            bool     ok   = write ? ring.prepWrite(file, data, size, off, submitted, ordered)
+                                  : ring.prepRead(file, data, size, off, submitted, ordered);
+            if (!ok) { break; }
+            issued[submitted++] = nowNs();
+        }
+        ring.submit();
+
+        done.clear();
+        if (ring.reap(done, 1) < 0) {
+            std::fprintf(stderr, "io_uring reap failed\n");
+            std::exit(1);
+        }
+        uint64_t now = nowNs();
+        for (const DMACompletion& c : done) {
+            if (c.m_result != (int64_t)size) {
+                std::fprintf(stderr, "io_uring transfer %lu failed: %ld\n", c.m_tag, c.m_result);
+                std::exit(1);
+            }
+            latency += now - issued[c.m_tag];
+        }
+        completed += done.size();
+    }
+    report(ordered ? "uring" : "unordered", write ? "write" : "read", count, size, nowNs() - start, latency);
+}
+
+int main(int argc, char** argv)
+{
+    std::string path  = argc > 1 ? argv[1] : "memfd";
+    uint64_t    count = argc > 2 ? std::strtoull(argv[2], nullptr, 0) : 200000;
+    uint64_t    size  = argc > 3 ? std::strtoull(argv[3], nullptr, 0) : 4096;
+    unsigned    depth = argc > 4 ? std::strtoul(argv[4], nullptr, 0) : 16;
+
+    int fd = path == "memfd" ? memfd_create("uring_bench", 0) : open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+        std::perror(path.c_str());
+        return 1;
+    }
+    if (path == "memfd" && ftruncate(fd, BENCH_WINDOW + size) < 0) {
+        std::perror("ftruncate");
+        return 1;
+    }
+
+    uint64_t bufSize = depth * size;
+    uint8_t* buf     = static_cast<uint8_t*>(aligned_alloc(4096, (bufSize + 4095) / 4096 * 4096));
+    std::memset(buf, 0x5a, bufSize);
+
+    std::printf("%s: %lu transfers of %lu bytes, depth %u\n", path.c_str(), count, size, depth);
+    for (bool write : {true, false}) {
+        runBlocking(fd, buf, count, size, write);
+        runUring(fd, buf, bufSize, count, size, depth, write, true);
+        runUring(fd, buf, bufSize, count, size, depth, write, false);
+    }
+
+    std::free(buf);
+    close(fd);
+    return 0;
+}